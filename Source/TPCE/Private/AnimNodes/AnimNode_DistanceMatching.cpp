@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNodes/AnimNode_DistanceMatching.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Curves/RichCurve.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "ExtraStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDistanceMatching, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("DistanceMatching Update"), STAT_DistanceMatching_Update, STATGROUP_Anim);
+
+/** Bisection steps used to invert the curve when baking, enough for float precision over any sensible sequence length. */
+static const int32 DistanceCurveBakeIterations = 24;
+
+/** Speed under which the character is considered stationary. */
+static const float DistanceMatchingStationarySpeed = 1.f;
+
+
+
+/// Lookup Table
+
+bool FDistanceCurveLookupTable::Bake(const FRichCurve& Curve, int32 NumSamples)
+{
+	Reset();
+
+	const TArray<FRichCurveKey>& Keys = Curve.GetConstRefOfKeys();
+	if (Keys.Num() < 2 || NumSamples < 2)
+		return false;
+
+	const float StartTime = Keys[0].Time;
+	const float EndTime = Keys.Last().Time;
+	const float StartValue = Curve.Eval(StartTime);
+	const float EndValue = Curve.Eval(EndTime);
+	if (FMath::IsNearlyEqual(StartValue, EndValue))
+		return false;
+
+	// Keys must be sorted in the same direction for the curve to be invertible
+	bIsIncreasing = EndValue > StartValue;
+	for (int32 KeyIndex = 1; KeyIndex < Keys.Num(); ++KeyIndex)
+	{
+		const float Delta = Keys[KeyIndex].Value - Keys[KeyIndex - 1].Value;
+		if (bIsIncreasing ? Delta < 0.f : Delta > 0.f)
+			return false;
+	}
+
+	MinValue = FMath::Min(StartValue, EndValue);
+	MaxValue = FMath::Max(StartValue, EndValue);
+	SamplesPerUnit = (NumSamples - 1) / (MaxValue - MinValue);
+
+	Times.SetNumUninitialized(NumSamples);
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		const float Value = MinValue + SampleIndex / SamplesPerUnit;
+
+		// Bisection rather than a key search so the curve interpolation mode is respected
+		float LowTime = StartTime;
+		float HighTime = EndTime;
+		for (int32 Iteration = 0; Iteration < DistanceCurveBakeIterations; ++Iteration)
+		{
+			const float MidTime = 0.5f * (LowTime + HighTime);
+			if ((Curve.Eval(MidTime) < Value) == bIsIncreasing)
+				LowTime = MidTime;
+			else
+				HighTime = MidTime;
+		}
+
+		Times[SampleIndex] = 0.5f * (LowTime + HighTime);
+	}
+
+	return true;
+}
+
+void FDistanceCurveLookupTable::Reset()
+{
+	Times.Reset();
+	MinValue = 0.f;
+	MaxValue = 0.f;
+	SamplesPerUnit = 0.f;
+	bIsIncreasing = true;
+}
+
+
+
+/// Anim Node
+
+FAnimNode_DistanceMatching::FAnimNode_DistanceMatching() :
+	Sequence(nullptr),
+	DistanceCurveName(TEXT("Distance")),
+	MatchingType(EDistanceMatchingType::Stop),
+	bUseMovementPrediction(true),
+	Distance(0.f),
+	PlayRate(1.f),
+	LookupTableSize(64),
+	BakedSequence(nullptr),
+	MovementDistance(0.f),
+	bHasMovementDistance(false),
+	MarkerLocation(FVector::ZeroVector),
+	bHasPivotLocation(false),
+	bReinitialized(false)
+{
+}
+
+float FAnimNode_DistanceMatching::GetCurrentAssetTime()
+{
+	return InternalTimeAccumulator;
+}
+
+float FAnimNode_DistanceMatching::GetCurrentAssetLength()
+{
+	return Sequence ? Sequence->SequenceLength : 0.f;
+}
+
+UAnimationAsset* FAnimNode_DistanceMatching::GetAnimAsset()
+{
+	return Sequence;
+}
+
+void FAnimNode_DistanceMatching::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_AssetPlayerBase::Initialize_AnyThread(Context);
+
+	EvaluateGraphExposedInputs.Execute(Context);
+	UpdateLookupTable();
+
+	InternalTimeAccumulator = 0.f;
+	MarkerLocation = FVector::ZeroVector;
+	bHasPivotLocation = false;
+	bReinitialized = true;
+}
+
+void FAnimNode_DistanceMatching::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	bHasMovementDistance = false;
+
+	const APawn* PawnOwner = InAnimInstance->TryGetPawnOwner();
+	const UExtCharacterMovementComponent* MovementComponent = PawnOwner ? Cast<UExtCharacterMovementComponent>(PawnOwner->GetMovementComponent()) : nullptr;
+
+	FExtLocomotionSnapshot Locomotion;
+	if (MovementComponent && MovementComponent->ReadLocomotionSnapshot(Locomotion))
+		bHasMovementDistance = GatherMovementDistance(Locomotion, MovementDistance);
+}
+
+bool FAnimNode_DistanceMatching::GatherMovementDistance(const FExtLocomotionSnapshot& Locomotion, float& OutDistance)
+{
+	const FVector& Location = Locomotion.Location;
+	const FVector& Velocity = Locomotion.Velocity;
+	const bool bIsStationary = Velocity.SizeSquared2D() < FMath::Square(DistanceMatchingStationarySpeed);
+	const bool bIsMovingOnGround = Locomotion.MovementMode == MOVE_Walking || Locomotion.MovementMode == MOVE_NavWalking;
+
+	switch (MatchingType)
+	{
+	case EDistanceMatchingType::Start:
+		// Distance is measured from the last location the character was standing at
+		if (bIsStationary)
+			MarkerLocation = Location;
+
+		OutDistance = (Location - MarkerLocation).Size2D();
+		return bIsMovingOnGround;
+
+	case EDistanceMatchingType::Stop:
+		if (bIsStationary)
+		{
+			OutDistance = 0.f;
+			return true;
+		}
+
+		// Only a character braking without input is stopping
+		if (!Locomotion.Acceleration.IsZero() || !Locomotion.bIsStopPredicted)
+			return false;
+
+		OutDistance = Locomotion.StopDistance;
+		return true;
+
+	case EDistanceMatchingType::Pivot:
+		// Approaching the pivot while input acceleration opposes velocity, the pivot being where velocity reverses
+		if (!bIsStationary && (Velocity | Locomotion.Acceleration) < 0.f && Locomotion.bIsStopPredicted)
+		{
+			MarkerLocation = Locomotion.StopLocation;
+			bHasPivotLocation = true;
+			OutDistance = -Locomotion.StopDistance;
+			return true;
+		}
+
+		// Past the pivot distance is measured from the last predicted pivot location
+		OutDistance = (Location - MarkerLocation).Size2D();
+		return bHasPivotLocation;
+
+	case EDistanceMatchingType::Landing:
+		if (bIsMovingOnGround)
+		{
+			OutDistance = 0.f;
+			return true;
+		}
+
+		if (!Locomotion.bIsLandingPredicted)
+			return false;
+
+		OutDistance = FMath::Max(0.f, Location.Z - Locomotion.LandingLocation.Z);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void FAnimNode_DistanceMatching::UpdateLookupTable()
+{
+	if (Sequence == BakedSequence)
+		return;
+
+	BakedSequence = Sequence;
+	LookupTable.Reset();
+
+	if (!Sequence)
+		return;
+
+	const FFloatCurve* DistanceCurve = Sequence->GetCurveData().FloatCurves.FindByPredicate([this](const FFloatCurve& Curve) { return Curve.Name.DisplayName == DistanceCurveName; });
+	if (!DistanceCurve)
+	{
+		UE_LOG(LogDistanceMatching, Warning, TEXT("Distance curve '%s' not found in %s."), *DistanceCurveName.ToString(), *GetNameSafe(Sequence));
+		return;
+	}
+
+	if (!LookupTable.Bake(DistanceCurve->FloatCurve, FMath::Clamp(LookupTableSize, 2, 1024)))
+		UE_LOG(LogDistanceMatching, Warning, TEXT("Distance curve '%s' in %s must have at least two keys with values sorted in a single direction."), *DistanceCurveName.ToString(), *GetNameSafe(Sequence));
+}
+
+void FAnimNode_DistanceMatching::UpdateAssetPlayer(const FAnimationUpdateContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DistanceMatching_Update);
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimNodes, FCharacterBenchmarkTimers::FindCharacterCycles(Context.AnimInstanceProxy));
+
+	EvaluateGraphExposedInputs.Execute(Context);
+
+	if (!Sequence || !Context.AnimInstanceProxy->IsSkeletonCompatible(Sequence->GetSkeleton()))
+		return;
+
+	UpdateLookupTable();
+
+	const float DeltaTime = Context.GetDeltaTime();
+	const float SequenceLength = Sequence->SequenceLength;
+	InternalTimeAccumulator = FMath::Clamp(InternalTimeAccumulator, 0.f, SequenceLength);
+
+	// Without a distance to match or once past the end of the curve the sequence just plays on
+	float TargetTime = InternalTimeAccumulator + DeltaTime * PlayRate;
+
+	const bool bHasDistance = bUseMovementPrediction ? bHasMovementDistance : true;
+	const float MatchedDistance = bUseMovementPrediction ? MovementDistance : Distance;
+	if (bHasDistance && LookupTable.IsValid() && !LookupTable.IsPastEnd(MatchedDistance))
+	{
+		// Predictions are noisy so time only moves forward after the first match
+		const float MatchedTime = LookupTable.GetTime(MatchedDistance);
+		TargetTime = bReinitialized ? MatchedTime : FMath::Max(InternalTimeAccumulator, MatchedTime);
+	}
+
+	TargetTime = FMath::Clamp(TargetTime, 0.f, SequenceLength);
+
+	if (bReinitialized)
+	{
+		InternalTimeAccumulator = TargetTime;
+		bReinitialized = false;
+	}
+
+	// Drive the tick record at the rate that reaches TargetTime so notifies and sync groups see the skipped range
+	const float TimeJump = TargetTime - InternalTimeAccumulator;
+	const float RateScale = Sequence->RateScale;
+	const float EffectivePlayRate = FMath::IsNearlyZero(DeltaTime) || FMath::IsNearlyZero(RateScale) ? 0.f : TimeJump / (DeltaTime * RateScale);
+	if (EffectivePlayRate == 0.f)
+		InternalTimeAccumulator = TargetTime;
+
+	CreateTickRecordForNode(Context, Sequence, false, EffectivePlayRate);
+}
+
+void FAnimNode_DistanceMatching::Evaluate_AnyThread(FPoseContext& Output)
+{
+	check(Output.AnimInstanceProxy != nullptr);
+
+	if (Sequence && Output.AnimInstanceProxy->IsSkeletonCompatible(Sequence->GetSkeleton()))
+		Sequence->GetAnimationPose(Output.Pose, Output.Curve, FAnimExtractContext(InternalTimeAccumulator, Output.AnimInstanceProxy->ShouldExtractRootMotion()));
+	else
+		Output.ResetToRefPose();
+}
+
+void FAnimNode_DistanceMatching::OverrideAsset(UAnimationAsset* NewAsset)
+{
+	if (UAnimSequenceBase* AnimSequence = Cast<UAnimSequenceBase>(NewAsset))
+		Sequence = AnimSequence;
+}
+
+void FAnimNode_DistanceMatching::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("('%s' Distance: %.1f Time: %.3f)"), *GetNameSafe(Sequence), bUseMovementPrediction ? MovementDistance : Distance, InternalTimeAccumulator);
+	DebugData.AddDebugItem(DebugLine, true);
+}
@@ -8,6 +8,7 @@
 #include "Engine/CollisionProfile.h"
 #include "SceneManagement.h"
 #include "AnimationRuntime.h"
+#include "ExtraStats.h"
 
 #if ENABLE_ANIM_DEBUG
 	#include "Async.h"
@@ -53,6 +54,7 @@ void FAnimNode_FootPlacement::GatherDebugData(FNodeDebugData & DebugData)
 void FAnimNode_FootPlacement::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
 {
 	SCOPE_CYCLE_COUNTER(STAT_FootPlacement_Eval);
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimNodes, FCharacterBenchmarkTimers::FindCharacterCycles(Output.AnimInstanceProxy));
 
 #if ENABLE_ANIM_DEBUG
 	check(Output.AnimInstanceProxy->GetSkelMeshComponent());
@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNodes/AnimNode_LeanAndBreathing.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Animation/ExtCharacterAnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Math/MathExtensions.h"
+#include "ExtraStats.h"
+
+TAutoConsoleVariable<int32> CVarAnimLeanAndBreathingEnable(TEXT("a.AnimNode.LeanAndBreathing.Enable"), 1, TEXT("Toggle LeanAndBreathing node."));
+
+DECLARE_CYCLE_STAT(TEXT("LeanAndBreathing Eval"), STAT_LeanAndBreathing_Eval, STATGROUP_Anim);
+
+/** Ground speed under which the character is considered to be resting. */
+static const float LeanAndBreathingRestingSpeed = 10.f;
+
+FAnimNode_LeanAndBreathing::FAnimNode_LeanAndBreathing() :
+	MaxLeanAngle(10.f),
+	MaxLeanAcceleration(2048.f),
+	LongitudinalLeanScale(0.5f),
+	WalkLeanScale(0.5f),
+	RunLeanScale(1.f),
+	SprintLeanScale(1.5f),
+	LeanInterpSpeed(5.f),
+	RestingBreathingRate(15.f),
+	ExertedBreathingRate(40.f),
+	RestingBreathingAngle(1.f),
+	ExertedBreathingAngle(3.f),
+	ExertionInterpSpeed(0.5f),
+	MaxBudgetLODLevel(0),
+	bHasLocomotion(false),
+	BudgetLODLevel(0),
+	CharacterToComponent(FQuat::Identity),
+	LastYaw(0.f),
+	bHasLastYaw(false),
+	CurrentLean(FVector2D::ZeroVector),
+	Exertion(0.f),
+	BreathingPhase(0.f)
+{
+}
+
+void FAnimNode_LeanAndBreathing::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	Super::Initialize_AnyThread(Context);
+
+	bHasLastYaw = false;
+	UpdateCounter.Reset();
+	CurrentLean = FVector2D::ZeroVector;
+}
+
+void FAnimNode_LeanAndBreathing::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	const UExtCharacterAnimInstance* ExtAnimInstance = Cast<UExtCharacterAnimInstance>(InAnimInstance);
+	BudgetLODLevel = ExtAnimInstance ? ExtAnimInstance->GetBudgetLODLevel() : 0;
+
+	const APawn* PawnOwner = InAnimInstance->TryGetPawnOwner();
+	const UExtCharacterMovementComponent* MovementComponent = PawnOwner ? Cast<UExtCharacterMovementComponent>(PawnOwner->GetMovementComponent()) : nullptr;
+	bHasLocomotion = MovementComponent && MovementComponent->ReadLocomotionSnapshot(Locomotion);
+
+	const USkeletalMeshComponent* Mesh = InAnimInstance->GetSkelMeshComponent();
+	if (bHasLocomotion && Mesh)
+		CharacterToComponent = Mesh->GetComponentQuat().Inverse() * Locomotion.Rotation.Quaternion();
+}
+
+void FAnimNode_LeanAndBreathing::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	Super::UpdateInternal(Context);
+
+	// The node is only updated while valid to evaluate, a yaw older than the previous frame would be taken as a sudden turn
+	if (!UpdateCounter.WasSynchronizedCounter(Context.AnimInstanceProxy->GetUpdateCounter()))
+		bHasLastYaw = false;
+	UpdateCounter.SynchronizeWith(Context.AnimInstanceProxy->GetUpdateCounter());
+
+	const float DeltaTime = Context.GetDeltaTime();
+	if (!bHasLocomotion || DeltaTime <= 0.f)
+		return;
+
+	const bool bIsOnGround = Locomotion.MovementMode == MOVE_Walking || Locomotion.MovementMode == MOVE_NavWalking;
+	const float GroundSpeed = Locomotion.Velocity.Size2D();
+	const bool bIsResting = !bIsOnGround || GroundSpeed < LeanAndBreathingRestingSpeed;
+
+	// Turning adds the centripetal acceleration of the current speed to the lateral acceleration
+	const float YawRate = bHasLastYaw ? FMath::DegreesToRadians(FMath::FindDeltaAngleDegrees(LastYaw, Locomotion.Rotation.Yaw)) / DeltaTime : 0.f;
+	LastYaw = Locomotion.Rotation.Yaw;
+	bHasLastYaw = true;
+
+	FVector2D TargetLean = FVector2D::ZeroVector;
+	if (!bIsResting && !Locomotion.bIsRagdoll && !Locomotion.bIsGettingUp)
+	{
+		float GaitLeanScale;
+		switch (Locomotion.Gait)
+		{
+		case ECharacterGait::Walk: GaitLeanScale = WalkLeanScale; break;
+		case ECharacterGait::Sprint: GaitLeanScale = SprintLeanScale; break;
+		default: GaitLeanScale = RunLeanScale; break;
+		}
+
+		const FVector LocalAcceleration = Locomotion.Rotation.UnrotateVector(Locomotion.Acceleration);
+		const float LateralAcceleration = LocalAcceleration.Y + GroundSpeed * YawRate;
+		const float Scale = MaxLeanAngle * GaitLeanScale / MaxLeanAcceleration;
+
+		// Leaning into acceleration is a positive roll to the right and a negative pitch forward
+		TargetLean.X = FMath::Clamp(LateralAcceleration * Scale, -FMath::Abs(MaxLeanAngle), FMath::Abs(MaxLeanAngle));
+		TargetLean.Y = FMath::Clamp(-LocalAcceleration.X * Scale * LongitudinalLeanScale, -FMath::Abs(MaxLeanAngle), FMath::Abs(MaxLeanAngle));
+	}
+
+	CurrentLean = FMathEx::Vector2DSafeInterpTo(CurrentLean, TargetLean, DeltaTime, LeanInterpSpeed);
+
+	float TargetExertion = 0.f;
+	if (!bIsResting)
+	{
+		switch (Locomotion.Gait)
+		{
+		case ECharacterGait::Walk: TargetExertion = 0.2f; break;
+		case ECharacterGait::Sprint: TargetExertion = 1.f; break;
+		default: TargetExertion = 0.5f; break;
+		}
+	}
+
+	Exertion = FMathEx::FSafeInterpTo(Exertion, TargetExertion, DeltaTime, ExertionInterpSpeed);
+
+	const float BreathingRate = FMath::Lerp(RestingBreathingRate, ExertedBreathingRate, Exertion);
+	BreathingPhase = FMath::Fmod(BreathingPhase + BreathingRate * (2.f * PI / 60.f) * DeltaTime, 2.f * PI);
+}
+
+void FAnimNode_LeanAndBreathing::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Lean Roll: %.1f Pitch: %.1f Exertion: %.2f)"), CurrentLean.X, CurrentLean.Y, Exertion);
+	DebugData.AddDebugItem(DebugLine);
+	ComponentPose.GatherDebugData(DebugData);
+}
+
+void FAnimNode_LeanAndBreathing::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LeanAndBreathing_Eval);
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimNodes, FCharacterBenchmarkTimers::FindCharacterCycles(Output.AnimInstanceProxy));
+
+	check(OutBoneTransforms.Num() == 0);
+
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+	const float Breathing = FMath::Sin(BreathingPhase) * 0.5f * FMath::Lerp(RestingBreathingAngle, ExertedBreathingAngle, Exertion);
+
+	// Each bone keeps its offset to the previous bone of the chain, so rotations accumulate from root to tip
+	FTransform PreviousOriginal = FTransform::Identity;
+	FTransform PreviousAdjusted = FTransform::Identity;
+	for (int32 Index = 0; Index < Bones.Num(); ++Index)
+	{
+		const FLeanAndBreathingBone& LeanBone = Bones[Index];
+		const FCompactPoseBoneIndex BoneIndex = LeanBone.Bone.GetCompactPoseIndex(BoneContainer);
+
+		const FTransform& Original = Output.Pose.GetComponentSpaceTransform(BoneIndex);
+		FTransform Adjusted = Index > 0 ? Original.GetRelativeTransform(PreviousOriginal) * PreviousAdjusted : Original;
+
+		// Rotations are in character space, roll around forward and pitch around right, converted to component space
+		const FQuat CharacterDelta = FRotator(CurrentLean.Y * LeanBone.LeanWeight + Breathing * LeanBone.BreathingWeight, 0.f, CurrentLean.X * LeanBone.LeanWeight).Quaternion();
+		const FQuat ComponentDelta = CharacterToComponent * CharacterDelta * CharacterToComponent.Inverse();
+		Adjusted.SetRotation((ComponentDelta * Adjusted.GetRotation()).GetNormalized());
+
+		OutBoneTransforms.Add(FBoneTransform(BoneIndex, Adjusted));
+
+		PreviousOriginal = Original;
+		PreviousAdjusted = Adjusted;
+	}
+}
+
+bool FAnimNode_LeanAndBreathing::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	bool bIsValid = (CVarAnimLeanAndBreathingEnable.GetValueOnAnyThread() != 0)
+		&& bHasLocomotion
+		&& BudgetLODLevel <= MaxBudgetLODLevel
+		&& Bones.Num() > 0;
+
+	// Bone transforms must be output parent first
+	int32 LastBoneIndex = INDEX_NONE;
+	for (int32 Index = 0; bIsValid && Index < Bones.Num(); ++Index)
+	{
+		bIsValid = Bones[Index].Bone.IsValidToEvaluate(RequiredBones);
+		if (bIsValid)
+		{
+			const int32 BoneIndex = Bones[Index].Bone.GetCompactPoseIndex(RequiredBones).GetInt();
+			bIsValid = BoneIndex > LastBoneIndex;
+			LastBoneIndex = BoneIndex;
+		}
+	}
+
+	return bIsValid;
+}
+
+void FAnimNode_LeanAndBreathing::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	for (FLeanAndBreathingBone& Each : Bones)
+	{
+		Each.Bone.Initialize(RequiredBones);
+	}
+}
@@ -3,6 +3,7 @@
 #include "AnimNodes/AnimNode_OrientationWarping.h"
 #include "AnimationRuntime.h"
 #include "Animation/AnimInstanceProxy.h"
+#include "ExtraStats.h"
 
 FAnimMode_OrientationWarping::FAnimMode_OrientationWarping()
 {
@@ -36,6 +37,9 @@ void FAnimMode_OrientationWarping::Evaluate_AnyThread(FPoseContext& Output)
 {
 	BasePose.Evaluate(Output);
 
+	// Only this node's own work is timed, the input pose is accounted for by its own nodes.
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimNodes, FCharacterBenchmarkTimers::FindCharacterCycles(Output.AnimInstanceProxy));
+
 	check(!FMath::IsNaN(LocomotionAngle) && FMath::IsFinite(LocomotionAngle));
 
 
@@ -6,6 +6,7 @@
 #include "Engine/Engine.h"
 #include "SceneManagement.h"
 #include "AnimationRuntime.h"
+#include "ExtraStats.h"
 
 TAutoConsoleVariable<int32> CVarAnimSpeedWarpingEnable(TEXT("a.AnimNode.SpeedWarping.Enable"), 1, TEXT("Toggle SpeedWarping node."));
 
@@ -36,6 +37,7 @@ void FAnimNode_SpeedWarping::GatherDebugData(FNodeDebugData & DebugData)
 void FAnimNode_SpeedWarping::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
 {
 	SCOPE_CYCLE_COUNTER(STAT_SpeedWarping_Eval);
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimNodes, FCharacterBenchmarkTimers::FindCharacterCycles(Output.AnimInstanceProxy));
 
 #if ENABLE_ANIM_DEBUG
 	check(Output.AnimInstanceProxy->GetSkelMeshComponent());
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Animation/AnimationSharingSetup.h"
+
+UAnimationSharingSetup::UAnimationSharingSetup()
+{
+	IdleSpeed = 10.f;
+	PromotionDistance = 1500.f;
+	PromotionSignificance = 2.f;
+}
+
+const FAnimationSharingStateSetup* UAnimationSharingSetup::FindState(EAnimationSharingState State) const
+{
+	return States.FindByPredicate([State](const FAnimationSharingStateSetup& StateSetup) { return StateSetup.State == State && StateSetup.Sequence; });
+}
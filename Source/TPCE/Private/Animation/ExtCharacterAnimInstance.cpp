@@ -1,17 +1,19 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Animation/ExtCharacterAnimInstance.h"
+#include "Animation/ExtCharacterAnimInstanceProxy.h"
+#include "Animation/ExtCharacterAnimSettings.h"
 #include "Animation/AnimNode_StateMachine.h"
 #include "Animation/BlendSpace.h"
 #include "GameFramework/ExtCharacter.h"
 #include "GameFramework/ExtCharacterMovementComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/MeshComponent.h"
-#include "Curves/CurveFloat.h"
 #include "Math/MathExtensions.h"
 #include "Kismet/Kismet.h"
 #include "DrawDebugHelpers.h"
 #include "ExtraMacros.h"
+#include "ExtraStats.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogExtCharacterAnimInstance, Log, All);
 
@@ -19,6 +21,10 @@ const float UExtCharacterAnimInstance::AngleTolerance = 1e-3f;
 
 UExtCharacterAnimInstance::UExtCharacterAnimInstance()
 {
+#if WITH_EDITORONLY_DATA
+	// Defaults of the legacy settings, saved values are deltas against them
+	MaxLocomotionUpdateGap = 0.25f;
+
 	AimOffsetInterpSpeed = 10.0f;
 	AimOffsetResetInterpSpeed = 2.0f;
 	RootBoneOffsetResetInterpSpeed = 5.0f;
@@ -36,6 +42,7 @@ UExtCharacterAnimInstance::UExtCharacterAnimInstance()
 
 	AnimWalkSpeedCrouched = 150.f;
 	AnimRunSpeedCrouched = 150.f;
+#endif // WITH_EDITORONLY_DATA
 
 	GaitScale = 0.f;
 	GaitScaleCrouched = 0.f;
@@ -44,10 +51,24 @@ UExtCharacterAnimInstance::UExtCharacterAnimInstance()
 	PlayRateWalkCrouched = 1.f;
 
 	SpeedWarpScale = 1.0f;
+
+	TimeToLand = -1.f;
+	LandingNormal = FVector::UpVector;
+
+	LocomotionUpdateElapsedTime = -1.f;
+	ServerAnimationMode = EDedicatedServerAnimationMode::Full;
+	BudgetLODLevel = 0;
+
+	LocomotionState = ELocomotionState::Idle;
+	LastLocomotionState = ELocomotionState::Idle;
+	LocomotionStateTime = 0.f;
 }
 
 void UExtCharacterAnimInstance::NativeInitializeAnimation()
 {
+	ActiveSettings = Settings ? Settings : GetMutableDefault<UExtCharacterAnimSettings>();
+	ActiveSettings->LoadCurves();
+
 	CharacterOwner = Cast<AExtCharacter>(TryGetPawnOwner());
 	if (IsValid(CharacterOwner))
 	{
@@ -63,6 +84,12 @@ void UExtCharacterAnimInstance::NativeInitializeAnimation()
 			CustomMovementMode = CharacterOwnerMovement->CustomMovementMode;
 		}
 
+		ServerAnimationMode = CharacterOwner->GetActiveServerAnimationMode();
+
+		// Movement may not have been updated yet, locomotion starts from the current state
+		if (IsValid(CharacterOwnerMovement) && !CharacterOwnerMovement->HasLocomotionSnapshot())
+			CharacterOwnerMovement->PublishLocomotionSnapshot();
+
 		Gait = CharacterOwner->GetGait();
 		bIsCrouched = CharacterOwner->bIsCrouched;
 		bIsPerformingGenericAction = CharacterOwner->bIsPerformingGenericAction;
@@ -79,135 +106,289 @@ void UExtCharacterAnimInstance::NativeInitializeAnimation()
 	}
 }
 
+void UExtCharacterAnimInstance::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Move legacy settings of anim blueprints into a settings object of their own, shared by all instances through the class default object
+	if (HasAnyFlags(RF_ClassDefaultObject) && !Settings)
+	{
+		const UExtCharacterAnimSettings* Defaults = GetDefault<UExtCharacterAnimSettings>();
+		const bool bHasLegacySettings = MaxLocomotionUpdateGap != Defaults->MaxLocomotionUpdateGap
+			|| AimOffsetInterpSpeed != Defaults->AimOffsetInterpSpeed
+			|| AimOffsetResetInterpSpeed != Defaults->AimOffsetResetInterpSpeed
+			|| RootBoneOffsetResetInterpSpeed != Defaults->RootBoneOffsetResetInterpSpeed
+			|| WalkSpeed != Defaults->WalkSpeed
+			|| RunSpeed != Defaults->RunSpeed
+			|| SprintSpeed != Defaults->SprintSpeed
+			|| WalkSpeedCrouched != Defaults->WalkSpeedCrouched
+			|| RunSpeedCrouched != Defaults->RunSpeedCrouched
+			|| AnimWalkSpeed != Defaults->AnimWalkSpeed
+			|| AnimRunSpeed != Defaults->AnimRunSpeed
+			|| AnimSprintSpeed != Defaults->AnimSprintSpeed
+			|| AnimWalkSpeedCrouched != Defaults->AnimWalkSpeedCrouched
+			|| AnimRunSpeedCrouched != Defaults->AnimRunSpeedCrouched
+			|| !TurnInPlaceLeftLongCurveNormal.IsNull()
+			|| !TurnInPlaceRightLongCurveNormal.IsNull()
+			|| !TurnInPlaceLeftShortCurveNormal.IsNull()
+			|| !TurnInPlaceRightShortCurveNormal.IsNull()
+			|| !TurnInPlaceLeftCurveLeftFootFwd.IsNull()
+			|| !TurnInPlaceRightCurveLeftFootFwd.IsNull()
+			|| !TurnInPlaceLeftCurveCrouched.IsNull()
+			|| !TurnInPlaceRightCurveCrouched.IsNull();
+
+		if (bHasLegacySettings)
+		{
+			// Outered to the package rather than the class default object, which is replaced whenever the blueprint is compiled
+			const FName SettingsName = MakeUniqueObjectName(GetOutermost(), UExtCharacterAnimSettings::StaticClass(), *FString::Printf(TEXT("%s_Settings"), *GetClass()->GetName()));
+			UExtCharacterAnimSettings* NewSettings = NewObject<UExtCharacterAnimSettings>(GetOutermost(), SettingsName, RF_Transactional);
+			NewSettings->MaxLocomotionUpdateGap = MaxLocomotionUpdateGap;
+			NewSettings->AimOffsetInterpSpeed = AimOffsetInterpSpeed;
+			NewSettings->AimOffsetResetInterpSpeed = AimOffsetResetInterpSpeed;
+			NewSettings->RootBoneOffsetResetInterpSpeed = RootBoneOffsetResetInterpSpeed;
+			NewSettings->WalkSpeed = WalkSpeed;
+			NewSettings->RunSpeed = RunSpeed;
+			NewSettings->SprintSpeed = SprintSpeed;
+			NewSettings->WalkSpeedCrouched = WalkSpeedCrouched;
+			NewSettings->RunSpeedCrouched = RunSpeedCrouched;
+			NewSettings->AnimWalkSpeed = AnimWalkSpeed;
+			NewSettings->AnimRunSpeed = AnimRunSpeed;
+			NewSettings->AnimSprintSpeed = AnimSprintSpeed;
+			NewSettings->AnimWalkSpeedCrouched = AnimWalkSpeedCrouched;
+			NewSettings->AnimRunSpeedCrouched = AnimRunSpeedCrouched;
+			NewSettings->TurnInPlaceLeftLongCurveNormal = TurnInPlaceLeftLongCurveNormal;
+			NewSettings->TurnInPlaceRightLongCurveNormal = TurnInPlaceRightLongCurveNormal;
+			NewSettings->TurnInPlaceLeftShortCurveNormal = TurnInPlaceLeftShortCurveNormal;
+			NewSettings->TurnInPlaceRightShortCurveNormal = TurnInPlaceRightShortCurveNormal;
+			NewSettings->TurnInPlaceLeftCurveLeftFootFwd = TurnInPlaceLeftCurveLeftFootFwd;
+			NewSettings->TurnInPlaceRightCurveLeftFootFwd = TurnInPlaceRightCurveLeftFootFwd;
+			NewSettings->TurnInPlaceLeftCurveCrouched = TurnInPlaceLeftCurveCrouched;
+			NewSettings->TurnInPlaceRightCurveCrouched = TurnInPlaceRightCurveCrouched;
+			Settings = NewSettings;
+
+			UE_LOG(LogExtCharacterAnimInstance, Log, TEXT("Moved legacy settings of %s into %s. Resave the asset to keep them."), *GetClass()->GetName(), *NewSettings->GetPathName());
+		}
+	}
+#endif // WITH_EDITORONLY_DATA
+}
+
+
+/// Anim Instance Proxy
+
+FAnimInstanceProxy* UExtCharacterAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FExtCharacterAnimInstanceProxy(this);
+}
+
+void UExtCharacterAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	delete static_cast<FExtCharacterAnimInstanceProxy*>(InProxy);
+}
+
+void UExtCharacterAnimInstance::ConsumeAnimationCost(double& OutSeconds, int32& OutNumUpdates)
+{
+	GetProxyOnGameThread<FExtCharacterAnimInstanceProxy>().ConsumeCost(OutSeconds, OutNumUpdates);
+}
+
+
 
 /// Every Tick
 
 void UExtCharacterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 {
-	if (IsValid(CharacterOwner)
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimUpdate, CharacterOwner ? &CharacterOwner->GetBenchmarkCycles() : nullptr);
+
+	FExtCharacterAnimInstanceInput& Input = GetProxyOnGameThread<FExtCharacterAnimInstanceProxy>().Input;
+
+	// Character and movement state are read from the snapshot published by the last movement update, never from the character itself.
+	// A sleeping character is idle so locomotion only needs updating until the root bone has settled.
+	// Root motion only servers just tick the pose for montages.
+	Input.bIsValid = IsValid(CharacterOwner)
 		&& IsValid(CharacterOwnerMovement)
 		&& IsValid(CharacterOwnerMesh)
-		&& DeltaSeconds > 0.0f)
+		&& DeltaSeconds > 0.0f
+		&& ServerAnimationMode != EDedicatedServerAnimationMode::RootMotionOnly
+		&& CharacterOwnerMovement->ReadLocomotionSnapshot(Input.Locomotion)
+		&& !(Input.Locomotion.bIsSleeping && RootBoneOffset.X == 0.0f);
+
+	// Sleep and invalid state skip locomotion updates so time is measured since the last one, the same span the mesh displacement is measured over.
+	// DeltaSeconds already spans frames skipped by update rate optimizations and includes the time dilation of the character, world time does not.
+	if (LocomotionUpdateElapsedTime >= 0.f)
+		LocomotionUpdateElapsedTime += DeltaSeconds;
+
+	if (Input.bIsValid)
 	{
-		LastSpeed = Speed;
-		LastGroundSpeed = GroundSpeed;
+		const bool bHasLastUpdate = LocomotionUpdateElapsedTime >= 0.f;
+		Input.ElapsedTime = bHasLastUpdate ? LocomotionUpdateElapsedTime : DeltaSeconds;
+		Input.bIsContinuous = bHasLastUpdate && (ActiveSettings->MaxLocomotionUpdateGap <= 0.f || Input.ElapsedTime <= ActiveSettings->MaxLocomotionUpdateGap);
+		LocomotionUpdateElapsedTime = 0.f;
 
-		const FTransform& CharacterMeshTransform = CharacterOwnerMesh->GetComponentTransform();
+		GatherLocomotionInput(Input);
 
-		
-		const FVector CharacterMeshLocation = CharacterOwnerMesh->GetComponentLocation();
-		const FVector CharacterMeshLocationDelta = (CharacterMeshLocation - LastCharacterMeshLocation).ProjectOnToNormal(CharacterOwnerMovement->Velocity.GetSafeNormal());
-		LastCharacterMeshLocation = CharacterMeshLocation;
+		// Turning in place samples the curves every update, sampling nothing while they stream would snap the turn animation to its start
+		if (!ActiveSettings->AreCurvesBaked() && (Input.Locomotion.TurnInPlaceState == ETurnInPlaceState::InProgress || bIsTurningInPlace || bIsRagdoll || bIsGettingUp))
+			ActiveSettings->LoadCurvesSynchronous();
 
-		const FVector LastVelocity = Velocity;
-		// In order to reduce sliding in simulated proxies we use a Velocity calculated from the mesh displacement since last frame.
-		Velocity = CharacterMeshLocationDelta / DeltaSeconds;
-		Acceleration = CharacterOwnerMovement->GetCurrentAcceleration();
+		Input.TurnInPlaceTables = ActiveSettings->GetTurnInPlaceTables();
 
-		Speed = Velocity.Size();
-		GroundSpeed = Velocity.Size2D();
+		LookAtActor = CharacterOwner->GetLookAtActor();
 
-		bWasMoving = bIsMoving;
-		bWasMoving2D = bIsMoving2D;
-		bIsMoving = Speed > 0.01f;
-		bIsMoving2D = GroundSpeed > 0.01f;
+		// State changes are detected here so events are raised in the game thread. Locomotion itself is updated by the proxy.
+		SetMovementMode(Input.Locomotion.MovementMode, Input.Locomotion.CustomMovementMode);
+		SetCrouched(Input.Locomotion.bIsCrouched);
+		SetGait(Input.Locomotion.Gait);
+		SetPerformingGenericAction(Input.Locomotion.bIsPerformingGenericAction);
 
-		bIsAccelerating = Acceleration.SizeSquared() > KINDA_SMALL_NUMBER;
+		RaiseEvents();
+	}
+}
 
-		if (bIsMoving2D)
-		{
-			LastMovementVelocity = Velocity;
-			LastMovementVelocityRotation = Velocity.Rotation();
-		}
+void UExtCharacterAnimInstance::GatherLocomotionInput(FExtCharacterAnimInstanceInput& Input) const
+{
+	// Input.Locomotion has already been read from the movement component. Only what movement does not publish is gathered here.
+	Input.MeshTransform = CharacterOwnerMesh->GetComponentTransform();
+	Input.BaseRotationOffset = CharacterOwner->GetBaseRotationOffset();
 
-		LastMovementAcceleration = CharacterOwnerMovement->LastMovementAcceleration;
-		LastMovementAccelerationRotation = LastMovementAcceleration.Rotation();
+	Input.bSkipVisualLocomotion = ServerAnimationMode != EDedicatedServerAnimationMode::Full;
+	Input.bEnableFootIK = Input.Locomotion.bEnableFootIK && BudgetLODLevel == 0 && !Input.bSkipVisualLocomotion;
 
-		bIsJumping = CharacterOwner->bIsJumping;
+	const AActor* LookAt = CharacterOwner->GetLookAtActor();
+	Input.bHasLookAtActor = IsValid(LookAt);
+	Input.LookAtLocation = Input.bHasLookAtActor ? LookAt->GetActorLocation() : FVector::ZeroVector;
 
-		bWasRagdoll = bIsRagdoll;
-		bIsRagdoll = CharacterOwner->IsRagdoll();
+	// Bone transforms are only needed in ragdoll, where they come from physics rather than the anim graph.
+	if (Input.Locomotion.bIsRagdoll)
+	{
+		Input.PelvisRotation = CharacterOwnerMesh->GetSocketQuaternion(CharacterOwner->GetPelvisBoneName());
+		CharacterOwnerMesh->GetSocketWorldLocationAndRotation(CharacterOwner->GetLeftFootBoneName(), Input.LeftFootLocation, Input.LeftFootRotation);
+		CharacterOwnerMesh->GetSocketWorldLocationAndRotation(CharacterOwner->GetRightFootBoneName(), Input.RightFootLocation, Input.RightFootRotation);
+	}
+}
 
-		bWasGettingUp = bIsGettingUp;
-		bIsGettingUp = CharacterOwner->IsGettingUp();
+void UExtCharacterAnimInstance::NativeThreadSafeUpdateLocomotion(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds)
+{
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(AnimUpdate, CharacterOwner ? &CharacterOwner->GetBenchmarkCycles() : nullptr);
 
-		RotationMode = CharacterOwner->GetRotationMode();
+	LastSpeed = Speed;
+	LastGroundSpeed = GroundSpeed;
 
-		LastCharacterLocation = CharacterLocation;
-		LastCharacterRotation = CharacterRotation;
+	const FVector CharacterMeshLocation = Input.MeshTransform.GetLocation();
+	const FVector CharacterMeshLocationDelta = (CharacterMeshLocation - LastCharacterMeshLocation).ProjectOnToNormal(Input.Locomotion.Velocity.GetSafeNormal());
+	LastCharacterMeshLocation = CharacterMeshLocation;
 
-		CharacterLocation = CharacterOwner->GetActorLocation();
-		CharacterRotation = CharacterOwner->GetActorRotation();
+	// In order to reduce sliding in simulated proxies we use a Velocity calculated from the mesh displacement since the last update.
+	// After a long gap the displacement no longer describes the current motion so the movement component velocity is used instead.
+	const FVector LastVelocity = Input.bIsContinuous ? Velocity : Input.Locomotion.Velocity;
+	Velocity = Input.bIsContinuous ? CharacterMeshLocationDelta / DeltaSeconds : Input.Locomotion.Velocity;
+	Acceleration = Input.Locomotion.Acceleration;
 
-		// We have to recalculate drift (rather than using the one calculated by the character movement component)
-		// because we use a velocity that is calculated out of mesh displacement
-		const FRotator MeshOrientation = (RootBoneRotation * CharacterOwner->GetBaseRotationOffset().Inverse()).Rotator();
-		MovementDrift = FMath::FindDeltaAngleDegrees(MeshOrientation.Yaw, LastMovementVelocityRotation.Yaw);
-		
-		LookRotation = CharacterOwner->GetLookRotation();
-		LookDelta = (LookRotation - CharacterRotation).GetNormalized();
-		LookAtActor = CharacterOwner->GetLookAtActor();
+	Speed = Velocity.Size();
+	GroundSpeed = Velocity.Size2D();
 
-		GetUpDelay = CharacterOwner->GetUpDelay;
+	bWasMoving = bIsMoving;
+	bWasMoving2D = bIsMoving2D;
+	bIsMoving = Speed > 0.01f;
+	bIsMoving2D = GroundSpeed > 0.01f;
 
-		SetMovementMode(CharacterOwnerMovement->MovementMode, CharacterOwnerMovement->CustomMovementMode);
-		SetCrouched(CharacterOwner->bIsCrouched);
-		SetGait(CharacterOwner->GetGait());
-		SetPerformingGenericAction(CharacterOwner->bIsPerformingGenericAction);
+	bIsAccelerating = Acceleration.SizeSquared() > KINDA_SMALL_NUMBER;
 
-		// Enable Foot IK only if enabled by the character, not ragdoll and moving on ground.
-		bEnableFootIK = CharacterOwner->bEnableFootIK && !bIsRagdoll && (MovementMode == MOVE_Walking || MovementMode == MOVE_NavWalking);
+	if (bIsMoving2D)
+	{
+		LastMovementVelocity = Velocity;
+		LastMovementVelocityRotation = Velocity.Rotation();
+	}
 
-		if (bIsRagdoll)
-		{
-			if (MovementMode != MOVE_None && MovementMode != MOVE_Falling)
-			{
-				// Find if the ragdoll is facing up or down. 
-				const FQuat PelvisQuat = CharacterOwnerMesh->GetSocketQuaternion(CharacterOwner->GetPelvisBoneName());
-				// Pelvis bone is assumed to be oriented Y-Fwd/X-Up so the right vector is the actual forward.
-				bIsRagdollFacingDown = FVector::DotProduct(FVector::UpVector, PelvisQuat.GetRightVector()) < 0.0f;
-				// In a ragdoll the capsule can rotate freely but we have to make sure the root bone is pointing in the right direction for the get up animation.
-				// If the character is lying on its back the root bone must point to the feet but if the character is facing down the root bone must point to the head.
-				RootBoneRotation = (bIsRagdollFacingDown ? FQuat(0.f, 0.f, -COS_45, COS_45) * PelvisQuat : FQuat(0.f, 0.f, COS_45, COS_45) * PelvisQuat);
-				// Root bone is assumed to be oriented Y-Fwd/Z-Up so we have to fix the desired rotation by -90deg to align the Y-Axis to foward. Only then we can convert to component space.
-				RootBoneOffset.X = CharacterOwnerMesh->GetComponentTransform().InverseTransformRotation(RootBoneRotation).Rotator().Yaw;
-			}
+	LastMovementAcceleration = Input.Locomotion.LastMovementAcceleration;
+	LastMovementAccelerationRotation = LastMovementAcceleration.Rotation();
+
+	bIsJumping = Input.Locomotion.bIsJumping;
+
+	bWasRagdoll = bIsRagdoll;
+	bIsRagdoll = Input.Locomotion.bIsRagdoll;
+
+	bWasGettingUp = bIsGettingUp;
+	bIsGettingUp = Input.Locomotion.bIsGettingUp;
+
+	RotationMode = Input.Locomotion.RotationMode;
 
-			// Calculate IK bone locations for better blending out of ragdoll
-			CharacterOwnerMesh->GetSocketWorldLocationAndRotation(CharacterOwner->GetLeftFootBoneName(), RagdollLeftFootLocation, RagdollLeftFootRotation);
-			CharacterOwnerMesh->GetSocketWorldLocationAndRotation(CharacterOwner->GetRightFootBoneName(), RagdollRightFootLocation, RagdollRightFootRotation);
+	LastCharacterLocation = Input.bIsContinuous ? CharacterLocation : Input.Locomotion.Location;
+	LastCharacterRotation = Input.bIsContinuous ? CharacterRotation : Input.Locomotion.Rotation;
 
-			// Reset Aim Offset
-			AimOffset = FVector2D(0.f, 0.f);
+	CharacterLocation = Input.Locomotion.Location;
+	CharacterRotation = Input.Locomotion.Rotation;
+
+	// We have to recalculate drift (rather than using the one calculated by the character movement component)
+	// because we use a velocity that is calculated out of mesh displacement
+	const FRotator MeshOrientation = (RootBoneRotation * Input.BaseRotationOffset.Inverse()).Rotator();
+	MovementDrift = FMath::FindDeltaAngleDegrees(MeshOrientation.Yaw, LastMovementVelocityRotation.Yaw);
+
+	LookRotation = Input.Locomotion.LookRotation;
+	LookDelta = (LookRotation - CharacterRotation).GetNormalized();
+
+	GetUpDelay = Input.Locomotion.GetUpDelay;
+
+	bIsLandingPredicted = Input.Locomotion.bIsLandingPredicted;
+	TimeToLand = Input.Locomotion.TimeToLand;
+	LandingNormal = Input.Locomotion.LandingNormal;
+
+	// Enable Foot IK only if enabled by the character, not ragdoll and moving on ground.
+	bEnableFootIK = Input.bEnableFootIK && !bIsRagdoll && (MovementMode == MOVE_Walking || MovementMode == MOVE_NavWalking);
+
+	if (bIsRagdoll)
+	{
+		if (MovementMode != MOVE_None && MovementMode != MOVE_Falling)
+		{
+			// Find if the ragdoll is facing up or down. 
+			const FQuat& PelvisQuat = Input.PelvisRotation;
+			// Pelvis bone is assumed to be oriented Y-Fwd/X-Up so the right vector is the actual forward.
+			bIsRagdollFacingDown = FVector::DotProduct(FVector::UpVector, PelvisQuat.GetRightVector()) < 0.0f;
+			// In a ragdoll the capsule can rotate freely but we have to make sure the root bone is pointing in the right direction for the get up animation.
+			// If the character is lying on its back the root bone must point to the feet but if the character is facing down the root bone must point to the head.
+			RootBoneRotation = (bIsRagdollFacingDown ? FQuat(0.f, 0.f, -COS_45, COS_45) * PelvisQuat : FQuat(0.f, 0.f, COS_45, COS_45) * PelvisQuat);
+			// Root bone is assumed to be oriented Y-Fwd/Z-Up so we have to fix the desired rotation by -90deg to align the Y-Axis to foward. Only then we can convert to component space.
+			RootBoneOffset.X = Input.MeshTransform.InverseTransformRotation(RootBoneRotation).Rotator().Yaw;
 		}
-		else
+
+		// IK bone locations for better blending out of ragdoll
+		RagdollLeftFootLocation = Input.LeftFootLocation;
+		RagdollLeftFootRotation = Input.LeftFootRotation;
+		RagdollRightFootLocation = Input.RightFootLocation;
+		RagdollRightFootRotation = Input.RightFootRotation;
+
+		// Reset Aim Offset
+		AimOffset = FVector2D(0.f, 0.f);
+	}
+	else
+	{
+		if (!bIsGettingUp)
 		{
-			// FRotator TurnRotation = (Mesh->GetComponentQuat() * Character->GetBaseRotationOffset().Inverse()).Rotator();
-			if (!bIsGettingUp)
-			{
-				// Update root bone rotation smoothly.
-				{ 
-					if (RootBoneOffset.X < -AngleTolerance || RootBoneOffset.X > AngleTolerance)
-					{
-						RootBoneOffset.X = FMathEx::FInterpConstantAngleTo(RootBoneOffset.X, 0.0f, DeltaSeconds, 180.f);
-						RootBoneRotation = CharacterOwnerMesh->GetComponentTransform().TransformRotation(FQuat(FVector::UpVector, FMath::DegreesToRadians(RootBoneOffset.X)));
-					}
-					else
-					{
-						RootBoneOffset.X = 0.0f;
-						RootBoneRotation = CharacterOwnerMesh->GetComponentQuat();
-					}
+			// Update root bone rotation smoothly.
+			{ 
+				if (RootBoneOffset.X < -AngleTolerance || RootBoneOffset.X > AngleTolerance)
+				{
+					RootBoneOffset.X = FMathEx::FInterpConstantAngleTo(RootBoneOffset.X, 0.0f, DeltaSeconds, 180.f);
+					RootBoneRotation = Input.MeshTransform.TransformRotation(FQuat(FVector::UpVector, FMath::DegreesToRadians(RootBoneOffset.X)));
 				}
+				else
+				{
+					RootBoneOffset.X = 0.0f;
+					RootBoneRotation = Input.MeshTransform.GetRotation();
+				}
+			}
 
-				NativeUpdateGaitScale(DeltaSeconds);
-				NativeUpdatePivotTurn(LastVelocity, DeltaSeconds);
-				NativeUpdateTurnInPlace(DeltaSeconds);
-				NativeUpdateAimOffset(DeltaSeconds);
+			// Gait and aim offset shape the pose used for hit detection, pivot and turn in place only how feet look
+			NativeUpdateGaitScale(DeltaSeconds);
+			if (!Input.bSkipVisualLocomotion)
+			{
+				NativeUpdatePivotTurn(Input, LastVelocity, DeltaSeconds);
+				NativeUpdateTurnInPlace(Input, DeltaSeconds);
 			}
+			NativeUpdateAimOffset(Input, DeltaSeconds);
 		}
-
-		RaiseEvents();
 	}
+
+	NativeUpdateLocomotionState(DeltaSeconds);
 }
 
 void UExtCharacterAnimInstance::NativeUpdateGaitScale(float DeltaSeconds)
@@ -222,21 +403,21 @@ void UExtCharacterAnimInstance::NativeUpdateGaitScale(float DeltaSeconds)
 			if (bIsCrouched)
 			{
 				float AnimSpeedScale;
-				if (GroundSpeed <= WalkSpeedCrouched)
+				if (GroundSpeed <= ActiveSettings->WalkSpeedCrouched)
 				{
-					GaitScaleCrouched = FMath::GetRangePct(FVector2D(0.f, WalkSpeedCrouched), GroundSpeed);
-					AnimSpeedScale = GroundSpeed / AnimWalkSpeedCrouched;
+					GaitScaleCrouched = FMath::GetRangePct(FVector2D(0.f, ActiveSettings->WalkSpeedCrouched), GroundSpeed);
+					AnimSpeedScale = GroundSpeed / ActiveSettings->AnimWalkSpeedCrouched;
 				}
-				else if (GroundSpeed <= RunSpeedCrouched)
+				else if (GroundSpeed <= ActiveSettings->RunSpeedCrouched)
 				{
-					const float Alpha = FMath::GetRangePct(FVector2D(WalkSpeedCrouched, RunSpeedCrouched), GroundSpeed);
+					const float Alpha = FMath::GetRangePct(FVector2D(ActiveSettings->WalkSpeedCrouched, ActiveSettings->RunSpeedCrouched), GroundSpeed);
 					GaitScaleCrouched = 1.0f + Alpha;
-					AnimSpeedScale = GroundSpeed / FMath::Lerp(AnimWalkSpeedCrouched, AnimRunSpeedCrouched, Alpha);
+					AnimSpeedScale = GroundSpeed / FMath::Lerp(ActiveSettings->AnimWalkSpeedCrouched, ActiveSettings->AnimRunSpeedCrouched, Alpha);
 				}
 				else
 				{
 					GaitScaleCrouched = 2.0f;
-					AnimSpeedScale = GroundSpeed / AnimRunSpeedCrouched;
+					AnimSpeedScale = GroundSpeed / ActiveSettings->AnimRunSpeedCrouched;
 				}
 
 				if (AnimSpeedScale < 1.0f)
@@ -257,27 +438,27 @@ void UExtCharacterAnimInstance::NativeUpdateGaitScale(float DeltaSeconds)
 			else
 			{
 				float AnimSpeedScale;
-				if (GroundSpeed <= WalkSpeed)
+				if (GroundSpeed <= ActiveSettings->WalkSpeed)
 				{
-					GaitScale = FMath::GetRangePct(FVector2D(0.f, WalkSpeed), GroundSpeed);
-					AnimSpeedScale = GroundSpeed / AnimWalkSpeed;
+					GaitScale = FMath::GetRangePct(FVector2D(0.f, ActiveSettings->WalkSpeed), GroundSpeed);
+					AnimSpeedScale = GroundSpeed / ActiveSettings->AnimWalkSpeed;
 				}
-				else if (GroundSpeed <= RunSpeed)
+				else if (GroundSpeed <= ActiveSettings->RunSpeed)
 				{
-					const float Alpha = FMath::GetRangePct(FVector2D(WalkSpeed, RunSpeed), GroundSpeed);
+					const float Alpha = FMath::GetRangePct(FVector2D(ActiveSettings->WalkSpeed, ActiveSettings->RunSpeed), GroundSpeed);
 					GaitScale = 1.0f + Alpha;
-					AnimSpeedScale = GroundSpeed / FMath::Lerp(AnimWalkSpeed, AnimRunSpeed, Alpha);
+					AnimSpeedScale = GroundSpeed / FMath::Lerp(ActiveSettings->AnimWalkSpeed, ActiveSettings->AnimRunSpeed, Alpha);
 				}
-				else if (GroundSpeed <= SprintSpeed)
+				else if (GroundSpeed <= ActiveSettings->SprintSpeed)
 				{
-					const float Alpha = FMath::GetRangePct(FVector2D(RunSpeed, SprintSpeed), GroundSpeed);
+					const float Alpha = FMath::GetRangePct(FVector2D(ActiveSettings->RunSpeed, ActiveSettings->SprintSpeed), GroundSpeed);
 					GaitScale = 2.0f + Alpha;
-					AnimSpeedScale = GroundSpeed / FMath::Lerp(AnimRunSpeed, AnimSprintSpeed, Alpha);
+					AnimSpeedScale = GroundSpeed / FMath::Lerp(ActiveSettings->AnimRunSpeed, ActiveSettings->AnimSprintSpeed, Alpha);
 				}
 				else
 				{
 					GaitScale = 3.0f;
-					AnimSpeedScale = GroundSpeed / AnimSprintSpeed;
+					AnimSpeedScale = GroundSpeed / ActiveSettings->AnimSprintSpeed;
 				}
 
 				if (AnimSpeedScale < 1.0f)
@@ -302,11 +483,11 @@ void UExtCharacterAnimInstance::NativeUpdateGaitScale(float DeltaSeconds)
 	}
 }
 
-void UExtCharacterAnimInstance::NativeUpdatePivotTurn(const FVector& InLastVelocity, float DeltaSeconds)
+void UExtCharacterAnimInstance::NativeUpdatePivotTurn(const FExtCharacterAnimInstanceInput& Input, const FVector& InLastVelocity, float DeltaSeconds)
 {
 	bool bIsPivotTurningInstantly = false;
 	bWasPivotTurning = bIsPivotTurning;
-	bIsPivotTurning = CharacterOwnerMovement->IsPivotTurning();
+	bIsPivotTurning = Input.Locomotion.bIsPivotTurning;
 
 	if (!bIsPivotTurning)
 	{
@@ -336,12 +517,12 @@ void UExtCharacterAnimInstance::NativeUpdatePivotTurn(const FVector& InLastVeloc
 	}
 }
 
-void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(float DeltaSeconds)
+void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds)
 {
 	bWasTurningInPlace = bIsTurningInPlace;
 	bWasTurningInPlaceRight = bIsTurningInPlaceRight;
 
-	const ETurnInPlaceState TurnInPlaceState = CharacterOwnerMovement->GetTurnInPlaceState();
+	const ETurnInPlaceState TurnInPlaceState = Input.Locomotion.TurnInPlaceState;
 
 	if (((bWasRagdoll && !bIsRagdoll) || bWasGettingUp) && !bIsMoving && MovementMode != MOVE_None && MovementMode != MOVE_Falling)
 	{
@@ -357,7 +538,7 @@ void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(float DeltaSeconds)
 		const float PreviousTurnInPlaceTargetYaw = TurnInPlaceTargetYaw;
 
 		if (TurnInPlaceState == ETurnInPlaceState::InProgress)
-			TurnInPlaceTargetYaw = CharacterOwnerMovement->GetTurnInPlaceTargetYaw();
+			TurnInPlaceTargetYaw = Input.Locomotion.TurnInPlaceTargetYaw;
 
 		const float TurnInPlaceDelta = FMath::FindDeltaAngleDegrees(LastCharacterRotation.Yaw, CharacterRotation.Yaw);
 		if (TurnInPlaceDelta < -AngleTolerance)
@@ -365,7 +546,7 @@ void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(float DeltaSeconds)
 		else if (TurnInPlaceDelta > AngleTolerance)
 			bIsTurningInPlaceRight = true;
 
-		float TargetDeltaRemaining = TurnInPlaceTargetYaw - (RootBoneRotation * CharacterOwner->GetBaseRotationOffset().Inverse()).Rotator().Yaw;
+		float TargetDeltaRemaining = TurnInPlaceTargetYaw - (RootBoneRotation * Input.BaseRotationOffset.Inverse()).Rotator().Yaw;
 
 		if (FMath::IsNearlyZero(FMath::UnwindDegrees(TargetDeltaRemaining), AngleTolerance))
 			bIsTurningInPlace = false;
@@ -396,19 +577,19 @@ void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(float DeltaSeconds)
 				if (bIsCrouched)
 				{
 					bIsTurnInPlaceLong = false;
-					TurnInPlaceRightAnimPositionCrouched = TurnInPlaceRightCurveCrouched ? TurnInPlaceRightCurveCrouched->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+					TurnInPlaceRightAnimPositionCrouched = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::RightCrouched, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 				else if (bIsPerformingGenericAction)
 				{
 					bIsTurnInPlaceLong = false;
-					TurnInPlaceRightAnimPositionLeftFootFwd = TurnInPlaceRightCurveLeftFootFwd ? TurnInPlaceRightCurveLeftFootFwd->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+					TurnInPlaceRightAnimPositionLeftFootFwd = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::RightLeftFootFwd, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 				else
 				{
 					if (bIsTurnInPlaceLong)
-						TurnInPlaceRightLongAnimPositionNormal = TurnInPlaceRightLongCurveNormal ? TurnInPlaceRightLongCurveNormal->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 180.0f)) : 0.f;
+						TurnInPlaceRightLongAnimPositionNormal = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::RightLongNormal, FMath::Fmod(TargetDeltaRemaining, 180.0f));
 					else
-						TurnInPlaceRightShortAnimPositionNormal = TurnInPlaceRightShortCurveNormal ? TurnInPlaceRightShortCurveNormal->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+						TurnInPlaceRightShortAnimPositionNormal = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::RightShortNormal, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 			}
 			else
@@ -436,33 +617,33 @@ void UExtCharacterAnimInstance::NativeUpdateTurnInPlace(float DeltaSeconds)
 				if (bIsCrouched)
 				{
 					bIsTurnInPlaceLong = false;
-					TurnInPlaceLeftAnimPositionCrouched = TurnInPlaceLeftCurveCrouched ? TurnInPlaceLeftCurveCrouched->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+					TurnInPlaceLeftAnimPositionCrouched = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::LeftCrouched, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 				else if (bIsPerformingGenericAction)
 				{
 					bIsTurnInPlaceLong = false;
-					TurnInPlaceLeftAnimPositionLeftFootFwd = TurnInPlaceLeftCurveLeftFootFwd ? TurnInPlaceLeftCurveLeftFootFwd->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+					TurnInPlaceLeftAnimPositionLeftFootFwd = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::LeftLeftFootFwd, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 				else
 				{
 					if (bIsTurnInPlaceLong)
-						TurnInPlaceLeftLongAnimPositionNormal = TurnInPlaceLeftLongCurveNormal ? TurnInPlaceLeftLongCurveNormal->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 180.0f)) : 0.f;
+						TurnInPlaceLeftLongAnimPositionNormal = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::LeftLongNormal, FMath::Fmod(TargetDeltaRemaining, 180.0f));
 					else
-						TurnInPlaceLeftShortAnimPositionNormal = TurnInPlaceLeftShortCurveNormal ? TurnInPlaceLeftShortCurveNormal->GetFloatValue(FMath::Fmod(TargetDeltaRemaining, 90.0f)) : 0.f;
+						TurnInPlaceLeftShortAnimPositionNormal = Input.GetTurnInPlaceValue(ETurnInPlaceCurve::LeftShortNormal, FMath::Fmod(TargetDeltaRemaining, 90.0f));
 				}
 			}
 		}
 	}
 }
 
-void UExtCharacterAnimInstance::NativeUpdateAimOffset(float DeltaSeconds)
+void UExtCharacterAnimInstance::NativeUpdateAimOffset(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds)
 {
 	if (MovementMode != MOVE_None && (MovementMode != MOVE_Falling || bIsJumping))
 	{
-		if (IsValid(LookAtActor))
+		if (Input.bHasLookAtActor)
 		{
-			const FRotator Delta = FRotationMatrix::MakeFromX(LookAtActor->GetActorLocation() - CharacterLocation).Rotator();
-			AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(Delta.Yaw, bIsJumping && Velocity.Z < 0.f ? Delta.Pitch - 60.f : Delta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, AimOffsetInterpSpeed);
+			const FRotator Delta = FRotationMatrix::MakeFromX(Input.LookAtLocation - CharacterLocation).Rotator();
+			AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(Delta.Yaw, bIsJumping && Velocity.Z < 0.f ? Delta.Pitch - 60.f : Delta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, ActiveSettings->AimOffsetInterpSpeed);
 		}
 		else
 		{
@@ -473,13 +654,13 @@ void UExtCharacterAnimInstance::NativeUpdateAimOffset(float DeltaSeconds)
 				{
 					// Look in the direction of Movement Input.
 					const FRotator Delta = (LastMovementAccelerationRotation - CharacterRotation).GetNormalized();
-					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(Delta.Yaw, bIsJumping && Velocity.Z < 0.f ? Delta.Pitch - 60.f : Delta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, AimOffsetInterpSpeed);
+					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(Delta.Yaw, bIsJumping && Velocity.Z < 0.f ? Delta.Pitch - 60.f : Delta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, ActiveSettings->AimOffsetInterpSpeed);
 					break;
 				}
 				else if (bIsMoving)
 				{
 					// Look in the direction of Movement.
-					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(MovementDrift, bIsJumping && Velocity.Z < 0.f ? LookDelta.Pitch - 60.f : LookDelta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, AimOffsetInterpSpeed);
+					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(MovementDrift, bIsJumping && Velocity.Z < 0.f ? LookDelta.Pitch - 60.f : LookDelta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, ActiveSettings->AimOffsetInterpSpeed);
 					break;
 				}
 				goto ResetAimOffset;
@@ -487,7 +668,7 @@ void UExtCharacterAnimInstance::NativeUpdateAimOffset(float DeltaSeconds)
 				if (true) // NoOp: the if will be optimized away, it's just to make the editor indent the block corretly.
 				{
 					// Use the Look Rotation
-					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(LookDelta.Yaw, bIsJumping && Velocity.Z < 0.f ? LookDelta.Pitch - 60.f : LookDelta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, AimOffsetInterpSpeed);
+					AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D(LookDelta.Yaw, bIsJumping && Velocity.Z < 0.f ? LookDelta.Pitch - 60.f : LookDelta.Pitch).ClampAxes(-90.f, 90.f), DeltaSeconds, ActiveSettings->AimOffsetInterpSpeed);
 					break;
 				}
 			default: goto ResetAimOffset;
@@ -497,7 +678,7 @@ void UExtCharacterAnimInstance::NativeUpdateAimOffset(float DeltaSeconds)
 	else
 	{
 	ResetAimOffset:
-		AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D::ZeroVector, DeltaSeconds, AimOffsetResetInterpSpeed);
+		AimOffset = FMathEx::Vector2DSafeInterpTo(AimOffset, FVector2D::ZeroVector, DeltaSeconds, ActiveSettings->AimOffsetResetInterpSpeed);
 	}
 }
 
@@ -507,7 +688,7 @@ void UExtCharacterAnimInstance::RaiseEvents()
 	{
 		bHasMovementModeChanged = false;
 
-		if (!bIsRagdoll)
+		if (!CharacterOwner->IsRagdoll())
 			StopAllMontages(0.1f);
 
 		OnMovementModeChanged();
@@ -533,6 +714,131 @@ void UExtCharacterAnimInstance::RaiseEvents()
 }
 
 
+/// Locomotion State Machine
+
+/** Conditions tested by the locomotion state transitions. Gathered once per update so each transition is tested with two mask compares. */
+namespace ELocomotionCondition
+{
+	enum Type : uint32
+	{
+		None = 0,
+		OnGround = 1 << 0,
+		InAir = 1 << 1,
+		Jumping = 1 << 2,
+		Descending = 1 << 3,
+		Accelerating = 1 << 4,
+		Moving = 1 << 5,
+		PivotTurning = 1 << 6,
+		TurningInPlace = 1 << 7,
+		/** Shortest time of the current state has elapsed, only Start and Land have one. */
+		MinTimeElapsed = 1 << 8
+	};
+}
+
+static constexpr uint32 LocomotionStateBit(ELocomotionState State)
+{
+	return 1u << (uint32)State;
+}
+
+/** Transition of the locomotion state machine. */
+struct FLocomotionStateTransition
+{
+	/** States the transition leaves from, one bit per ELocomotionState. */
+	uint32 FromStates;
+
+	ELocomotionState ToState;
+
+	/** Conditions that must all be met. */
+	uint32 RequiredConditions;
+
+	/** Conditions that must all be unmet. */
+	uint32 ForbiddenConditions;
+};
+
+static constexpr uint32 GroundLocomotionStates =
+	LocomotionStateBit(ELocomotionState::Idle) | LocomotionStateBit(ELocomotionState::Start) | LocomotionStateBit(ELocomotionState::Cycle) | LocomotionStateBit(ELocomotionState::Stop) |
+	LocomotionStateBit(ELocomotionState::Pivot) | LocomotionStateBit(ELocomotionState::TurnInPlace) | LocomotionStateBit(ELocomotionState::Land);
+
+static constexpr uint32 AirLocomotionStates = LocomotionStateBit(ELocomotionState::Jump) | LocomotionStateBit(ELocomotionState::Fall);
+
+/** Transitions in priority order. Only the first transition leaving the current state with its conditions met is taken in an update. */
+static const FLocomotionStateTransition LocomotionStateTransitions[] =
+{
+	{ GroundLocomotionStates, ELocomotionState::Jump, ELocomotionCondition::InAir | ELocomotionCondition::Jumping, ELocomotionCondition::Descending },
+	{ GroundLocomotionStates, ELocomotionState::Fall, ELocomotionCondition::InAir, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::Jump), ELocomotionState::Fall, ELocomotionCondition::InAir | ELocomotionCondition::Descending, ELocomotionCondition::None },
+	{ AirLocomotionStates, ELocomotionState::Land, ELocomotionCondition::OnGround, ELocomotionCondition::None },
+
+	{ LocomotionStateBit(ELocomotionState::Land), ELocomotionState::Cycle, ELocomotionCondition::MinTimeElapsed | ELocomotionCondition::Accelerating, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::Land), ELocomotionState::Stop, ELocomotionCondition::MinTimeElapsed | ELocomotionCondition::Moving, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::Land), ELocomotionState::Idle, ELocomotionCondition::MinTimeElapsed, ELocomotionCondition::None },
+
+	{ LocomotionStateBit(ELocomotionState::Idle), ELocomotionState::TurnInPlace, ELocomotionCondition::TurningInPlace, ELocomotionCondition::Accelerating },
+	{ LocomotionStateBit(ELocomotionState::Idle) | LocomotionStateBit(ELocomotionState::TurnInPlace) | LocomotionStateBit(ELocomotionState::Stop), ELocomotionState::Start, ELocomotionCondition::Accelerating, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::TurnInPlace), ELocomotionState::Idle, ELocomotionCondition::None, ELocomotionCondition::TurningInPlace },
+
+	{ LocomotionStateBit(ELocomotionState::Start) | LocomotionStateBit(ELocomotionState::Cycle), ELocomotionState::Pivot, ELocomotionCondition::PivotTurning, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::Start) | LocomotionStateBit(ELocomotionState::Cycle) | LocomotionStateBit(ELocomotionState::Pivot), ELocomotionState::Stop, ELocomotionCondition::None, ELocomotionCondition::Accelerating | ELocomotionCondition::PivotTurning },
+	{ LocomotionStateBit(ELocomotionState::Start), ELocomotionState::Cycle, ELocomotionCondition::MinTimeElapsed, ELocomotionCondition::None },
+	{ LocomotionStateBit(ELocomotionState::Pivot), ELocomotionState::Cycle, ELocomotionCondition::None, ELocomotionCondition::PivotTurning },
+	{ LocomotionStateBit(ELocomotionState::Stop), ELocomotionState::Idle, ELocomotionCondition::None, ELocomotionCondition::Moving },
+};
+
+void UExtCharacterAnimInstance::NativeUpdateLocomotionState(float DeltaSeconds)
+{
+	bHasLocomotionStateChanged = false;
+	LocomotionStateTime += DeltaSeconds;
+
+	// Ragdoll and get up are played on top of locomotion, which starts over from idle once they are done
+	if (bIsRagdoll || bIsGettingUp)
+	{
+		SetLocomotionState(ELocomotionState::Idle);
+		return;
+	}
+
+	float MinStateTime;
+	switch (LocomotionState)
+	{
+	case ELocomotionState::Start: MinStateTime = ActiveSettings->StartStateDuration; break;
+	case ELocomotionState::Land: MinStateTime = ActiveSettings->LandStateDuration; break;
+	default: MinStateTime = 0.f; break;
+	}
+
+	// Only walking and falling drive transitions, in any other movement mode the state is kept
+	uint32 Conditions = ELocomotionCondition::None;
+	if (MovementMode == MOVE_Walking || MovementMode == MOVE_NavWalking)
+		Conditions |= ELocomotionCondition::OnGround;
+	else if (MovementMode == MOVE_Falling)
+		Conditions |= ELocomotionCondition::InAir;
+	if (bIsJumping)
+		Conditions |= ELocomotionCondition::Jumping;
+	if (Velocity.Z <= 0.f)
+		Conditions |= ELocomotionCondition::Descending;
+	if (bIsAccelerating)
+		Conditions |= ELocomotionCondition::Accelerating;
+	if (bIsMoving2D)
+		Conditions |= ELocomotionCondition::Moving;
+	if (bIsPivotTurning)
+		Conditions |= ELocomotionCondition::PivotTurning;
+	if (bIsTurningInPlace)
+		Conditions |= ELocomotionCondition::TurningInPlace;
+	if (LocomotionStateTime >= MinStateTime)
+		Conditions |= ELocomotionCondition::MinTimeElapsed;
+
+	const uint32 StateBit = LocomotionStateBit(LocomotionState);
+	for (const FLocomotionStateTransition& Transition : LocomotionStateTransitions)
+	{
+		if ((Transition.FromStates & StateBit) != 0
+			&& (Conditions & Transition.RequiredConditions) == Transition.RequiredConditions
+			&& (Conditions & Transition.ForbiddenConditions) == 0)
+		{
+			SetLocomotionState(Transition.ToState);
+			break;
+		}
+	}
+}
+
+
 /// Setters
 
 void UExtCharacterAnimInstance::SetMovementMode(const EMovementMode Value, const uint8 CustomValue)
@@ -572,6 +878,17 @@ void UExtCharacterAnimInstance::SetPerformingGenericAction(const bool Value)
 	}
 }
 
+void UExtCharacterAnimInstance::SetLocomotionState(const ELocomotionState Value)
+{
+	if (LocomotionState != Value)
+	{
+		LastLocomotionState = LocomotionState;
+		LocomotionState = Value;
+		LocomotionStateTime = 0.f;
+		bHasLocomotionStateChanged = true;
+	}
+}
+
 
 /// Handlers
 
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Animation/ExtCharacterAnimInstanceProxy.h"
+#include "Animation/ExtCharacterAnimInstance.h"
+
+FExtCharacterAnimInstanceProxy::FExtCharacterAnimInstanceProxy(UAnimInstance* InAnimInstance) :
+	FAnimInstanceProxy(InAnimInstance),
+	ExtAnimInstance(nullptr),
+	CostCycles(0),
+	CostNumUpdates(0)
+{
+}
+
+void FExtCharacterAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+
+	ExtAnimInstance = Cast<UExtCharacterAnimInstance>(InAnimInstance);
+}
+
+void FExtCharacterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	// Locomotion is stepped by the time since its last update which may span several frames
+	if (ExtAnimInstance && Input.bIsValid && Input.ElapsedTime > 0.0f)
+		ExtAnimInstance->NativeThreadSafeUpdateLocomotion(Input, Input.ElapsedTime);
+}
+
+void FExtCharacterAnimInstanceProxy::UpdateAnimationNode(float DeltaSeconds)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	FAnimInstanceProxy::UpdateAnimationNode(DeltaSeconds);
+
+	CostCycles += FPlatformTime::Cycles() - StartCycles;
+	++CostNumUpdates;
+}
+
+void FExtCharacterAnimInstanceProxy::EvaluateAnimationNode(FPoseContext& Output)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	FAnimInstanceProxy::EvaluateAnimationNode(Output);
+
+	CostCycles += FPlatformTime::Cycles() - StartCycles;
+}
+
+void FExtCharacterAnimInstanceProxy::ConsumeCost(double& OutSeconds, int32& OutNumUpdates)
+{
+	// Update and evaluation of the previous frame have completed by the time the game thread gets the proxy
+	OutSeconds = FPlatformTime::ToSeconds64(CostCycles);
+	OutNumUpdates = CostNumUpdates;
+
+	CostCycles = 0;
+	CostNumUpdates = 0;
+}
@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Animation/ExtCharacterAnimSettings.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/StreamableManager.h"
+
+/** Streams the curves of all anim settings. */
+static FStreamableManager& GetCurveStreamableManager()
+{
+	static FStreamableManager StreamableManager;
+	return StreamableManager;
+}
+
+
+
+/// Sample Table
+
+bool FCurveSampleTable::Bake(const FRichCurve& Curve, int32 NumSamples)
+{
+	Reset();
+
+	if (Curve.GetNumKeys() == 0 || NumSamples < 2)
+		return false;
+
+	float MaxTime;
+	Curve.GetTimeRange(MinTime, MaxTime);
+	SamplesPerUnit = MaxTime > MinTime ? (NumSamples - 1) / (MaxTime - MinTime) : 0.f;
+
+	// A curve with a single key is constant, all samples take its value
+	Values.SetNumUninitialized(NumSamples);
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		Values[SampleIndex] = Curve.Eval(SamplesPerUnit > 0.f ? MinTime + SampleIndex / SamplesPerUnit : MinTime);
+	}
+
+	return true;
+}
+
+void FCurveSampleTable::Reset()
+{
+	Values.Reset();
+	MinTime = 0.f;
+	SamplesPerUnit = 0.f;
+}
+
+
+
+/// Settings
+
+UExtCharacterAnimSettings::UExtCharacterAnimSettings()
+{
+	MaxLocomotionUpdateGap = 0.25f;
+
+	AimOffsetInterpSpeed = 10.0f;
+	AimOffsetResetInterpSpeed = 2.0f;
+	RootBoneOffsetResetInterpSpeed = 5.0f;
+
+	WalkSpeed = 165.f;
+	RunSpeed = 375.f;
+	SprintSpeed = 600.f;
+
+	WalkSpeedCrouched = 150.f;
+	RunSpeedCrouched = 200.f;
+
+	AnimWalkSpeed = 150.f;
+	AnimRunSpeed = 375.f;
+	AnimSprintSpeed = 600.f;
+
+	AnimWalkSpeedCrouched = 150.f;
+	AnimRunSpeedCrouched = 150.f;
+
+	StartStateDuration = 0.2f;
+	LandStateDuration = 0.15f;
+
+	CurveTableSize = 128;
+}
+
+void UExtCharacterAnimSettings::BeginDestroy()
+{
+	if (CurvesHandle.IsValid())
+	{
+		CurvesHandle->CancelHandle();
+		CurvesHandle.Reset();
+	}
+
+	Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UExtCharacterAnimSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Curves are baked again the next time an anim instance is initialized with these settings. Anim updates in flight keep the old tables.
+	if (CurvesHandle.IsValid())
+	{
+		CurvesHandle->CancelHandle();
+		CurvesHandle.Reset();
+	}
+
+	TurnInPlaceTables.Reset();
+	bAreCurvesRequested = false;
+}
+#endif
+
+const TSoftObjectPtr<UCurveFloat>& UExtCharacterAnimSettings::GetTurnInPlaceCurve(ETurnInPlaceCurve Curve) const
+{
+	switch (Curve)
+	{
+	case ETurnInPlaceCurve::LeftLongNormal: return TurnInPlaceLeftLongCurveNormal;
+	case ETurnInPlaceCurve::RightLongNormal: return TurnInPlaceRightLongCurveNormal;
+	case ETurnInPlaceCurve::LeftShortNormal: return TurnInPlaceLeftShortCurveNormal;
+	case ETurnInPlaceCurve::RightShortNormal: return TurnInPlaceRightShortCurveNormal;
+	case ETurnInPlaceCurve::LeftLeftFootFwd: return TurnInPlaceLeftCurveLeftFootFwd;
+	case ETurnInPlaceCurve::RightLeftFootFwd: return TurnInPlaceRightCurveLeftFootFwd;
+	case ETurnInPlaceCurve::LeftCrouched: return TurnInPlaceLeftCurveCrouched;
+	default: return TurnInPlaceRightCurveCrouched;
+	}
+}
+
+void UExtCharacterAnimSettings::LoadCurves()
+{
+	if (bAreCurvesRequested)
+		return;
+
+	bAreCurvesRequested = true;
+
+	TArray<FSoftObjectPath> CurvePaths;
+	for (int32 Index = 0; Index < (int32)ETurnInPlaceCurve::Count; ++Index)
+	{
+		const TSoftObjectPtr<UCurveFloat>& Curve = GetTurnInPlaceCurve((ETurnInPlaceCurve)Index);
+		if (!Curve.IsNull())
+			CurvePaths.AddUnique(Curve.ToSoftObjectPath());
+	}
+
+	if (CurvePaths.Num() == 0)
+	{
+		BakeCurves();
+		return;
+	}
+
+	// The delegate may run immediately if every curve is already loaded, in which case the handle is not kept
+	TSharedPtr<FStreamableHandle> Handle = GetCurveStreamableManager().RequestAsyncLoad(CurvePaths, FStreamableDelegate::CreateUObject(this, &UExtCharacterAnimSettings::BakeCurves));
+	if (!AreCurvesBaked())
+		CurvesHandle = Handle;
+}
+
+void UExtCharacterAnimSettings::LoadCurvesSynchronous()
+{
+	if (AreCurvesBaked())
+		return;
+
+	bAreCurvesRequested = true;
+
+	if (CurvesHandle.IsValid())
+	{
+		CurvesHandle->CancelHandle();
+		CurvesHandle.Reset();
+	}
+
+	for (int32 Index = 0; Index < (int32)ETurnInPlaceCurve::Count; ++Index)
+	{
+		const TSoftObjectPtr<UCurveFloat>& Curve = GetTurnInPlaceCurve((ETurnInPlaceCurve)Index);
+		if (!Curve.IsNull())
+			Curve.LoadSynchronous();
+	}
+
+	BakeCurves();
+}
+
+void UExtCharacterAnimSettings::BakeCurves()
+{
+	const int32 NumSamples = FMath::Clamp(CurveTableSize, 2, 1024);
+	TSharedRef<FTurnInPlaceCurveTables, ESPMode::ThreadSafe> NewTables = MakeShared<FTurnInPlaceCurveTables, ESPMode::ThreadSafe>();
+	for (int32 Index = 0; Index < (int32)ETurnInPlaceCurve::Count; ++Index)
+	{
+		if (const UCurveFloat* Curve = GetTurnInPlaceCurve((ETurnInPlaceCurve)Index).Get())
+			NewTables->Tables[Index].Bake(Curve->FloatCurve, NumSamples);
+	}
+
+	// Tables handed to anim updates are never rewritten, the new ones are picked up by the next update
+	TurnInPlaceTables = NewTables;
+
+	// Only the tables are sampled from now on so the curves can be unloaded
+	CurvesHandle.Reset();
+}
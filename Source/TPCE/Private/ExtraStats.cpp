@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ExtraStats.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/ExtCharacter.h"
+
+bool FCharacterBenchmarkTimers::bEnabled = false;
+
+volatile int64 FCharacterBenchmarkTimers::Cycles[(int32)ECharacterBenchmarkSystem::Count] = { 0 };
+
+void FCharacterBenchmarkTimers::Reset()
+{
+	for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+	{
+		FPlatformAtomics::InterlockedExchange(&Cycles[Index], 0);
+	}
+}
+
+double FCharacterBenchmarkTimers::GetMilliseconds(ECharacterBenchmarkSystem System)
+{
+	return FPlatformTime::ToMilliseconds64(Cycles[(int32)System]);
+}
+
+FCharacterBenchmarkCycles* FCharacterBenchmarkTimers::FindCharacterCycles(const FAnimInstanceProxy* AnimInstanceProxy)
+{
+	const USkeletalMeshComponent* Mesh = AnimInstanceProxy ? AnimInstanceProxy->GetSkelMeshComponent() : nullptr;
+	const AExtCharacter* Character = Mesh ? Cast<AExtCharacter>(Mesh->GetOwner()) : nullptr;
+	return Character ? &Character->GetBenchmarkCycles() : nullptr;
+}
+
+void FCharacterBenchmarkCycles::Reset()
+{
+	for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+	{
+		FPlatformAtomics::InterlockedExchange(&Cycles[Index], 0);
+	}
+}
+
+double FCharacterBenchmarkCycles::GetMilliseconds(ECharacterBenchmarkSystem System) const
+{
+	return FPlatformTime::ToMilliseconds64(Cycles[(int32)System]);
+}
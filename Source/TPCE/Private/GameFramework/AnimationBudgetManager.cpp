@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/AnimationBudgetManager.h"
+#include "GameFramework/ExtCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "Animation/ExtCharacterAnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("AnimationBudget"), STATGROUP_AnimationBudget, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("AnimationBudget Tick"), STAT_AnimationBudget_Tick, STATGROUP_AnimationBudget);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AnimationBudget Budget (ms)"), STAT_AnimationBudget_BudgetMs, STATGROUP_AnimationBudget);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AnimationBudget Used (ms)"), STAT_AnimationBudget_UsedMs, STATGROUP_AnimationBudget);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AnimationBudget Estimated (ms)"), STAT_AnimationBudget_EstimatedMs, STATGROUP_AnimationBudget);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AnimationBudget Update Cost (ms)"), STAT_AnimationBudget_UpdateCostMs, STATGROUP_AnimationBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationBudget Registered"), STAT_AnimationBudget_Registered, STATGROUP_AnimationBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationBudget Full Rate"), STAT_AnimationBudget_FullRate, STATGROUP_AnimationBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationBudget Reduced"), STAT_AnimationBudget_Reduced, STATGROUP_AnimationBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationBudget Not Ticked"), STAT_AnimationBudget_NotTicked, STATGROUP_AnimationBudget);
+
+TAutoConsoleVariable<int32> CVarAnimationBudgetEnable(TEXT("a.AnimationBudget.Enable"), 1, TEXT("Toggle the animation budget. Disabled characters are animated every frame.\n"), ECVF_Default);
+TAutoConsoleVariable<float> CVarAnimationBudgetMs(TEXT("a.AnimationBudget.BudgetMs"), 1.f, TEXT("Milliseconds per frame to spend animating budgeted characters.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarAnimationBudgetMaxUpdateRate(TEXT("a.AnimationBudget.MaxUpdateRate"), 8, TEXT("Largest number of frames between anim updates of a character that keeps ticking.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarAnimationBudgetInterpolate(TEXT("a.AnimationBudget.Interpolate"), 1, TEXT("Toggle interpolation of skipped frames for visible characters.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarAnimationBudgetAllowTickDisable(TEXT("a.AnimationBudget.AllowTickDisable"), 1, TEXT("Allow the budget to stop ticking the mesh of characters out of view.\n"), ECVF_Default);
+TAutoConsoleVariable<float> CVarAnimationBudgetSignificanceDistance(TEXT("a.AnimationBudget.SignificanceDistance"), 1000.f, TEXT("Distance to the closest view at which a character has half of its significance.\n"), ECVF_Default);
+TAutoConsoleVariable<float> CVarAnimationBudgetNotRenderedSignificance(TEXT("a.AnimationBudget.NotRenderedSignificance"), 0.1f, TEXT("Scale applied to the significance of characters that have not been rendered recently.\n"), ECVF_Default);
+
+/** Time in seconds since the last render for a mesh to be considered visible. */
+static const float AnimationBudgetVisibilityTolerance = 0.2f;
+
+/** Weight of the last frame measure in the smoothed update cost. */
+static const float AnimationBudgetCostSmoothing = 0.1f;
+
+AAnimationBudgetManager::AAnimationBudgetManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+
+	AverageUpdateCostMs = 0.f;
+	UsedMs = 0.f;
+	EstimatedMs = 0.f;
+}
+
+AAnimationBudgetManager* AAnimationBudgetManager::Get(UWorld* World)
+{
+	if (!World)
+		return nullptr;
+
+	for (TActorIterator<AAnimationBudgetManager> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+			return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<AAnimationBudgetManager>(SpawnParams);
+}
+
+void AAnimationBudgetManager::Register(AExtCharacter* Character)
+{
+	check(Character);
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	if (!Mesh || Entries.ContainsByPredicate([Character](const FAnimationBudgetEntry& Entry) { return Entry.Character == Character; }))
+		return;
+
+	FAnimationBudgetEntry& Entry = Entries[Entries.AddDefaulted()];
+	Entry.Character = Character;
+
+	Mesh->PrimaryComponentTick.AddPrerequisite(this, PrimaryActorTick);
+}
+
+void AAnimationBudgetManager::Unregister(AExtCharacter* Character)
+{
+	check(Character);
+
+	const int32 Index = Entries.IndexOfByPredicate([Character](const FAnimationBudgetEntry& Entry) { return Entry.Character == Character; });
+	if (Index == INDEX_NONE)
+		return;
+
+	ResetBudget(Entries[Index]);
+	Entries.RemoveAtSwap(Index);
+
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+		Mesh->PrimaryComponentTick.RemovePrerequisite(this, PrimaryActorTick);
+}
+
+void AAnimationBudgetManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimationBudget_Tick);
+
+	Super::Tick(DeltaSeconds);
+
+	const bool bEnabled = CVarAnimationBudgetEnable.GetValueOnGameThread() != 0;
+	const float BudgetMs = FMath::Max(CVarAnimationBudgetMs.GetValueOnGameThread(), 0.f);
+	const int32 MaxUpdateRate = FMath::Clamp(CVarAnimationBudgetMaxUpdateRate.GetValueOnGameThread(), 1, 60);
+
+	// Significance is relative to the closest local view
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	// Measure what animating the characters cost in the last frame and score them for this one
+	double UsedSeconds = 0.0;
+	int32 NumUpdates = 0;
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FAnimationBudgetEntry& Entry = Entries[Index];
+		AExtCharacter* Character = Entry.Character.Get();
+		USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+		if (!Mesh)
+		{
+			Entries.RemoveAtSwap(Index);
+			continue;
+		}
+
+		UExtCharacterAnimInstance* AnimInstance = Cast<UExtCharacterAnimInstance>(Mesh->GetAnimInstance());
+		if (AnimInstance)
+		{
+			double Seconds = 0.0;
+			int32 Updates = 0;
+			AnimInstance->ConsumeAnimationCost(Seconds, Updates);
+			UsedSeconds += Seconds;
+			NumUpdates += Updates;
+		}
+
+		Entry.bIsSharingPose = Mesh->MasterPoseComponent.IsValid();
+		Entry.bIsVisible = Mesh->WasRecentlyRendered(AnimationBudgetVisibilityTolerance);
+		Entry.bAlwaysFullRate = !bEnabled || Character->IsLocallyControlled() || Character->IsRagdoll();
+		Entry.bCanDisableTick = !Entry.bIsVisible && !(AnimInstance && AnimInstance->IsAnyMontagePlaying());
+		Entry.Significance = CalculateSignificance(Character, Entry.bIsVisible, ViewLocations);
+	}
+
+	UsedMs = float(UsedSeconds * 1000.0);
+	if (NumUpdates > 0)
+	{
+		const float LastUpdateCostMs = UsedMs / NumUpdates;
+		AverageUpdateCostMs = AverageUpdateCostMs > 0.f ? FMath::Lerp(AverageUpdateCostMs, LastUpdateCostMs, AnimationBudgetCostSmoothing) : LastUpdateCostMs;
+	}
+
+	AllocateBudget(BudgetMs, MaxUpdateRate, CVarAnimationBudgetInterpolate.GetValueOnGameThread() != 0, CVarAnimationBudgetAllowTickDisable.GetValueOnGameThread() != 0);
+
+	int32 NumFullRate = 0;
+	int32 NumReduced = 0;
+	int32 NumNotTicked = 0;
+	for (FAnimationBudgetEntry& Entry : Entries)
+	{
+		ApplyBudget(Entry, MaxUpdateRate);
+
+		if (Entry.bIsSharingPose)
+			continue;
+
+		if (Entry.UpdateRate == 1)
+			++NumFullRate;
+		else if (Entry.UpdateRate > 1)
+			++NumReduced;
+		else
+			++NumNotTicked;
+	}
+
+	SET_FLOAT_STAT(STAT_AnimationBudget_BudgetMs, BudgetMs);
+	SET_FLOAT_STAT(STAT_AnimationBudget_UsedMs, UsedMs);
+	SET_FLOAT_STAT(STAT_AnimationBudget_EstimatedMs, EstimatedMs);
+	SET_FLOAT_STAT(STAT_AnimationBudget_UpdateCostMs, AverageUpdateCostMs);
+	SET_DWORD_STAT(STAT_AnimationBudget_Registered, Entries.Num());
+	SET_DWORD_STAT(STAT_AnimationBudget_FullRate, NumFullRate);
+	SET_DWORD_STAT(STAT_AnimationBudget_Reduced, NumReduced);
+	SET_DWORD_STAT(STAT_AnimationBudget_NotTicked, NumNotTicked);
+}
+
+float AAnimationBudgetManager::CalculateSignificance(const AExtCharacter* Character, bool bIsVisible, const TArray<FVector, TInlineAllocator<4>>& ViewLocations) const
+{
+	const FVector Location = Character->GetActorLocation();
+
+	float MinDistanceSquared = ViewLocations.Num() > 0 ? MAX_flt : 0.f;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ViewLocation, Location));
+	}
+
+	const float SignificanceDistance = FMath::Max(CVarAnimationBudgetSignificanceDistance.GetValueOnGameThread(), 1.f);
+	const float DistanceScale = 1.f / (1.f + FMath::Sqrt(MinDistanceSquared) / SignificanceDistance);
+	const float VisibilityScale = bIsVisible ? 1.f : CVarAnimationBudgetNotRenderedSignificance.GetValueOnGameThread();
+
+	return FMath::Max(Character->AnimationSignificance, 0.f) * DistanceScale * VisibilityScale;
+}
+
+void AAnimationBudgetManager::AllocateBudget(float BudgetMs, int32 MaxUpdateRate, bool bAllowInterpolation, bool bAllowTickDisable)
+{
+	SortedIndices.Reset(Entries.Num());
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		SortedIndices.Add(Index);
+	}
+
+	SortedIndices.Sort([this](int32 A, int32 B) { return Entries[A].Significance > Entries[B].Significance; });
+
+	EstimatedMs = 0.f;
+	for (FAnimationBudgetEntry& Entry : Entries)
+	{
+		Entry.UpdateRate = Entry.bIsSharingPose ? 0 : 1;
+		EstimatedMs += GetEstimatedCost(Entry.UpdateRate);
+	}
+
+	// Lower the rate of the least significant characters one step at a time until the estimate fits the budget.
+	// Past the slowest rate only characters out of view can be reduced further by not ticking them at all.
+	const int32 LastStep = bAllowTickDisable ? MaxUpdateRate + 1 : MaxUpdateRate;
+	for (int32 Step = 2; Step <= LastStep && EstimatedMs > BudgetMs; ++Step)
+	{
+		for (int32 Order = SortedIndices.Num() - 1; Order >= 0 && EstimatedMs > BudgetMs; --Order)
+		{
+			FAnimationBudgetEntry& Entry = Entries[SortedIndices[Order]];
+			if (Entry.bAlwaysFullRate || Entry.bIsSharingPose)
+				continue;
+
+			const int32 NewUpdateRate = Step <= MaxUpdateRate ? Step : (Entry.bCanDisableTick ? 0 : Entry.UpdateRate);
+			EstimatedMs += GetEstimatedCost(NewUpdateRate) - GetEstimatedCost(Entry.UpdateRate);
+			Entry.UpdateRate = NewUpdateRate;
+		}
+	}
+
+	for (FAnimationBudgetEntry& Entry : Entries)
+	{
+		Entry.bInterpolate = bAllowInterpolation && Entry.bIsVisible && Entry.UpdateRate > 1;
+	}
+}
+
+void AAnimationBudgetManager::ApplyBudget(FAnimationBudgetEntry& Entry, int32 MaxUpdateRate) const
+{
+	USkeletalMeshComponent* Mesh = Entry.Character->GetMesh();
+
+	// The animation sharing manager owns the mesh while it follows a shared pose, settings are applied again once promoted
+	if (Entry.bIsSharingPose)
+	{
+		Entry.AppliedUpdateRate = -1;
+		return;
+	}
+
+	// Anim graphs can skip expensive nodes on reduced characters
+	if (UExtCharacterAnimInstance* AnimInstance = Cast<UExtCharacterAnimInstance>(Mesh->GetAnimInstance()))
+		AnimInstance->SetBudgetLODLevel(Entry.UpdateRate == 1 ? 0 : (Entry.UpdateRate > 1 && Entry.UpdateRate < MaxUpdateRate ? 1 : 2));
+
+	if (Entry.UpdateRate == Entry.AppliedUpdateRate && Entry.bInterpolate == Entry.bAppliedInterpolate)
+		return;
+
+	// A mesh that is not ticked keeps its last pose until it has to be animated again
+	const bool bShouldTick = Entry.UpdateRate > 0;
+	if (Mesh->IsComponentTickEnabled() != bShouldTick)
+		Mesh->SetComponentTickEnabled(bShouldTick);
+
+	// Frames are skipped through update rate optimizations with every LOD mapped to the chosen rate.
+	// At full rate the mesh gets its own settings back so its own optimizations keep working.
+	if (FAnimUpdateRateParameters* UpdateRateParams = Mesh->AnimUpdateRateParams)
+	{
+		if (!Entry.bHasOriginalUpdateRate)
+		{
+			Entry.bHasOriginalUpdateRate = true;
+			Entry.bOriginalEnableUpdateRateOptimizations = Mesh->bEnableUpdateRateOptimizations;
+			Entry.bOriginalShouldUseLodMap = UpdateRateParams->bShouldUseLodMap;
+			Entry.OriginalMaxEvalRateForInterpolation = UpdateRateParams->MaxEvalRateForInterpolation;
+			Entry.OriginalLODToFrameSkipMap = UpdateRateParams->LODToFrameSkipMap;
+		}
+
+		if (Entry.UpdateRate > 1)
+		{
+			Mesh->bEnableUpdateRateOptimizations = true;
+
+			UpdateRateParams->bShouldUseLodMap = true;
+			UpdateRateParams->LODToFrameSkipMap.Reset();
+			for (int32 LODIndex = 0; LODIndex < FMath::Max(Mesh->GetNumLODs(), 1); ++LODIndex)
+			{
+				UpdateRateParams->LODToFrameSkipMap.Add(LODIndex, Entry.UpdateRate - 1);
+			}
+
+			UpdateRateParams->MaxEvalRateForInterpolation = Entry.bInterpolate ? MaxUpdateRate + 1 : 1;
+		}
+		else
+		{
+			RestoreUpdateRate(Entry, Mesh);
+		}
+	}
+
+	Entry.AppliedUpdateRate = Entry.UpdateRate;
+	Entry.bAppliedInterpolate = Entry.bInterpolate;
+}
+
+void AAnimationBudgetManager::ResetBudget(FAnimationBudgetEntry& Entry) const
+{
+	AExtCharacter* Character = Entry.Character.Get();
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	if (!Mesh)
+		return;
+
+	if (Entry.AppliedUpdateRate == 0)
+		Mesh->SetComponentTickEnabled(true);
+
+	RestoreUpdateRate(Entry, Mesh);
+
+	if (UExtCharacterAnimInstance* AnimInstance = Cast<UExtCharacterAnimInstance>(Mesh->GetAnimInstance()))
+		AnimInstance->SetBudgetLODLevel(0);
+
+	Entry.AppliedUpdateRate = 1;
+	Entry.bAppliedInterpolate = false;
+}
+
+void AAnimationBudgetManager::RestoreUpdateRate(const FAnimationBudgetEntry& Entry, USkeletalMeshComponent* Mesh) const
+{
+	if (!Entry.bHasOriginalUpdateRate)
+		return;
+
+	Mesh->bEnableUpdateRateOptimizations = Entry.bOriginalEnableUpdateRateOptimizations;
+	if (FAnimUpdateRateParameters* UpdateRateParams = Mesh->AnimUpdateRateParams)
+	{
+		UpdateRateParams->bShouldUseLodMap = Entry.bOriginalShouldUseLodMap;
+		UpdateRateParams->LODToFrameSkipMap = Entry.OriginalLODToFrameSkipMap;
+		UpdateRateParams->MaxEvalRateForInterpolation = Entry.OriginalMaxEvalRateForInterpolation;
+	}
+}
@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/AnimationSharingManager.h"
+#include "GameFramework/ExtCharacter.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("AnimationSharing"), STATGROUP_AnimationSharing, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("AnimationSharing Tick"), STAT_AnimationSharing_Tick, STATGROUP_AnimationSharing);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationSharing Registered"), STAT_AnimationSharing_Registered, STATGROUP_AnimationSharing);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationSharing Shared"), STAT_AnimationSharing_Shared, STATGROUP_AnimationSharing);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimationSharing Masters"), STAT_AnimationSharing_Masters, STATGROUP_AnimationSharing);
+
+TAutoConsoleVariable<int32> CVarAnimationSharingEnable(TEXT("a.AnimationSharing.Enable"), 1, TEXT("Toggle animation sharing. Disabled characters use their own anim instance.\n"), ECVF_Default);
+
+/** Scale of the promotion distance a character has to exceed to start sharing again, so it does not flip at the boundary. */
+static const float AnimationSharingDistanceHysteresis = 1.2f;
+
+AAnimationSharingManager::AAnimationSharingManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+}
+
+AAnimationSharingManager* AAnimationSharingManager::Get(UWorld* World)
+{
+	if (!World)
+		return nullptr;
+
+	for (TActorIterator<AAnimationSharingManager> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+			return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<AAnimationSharingManager>(SpawnParams);
+}
+
+void AAnimationSharingManager::Register(AExtCharacter* Character)
+{
+	check(Character);
+	check(Character->AnimationSharingSetup);
+
+	if (!Entries.ContainsByPredicate([Character](const FAnimationSharingEntry& Entry) { return Entry.Character == Character; }))
+		Entries[Entries.AddDefaulted()].Character = Character;
+}
+
+void AAnimationSharingManager::Unregister(AExtCharacter* Character)
+{
+	check(Character);
+
+	const int32 Index = Entries.IndexOfByPredicate([Character](const FAnimationSharingEntry& Entry) { return Entry.Character == Character; });
+	if (Index == INDEX_NONE)
+		return;
+
+	StopFollowing(Entries[Index]);
+	Entries.RemoveAtSwap(Index);
+}
+
+void AAnimationSharingManager::Promote(AExtCharacter* Character)
+{
+	check(Character);
+
+	if (FAnimationSharingEntry* Entry = Entries.FindByPredicate([Character](const FAnimationSharingEntry& Entry) { return Entry.Character == Character; }))
+		StopFollowing(*Entry);
+}
+
+void AAnimationSharingManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimationSharing_Tick);
+
+	Super::Tick(DeltaSeconds);
+
+	const bool bEnabled = CVarAnimationSharingEnable.GetValueOnGameThread() != 0;
+
+	// Characters close to a local view are promoted
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	int32 NumShared = 0;
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FAnimationSharingEntry& Entry = Entries[Index];
+		AExtCharacter* Character = Entry.Character.Get();
+		USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+		if (!Mesh || !Character->AnimationSharingSetup)
+		{
+			StopFollowing(Entry);
+			Entries.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const UAnimationSharingSetup* Setup = Character->AnimationSharingSetup;
+		const FVector Location = Character->GetActorLocation();
+
+		float MinDistanceSquared = MAX_flt;
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ViewLocation, Location));
+		}
+
+		const float PromotionDistance = Setup->PromotionDistance * (Entry.BucketIndex == INDEX_NONE ? AnimationSharingDistanceHysteresis : 1.f);
+
+		EAnimationSharingState State;
+		const bool bShouldShare = bEnabled
+			&& !Character->IsLocallyControlled()
+			&& Character->AnimationSignificance < Setup->PromotionSignificance
+			&& MinDistanceSquared > FMath::Square(PromotionDistance)
+			&& GetSharingState(Character, State);
+
+		const int32 BucketIndex = bShouldShare ? FindOrAddBucket(Mesh->SkeletalMesh, Setup, State) : INDEX_NONE;
+		if (BucketIndex == INDEX_NONE)
+		{
+			StopFollowing(Entry);
+			continue;
+		}
+
+		if (BucketIndex != Entry.BucketIndex)
+			Follow(Entry, BucketIndex);
+
+		++NumShared;
+	}
+
+	// Only master poses that are followed are animated
+	int32 NumMasters = 0;
+	for (FAnimationSharingBucket& Bucket : Buckets)
+	{
+		for (int32 Variant = 0; Variant < Bucket.Masters.Num(); ++Variant)
+		{
+			const bool bIsFollowed = Bucket.NumFollowers[Variant] > 0;
+			if (Bucket.Masters[Variant]->IsComponentTickEnabled() != bIsFollowed)
+				Bucket.Masters[Variant]->SetComponentTickEnabled(bIsFollowed);
+
+			NumMasters += bIsFollowed ? 1 : 0;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_AnimationSharing_Registered, Entries.Num());
+	SET_DWORD_STAT(STAT_AnimationSharing_Shared, NumShared);
+	SET_DWORD_STAT(STAT_AnimationSharing_Masters, NumMasters);
+}
+
+bool AAnimationSharingManager::GetSharingState(const AExtCharacter* Character, EAnimationSharingState& OutState) const
+{
+	const UExtCharacterMovementComponent* MovementComponent = Character->GetExtCharacterMovement();
+	if (!MovementComponent || !MovementComponent->IsMovingOnGround() || Character->IsRagdoll() || Character->IsGettingUp() || Character->bIsPerformingGenericAction)
+		return false;
+
+	const bool bIsIdle = MovementComponent->Velocity.SizeSquared2D() < FMath::Square(Character->AnimationSharingSetup->IdleSpeed);
+	if (Character->bIsCrouched)
+	{
+		OutState = bIsIdle ? EAnimationSharingState::CrouchIdle : EAnimationSharingState::CrouchWalk;
+	}
+	else if (bIsIdle)
+	{
+		OutState = EAnimationSharingState::Idle;
+	}
+	else
+	{
+		switch (Character->GetGait())
+		{
+		case ECharacterGait::Walk:
+			OutState = EAnimationSharingState::Walk;
+			break;
+		case ECharacterGait::Sprint:
+			OutState = EAnimationSharingState::Sprint;
+			break;
+		default:
+			OutState = EAnimationSharingState::Run;
+			break;
+		}
+	}
+
+	return Character->AnimationSharingSetup->FindState(OutState) != nullptr;
+}
+
+int32 AAnimationSharingManager::FindOrAddBucket(USkeletalMesh* SkeletalMesh, const UAnimationSharingSetup* Setup, EAnimationSharingState State)
+{
+	const int32 Index = Buckets.IndexOfByPredicate([=](const FAnimationSharingBucket& Bucket) { return Bucket.SkeletalMesh == SkeletalMesh && Bucket.Setup == Setup && Bucket.State == State; });
+	if (Index != INDEX_NONE)
+		return Index;
+
+	const FAnimationSharingStateSetup* StateSetup = Setup->FindState(State);
+	if (!SkeletalMesh || !StateSetup)
+		return INDEX_NONE;
+
+	const int32 BucketIndex = Buckets.AddDefaulted();
+	FAnimationSharingBucket& Bucket = Buckets[BucketIndex];
+	Bucket.SkeletalMesh = SkeletalMesh;
+	Bucket.Setup = Setup;
+	Bucket.State = State;
+
+	// Each variant loops the same sequence from a different offset. Masters are never rendered, only their pose is used.
+	const int32 NumVariants = FMath::Clamp(StateSetup->NumVariants, 1, 8);
+	for (int32 Variant = 0; Variant < NumVariants; ++Variant)
+	{
+		USkeletalMeshComponent* Master = NewObject<USkeletalMeshComponent>(this);
+		Master->SetSkeletalMesh(SkeletalMesh);
+		Master->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Master->SetHiddenInGame(true);
+		Master->bEnableUpdateRateOptimizations = false;
+		Master->VisibilityBasedAnimTickOption = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		Master->RegisterComponent();
+
+		Master->PlayAnimation(StateSetup->Sequence, true);
+		Master->SetPosition(StateSetup->Sequence->SequenceLength * Variant / NumVariants, false);
+		Master->SetComponentTickEnabled(false);
+
+		MasterComponents.Add(Master);
+		Bucket.Masters.Add(Master);
+		Bucket.NumFollowers.Add(0);
+	}
+
+	return BucketIndex;
+}
+
+void AAnimationSharingManager::Follow(FAnimationSharingEntry& Entry, int32 BucketIndex)
+{
+	if (Entry.BucketIndex != INDEX_NONE)
+		Buckets[Entry.BucketIndex].NumFollowers[Entry.Variant]--;
+
+	// Followers are spread evenly over the variants
+	FAnimationSharingBucket& Bucket = Buckets[BucketIndex];
+	int32 Variant = 0;
+	for (int32 Index = 1; Index < Bucket.NumFollowers.Num(); ++Index)
+	{
+		if (Bucket.NumFollowers[Index] < Bucket.NumFollowers[Variant])
+			Variant = Index;
+	}
+
+	Bucket.NumFollowers[Variant]++;
+
+	USkeletalMeshComponent* Master = Bucket.Masters[Variant];
+	if (!Master->IsComponentTickEnabled())
+		Master->SetComponentTickEnabled(true);
+
+	// The mesh only copies the master pose, its own anim instance is not updated while following
+	USkeletalMeshComponent* Mesh = Entry.Character->GetMesh();
+	Mesh->SetMasterPoseComponent(Master);
+	Mesh->SetComponentTickEnabled(false);
+
+	Entry.BucketIndex = BucketIndex;
+	Entry.Variant = Variant;
+}
+
+void AAnimationSharingManager::StopFollowing(FAnimationSharingEntry& Entry)
+{
+	if (Entry.BucketIndex == INDEX_NONE)
+		return;
+
+	Buckets[Entry.BucketIndex].NumFollowers[Entry.Variant]--;
+	Entry.BucketIndex = INDEX_NONE;
+
+	AExtCharacter* Character = Entry.Character.Get();
+	if (USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr)
+	{
+		Mesh->SetMasterPoseComponent(nullptr);
+		Mesh->SetComponentTickEnabled(true);
+	}
+}
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/CrowdMovementManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("CrowdMovement"), STATGROUP_CrowdMovement, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("CrowdMovement Tick"), STAT_CrowdMovement_Tick, STATGROUP_CrowdMovement);
+DECLARE_CYCLE_STAT(TEXT("CrowdMovement Gather"), STAT_CrowdMovement_Gather, STATGROUP_CrowdMovement);
+DECLARE_CYCLE_STAT(TEXT("CrowdMovement SpatialHash"), STAT_CrowdMovement_SpatialHash, STATGROUP_CrowdMovement);
+DECLARE_CYCLE_STAT(TEXT("CrowdMovement Process"), STAT_CrowdMovement_Process, STATGROUP_CrowdMovement);
+DECLARE_CYCLE_STAT(TEXT("CrowdMovement FloorPrefetch"), STAT_CrowdMovement_FloorPrefetch, STATGROUP_CrowdMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("CrowdMovement Registered"), STAT_CrowdMovement_Registered, STATGROUP_CrowdMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("CrowdMovement Batched"), STAT_CrowdMovement_Batched, STATGROUP_CrowdMovement);
+
+TAutoConsoleVariable<int32> CVarCrowdMovementEnable(TEXT("p.CrowdMovement.Enable"), 1, TEXT("Toggle batched crowd movement. Disabled characters compute their own movement.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarCrowdMovementParallelThreshold(TEXT("p.CrowdMovement.ParallelThreshold"), 16, TEXT("Minimum number of batched characters to process the batch in parallel.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarCrowdMovementAvoidance(TEXT("p.CrowdMovement.Avoidance"), 1, TEXT("Toggle crowd avoidance for characters that have it enabled.\n"), ECVF_Default);
+TAutoConsoleVariable<int32> CVarCrowdMovementFloorPrefetch(TEXT("p.CrowdMovement.FloorPrefetch"), 1, TEXT("Toggle parallel floor sweeps at the location batched characters are headed to.\n"), ECVF_Default);
+TAutoConsoleVariable<float> CVarCrowdMovementAvoidanceCellSize(TEXT("p.CrowdMovement.AvoidanceCellSize"), 400.f, TEXT("Cell size of the spatial hash used for crowd avoidance.\n"), ECVF_Default);
+
+/// Spatial Hash
+
+void FCrowdSpatialHash::Reset()
+{
+	Cells.Reset();
+	Entries.Reset();
+}
+
+void FCrowdSpatialHash::Build(const TArray<FVector>& Locations, float InCellSize)
+{
+	Reset();
+	CellSize = FMath::Max(InCellSize, 1.f);
+
+	// Count points per cell, then assign each cell a contiguous range and fill it
+	TArray<FIntPoint, TInlineAllocator<256>> PointCells;
+	PointCells.SetNumUninitialized(Locations.Num());
+	for (int32 Index = 0; Index < Locations.Num(); ++Index)
+	{
+		PointCells[Index] = GetCell(Locations[Index]);
+		Cells.FindOrAdd(PointCells[Index]).Num++;
+	}
+
+	int32 Start = 0;
+	for (TPair<FIntPoint, FCell>& Pair : Cells)
+	{
+		Pair.Value.Start = Start;
+		Start += Pair.Value.Num;
+		Pair.Value.Num = 0;
+	}
+
+	Entries.SetNumUninitialized(Locations.Num());
+	for (int32 Index = 0; Index < Locations.Num(); ++Index)
+	{
+		FCell& Cell = Cells.FindChecked(PointCells[Index]);
+		Entries[Cell.Start + Cell.Num++] = Index;
+	}
+}
+
+
+
+/// Batch
+
+void FCrowdMovementBatch::Reset()
+{
+	Components.Reset();
+
+	Velocities.Reset();
+	Accelerations.Reset();
+	AnalogInputModifiers.Reset();
+	DeltaTimes.Reset();
+	MaxInputSpeeds.Reset();
+	MaxAccelerations.Reset();
+	Frictions.Reset();
+	BrakingFrictions.Reset();
+	BrakingFrictionFactors.Reset();
+	BrakingDecelerations.Reset();
+	BrakingSpeedTolerances.Reset();
+	RequestedVelocities.Reset();
+	MaxSpeeds.Reset();
+
+	Yaws.Reset();
+	YawRates.Reset();
+	RotationDeltaTimes.Reset();
+	AdaptiveRotationSettings.Reset();
+	Flags.Reset();
+
+	Locations.Reset();
+	AvoidanceRadii.Reset();
+	AvoidancePriorities.Reset();
+	AvoidanceTimeHorizons.Reset();
+	MaxAvoidanceRadius = 0.f;
+	MaxSpeed = 0.f;
+	bHasAvoidance = false;
+	SpatialHash.Reset();
+
+	OutAccelerations.Reset();
+	OutRequestedVelocities.Reset();
+	OutVelocities.Reset();
+	OutDeltaYaws.Reset();
+}
+
+int32 FCrowdMovementBatch::Add(UExtCharacterMovementComponent* Component)
+{
+	const int32 Index = Components.Add(Component);
+
+	Velocities.AddUninitialized();
+	Accelerations.AddUninitialized();
+	AnalogInputModifiers.AddUninitialized();
+	DeltaTimes.AddUninitialized();
+	MaxInputSpeeds.AddUninitialized();
+	MaxAccelerations.AddUninitialized();
+	Frictions.AddUninitialized();
+	BrakingFrictions.AddUninitialized();
+	BrakingFrictionFactors.AddUninitialized();
+	BrakingDecelerations.AddUninitialized();
+	BrakingSpeedTolerances.AddUninitialized();
+	RequestedVelocities.AddUninitialized();
+	MaxSpeeds.AddUninitialized();
+
+	Yaws.AddUninitialized();
+	YawRates.AddUninitialized();
+	RotationDeltaTimes.AddUninitialized();
+	AdaptiveRotationSettings.AddUninitialized();
+	Flags.AddZeroed();
+
+	Locations.AddUninitialized();
+	AvoidanceRadii.AddUninitialized();
+	AvoidancePriorities.AddUninitialized();
+	AvoidanceTimeHorizons.AddUninitialized();
+
+	OutAccelerations.AddUninitialized();
+	OutRequestedVelocities.AddUninitialized();
+	OutVelocities.AddUninitialized();
+	OutDeltaYaws.AddZeroed();
+
+	return Index;
+}
+
+
+
+/// Manager
+
+ACrowdMovementManager::ACrowdMovementManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+}
+
+ACrowdMovementManager* ACrowdMovementManager::Get(UWorld* World)
+{
+	if (!World)
+		return nullptr;
+
+	for (TActorIterator<ACrowdMovementManager> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+			return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<ACrowdMovementManager>(SpawnParams);
+}
+
+void ACrowdMovementManager::Register(UExtCharacterMovementComponent* MovementComponent)
+{
+	check(MovementComponent);
+
+	MovementComponents.AddUnique(MovementComponent);
+	MovementComponent->PrimaryComponentTick.AddPrerequisite(this, PrimaryActorTick);
+}
+
+void ACrowdMovementManager::Unregister(UExtCharacterMovementComponent* MovementComponent)
+{
+	check(MovementComponent);
+
+	MovementComponents.RemoveSwap(MovementComponent);
+	MovementComponent->PrimaryComponentTick.RemovePrerequisite(this, PrimaryActorTick);
+}
+
+void ACrowdMovementManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdMovement_Tick);
+
+	Super::Tick(DeltaSeconds);
+
+	Batch.Reset();
+
+	// Gather inputs on the game thread
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CrowdMovement_Gather);
+
+		const bool bEnabled = CVarCrowdMovementEnable.GetValueOnGameThread() != 0;
+		for (int32 Index = MovementComponents.Num() - 1; Index >= 0; --Index)
+		{
+			UExtCharacterMovementComponent* MovementComponent = MovementComponents[Index].Get();
+			if (!MovementComponent)
+			{
+				MovementComponents.RemoveAtSwap(Index);
+				continue;
+			}
+
+			MovementComponent->GatherBatchedMovement(bEnabled ? DeltaSeconds : 0.f, Batch);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CrowdMovement_Registered, MovementComponents.Num());
+	SET_DWORD_STAT(STAT_CrowdMovement_Batched, Batch.Num());
+
+	// Index all batched characters so avoiding ones can find their neighbours
+	if (Batch.bHasAvoidance)
+	{
+		if (CVarCrowdMovementAvoidance.GetValueOnGameThread() != 0)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_CrowdMovement_SpatialHash);
+			Batch.SpatialHash.Build(Batch.Locations, CVarCrowdMovementAvoidanceCellSize.GetValueOnGameThread());
+		}
+		else
+		{
+			for (uint8& Flags : Batch.Flags)
+			{
+				Flags &= ~FCrowdMovementBatch::FLAG_Avoidance;
+			}
+		}
+	}
+
+	const bool bForceSingleThread = Batch.Num() < CVarCrowdMovementParallelThreshold.GetValueOnGameThread();
+
+	// Compute velocity and rotation for all characters at once
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CrowdMovement_Process);
+
+		ParallelFor(Batch.Num(), [this](int32 Index) { UExtCharacterMovementComponent::ProcessBatchedMovement(Batch, Index); }, bForceSingleThread);
+	}
+
+	// Sweep the floors characters are headed to at once as well, only the move itself remains serialized in each component tick
+	if (CVarCrowdMovementFloorPrefetch.GetValueOnGameThread() != 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CrowdMovement_FloorPrefetch);
+
+		ParallelFor(Batch.Num(), [this](int32 Index) { Batch.Components[Index]->PrefetchBatchedFloor(Batch, Index); }, bForceSingleThread);
+	}
+}
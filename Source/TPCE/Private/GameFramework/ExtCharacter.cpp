@@ -2,6 +2,8 @@
 
 #include "GameFramework/ExtCharacter.h"
 #include "GameFramework/ExtCharacterMovementComponent.h"
+#include "GameFramework/AnimationBudgetManager.h"
+#include "GameFramework/AnimationSharingManager.h"
 
 #include "GameFramework/PlayerController.h"
 #include "Components/SceneComponent.h"
@@ -28,6 +30,7 @@
 #include "PhysicsEngine/BodySetup.h"
 
 #include "ExtraMacros.h"
+#include "ExtraStats.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogExtCharacter, Log, All);
 
@@ -126,6 +129,10 @@ AExtCharacter::AExtCharacter(const FObjectInitializer& ObjectInitializer)
 
 	// Animation
 	bEnableFootIK = true;
+	bUseAnimationBudget = false;
+	AnimationSignificance = 1.0f;
+	AnimationSharingSetup = nullptr;
+	DedicatedServerAnimationMode = EDedicatedServerAnimationMode::Full;
 
 	// Look rotation settings
 	LookUpInputSpeed = 0.0f;
@@ -402,6 +409,8 @@ void AExtCharacter::PreReplication(IRepChangedPropertyTracker & ChangedPropertyT
 	// and to avoid having RemoteViewPitch replicated unecessarily.
 	FULL_OVERRIDE();
 
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(Replication, &BenchmarkCycles);
+
 	// Workaround:: Skip original ReplicatedMovement if the custom tailored one can be used.
 	if (bReplicateMovement || GetAttachmentReplication().AttachParent)
 	{
@@ -590,6 +599,9 @@ void AExtCharacter::OnRep_ReplicatedExtMovementMode()
 void AExtCharacter::OnRep_ReplicatedLook()
 {
 	RemoteViewPitch = (uint8)(ReplicatedLook.Rotation.Pitch * 255.f / 360.f);
+
+	if (UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement())
+		ExtCharacterMovement->NotifyLocomotionStateChanged();
 }
 
 void AExtCharacter::OnRep_IsWalkingInsteadOfRunning()
@@ -676,6 +688,8 @@ void AExtCharacter::PostEditChangeProperty(struct FPropertyChangedEvent& e)
 				{
 					OnEndRagdoll();
 				}
+
+				GetExtCharacterMovement()->UpdateMovementParameterKey();
 			}
 	}
 	else if (PropertyName == GET_MEMBER_NAME_CHECKED(ThisClass, RotationMode))
@@ -705,6 +719,23 @@ void AExtCharacter::PostInitializeComponents()
 	UpdateDebugComponentsVisibility();
 #endif
 
+	// Dedicated servers only need the pose for hit detection and root motion
+	const EDedicatedServerAnimationMode ServerAnimationMode = GetActiveServerAnimationMode();
+	USkeletalMeshComponent* MyMesh = GetMesh();
+	if (MyMesh && ServerAnimationMode != EDedicatedServerAnimationMode::Full)
+	{
+		if (ServerAnimationMode == EDedicatedServerAnimationMode::HitDetection)
+		{
+			MyMesh->VisibilityBasedAnimTickOption = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		}
+		else
+		{
+			// Nothing is rendered so the pose is only ticked by the movement component when playing root motion montages
+			MyMesh->VisibilityBasedAnimTickOption = EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
+			MyMesh->KinematicBonesUpdateToPhysics = EKinematicBonesUpdateToPhysics::SkipAllBones;
+		}
+	}
+
 	if (bIsRagdoll)
 	{
 		OnStartRagdoll();
@@ -729,6 +760,21 @@ void AExtCharacter::BeginPlay()
 	LastAccelerationArrow->SetVisibility(true);
 #endif
 #endif
+
+	// Dedicated servers only animate for root motion and hit detection which should not be throttled
+	if (bUseAnimationBudget && GetNetMode() != NM_DedicatedServer)
+	{
+		AnimationBudgetManager = AAnimationBudgetManager::Get(GetWorld());
+		if (AnimationBudgetManager)
+			AnimationBudgetManager->Register(this);
+	}
+
+	if (AnimationSharingSetup && GetNetMode() != NM_DedicatedServer)
+	{
+		AnimationSharingManager = AAnimationSharingManager::Get(GetWorld());
+		if (AnimationSharingManager)
+			AnimationSharingManager->Register(this);
+	}
 }
 
 void AExtCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -736,6 +782,18 @@ void AExtCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	// Make sure all timers are cleared
 	GetWorldTimerManager().ClearAllTimersForObject(this);
 
+	if (AnimationBudgetManager)
+	{
+		AnimationBudgetManager->Unregister(this);
+		AnimationBudgetManager = nullptr;
+	}
+
+	if (AnimationSharingManager)
+	{
+		AnimationSharingManager->Unregister(this);
+		AnimationSharingManager = nullptr;
+	}
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -1140,7 +1198,7 @@ void AExtCharacter::OnMovementUpdated(float DeltaSeconds, const FVector& OldLoca
 	UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement();
 	check(ExtCharacterMovement);
 
-	if (bIsRagdoll)
+	if (bIsRagdoll && ShouldSimulateRagdoll())
 	{
 		if (USkeletalMeshComponent* MyMesh = GetMesh())
 		{
@@ -1278,6 +1336,8 @@ void AExtCharacter::OnRotationModeChangedInternal()
 		break;
 	}
 
+	ExtCharacterMovement->NotifyLocomotionStateChanged();
+
 	OnRotationModeChanged();
 	RotationModeChangedDelegate.Broadcast(this);
 }
@@ -1294,6 +1354,10 @@ void AExtCharacter::OnRagdollChanged()
 
 void AExtCharacter::UpdateMovementComponentSettings()
 {
+	// Crouch, gait and generic action changes must be seen by the anim instance even if the character is idle or asleep
+	if (UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement())
+		ExtCharacterMovement->NotifyLocomotionStateChanged();
+
 	if (Role >= ROLE_AutonomousProxy)
 	{
 		switch (Gait)
@@ -1329,6 +1393,7 @@ void AExtCharacter::UpdateMovementComponentSettings(const FCharacterGaitSettings
 	ExtCharacterMovement->WalkFriction = Settings.Friction;
 	ExtCharacterMovement->BrakingDecelerationWalking = Settings.BrakingDeceleration;
 	ExtCharacterMovement->BrakingFrictionFactor = Settings.BrakingFrictionFactor;
+	ExtCharacterMovement->RebuildMovementParameterTable();
 }
 
 
@@ -1358,6 +1423,7 @@ void AExtCharacter::Landed(const FHitResult& Hit)
 			else
 			{
 				GetWorldTimerManager().SetTimer(LandingTimerHandle, this, &ThisClass::LandingTimer_OnTime, LandingDelay, false);
+				ExtCharacterMovement->UpdateMovementParameterKey();
 			}
 		}
 	}
@@ -1370,6 +1436,7 @@ void AExtCharacter::LandingTimer_OnTime()
 	// This callback is called only once so we don't have to clear the timer but the timer manager
 	// does not invalidate the handle automatically so we have to do it manually here.
 	LandingTimerHandle.Invalidate();
+	GetExtCharacterMovement()->UpdateMovementParameterKey();
 	OnLandingComplete();
 }
 
@@ -1379,6 +1446,7 @@ void AExtCharacter::CancelLanding()
 
 	check(LandingTimerHandle.IsValid());
 	GetWorldTimerManager().ClearTimer(LandingTimerHandle);
+	GetExtCharacterMovement()->UpdateMovementParameterKey();
 	OnLandingCanceled();
 }
 
@@ -1670,6 +1738,12 @@ void AExtCharacter::SetRagdoll(bool Value)
 		{
 			OnEndRagdoll();
 		}
+
+		if (UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement())
+		{
+			ExtCharacterMovement->UpdateMovementParameterKey();
+			ExtCharacterMovement->NotifyLocomotionStateChanged();
+		}
 	}
 }
 
@@ -1698,7 +1772,8 @@ void AExtCharacter::OnEndRagdoll()
 	ThisClass* DefaultCharacter = GetClass()->GetDefaultObject<ThisClass>();
 	GetCapsuleComponent()->SetCollisionProfileName(DefaultCharacter->GetCapsuleComponent()->GetCollisionProfileName());
 
-	if (USkeletalMeshComponent* MyMesh = GetMesh())
+	USkeletalMeshComponent* MyMesh = GetMesh();
+	if (MyMesh && ShouldSimulateRagdoll())
 	{
 		// Disable mesh collision and stop simulating physics
 		MyMesh->SetAllBodiesSimulatePhysics(false);
@@ -1731,10 +1806,15 @@ void AExtCharacter::OnEndRagdoll()
 
 void AExtCharacter::OnStartRagdoll()
 {
+	// A mesh following a shared pose cannot simulate
+	if (AnimationSharingManager)
+		AnimationSharingManager->Promote(this);
+
 	GetCapsuleComponent()->SetCollisionProfileName(RagdollCapsuleCollisionProfileName);
 
-	// Enable mesh collision and start simulating physics
-	if (USkeletalMeshComponent* MyMesh = GetMesh())
+	// Enable mesh collision and start simulating physics. In a capsule only fallen state the mesh is left as is.
+	USkeletalMeshComponent* MyMesh = GetMesh();
+	if (MyMesh && ShouldSimulateRagdoll())
 	{
 		if (RagdollMeshCollisionProfileName != NAME_None)
 			MyMesh->SetCollisionProfileName(RagdollMeshCollisionProfileName);
@@ -1817,6 +1897,17 @@ void AExtCharacter::OnStartRagdoll()
 	RagdollChangedDelegate.Broadcast(this);
 }
 
+EDedicatedServerAnimationMode AExtCharacter::GetActiveServerAnimationMode() const
+{
+	return GetNetMode() == NM_DedicatedServer ? DedicatedServerAnimationMode : EDedicatedServerAnimationMode::Full;
+}
+
+bool AExtCharacter::ShouldSimulateRagdoll() const
+{
+	// Hit detection needs the pose of the body where it lies and the get up pose it is blended from
+	return GetActiveServerAnimationMode() != EDedicatedServerAnimationMode::RootMotionOnly;
+}
+
 
 /// Getting Up
 
@@ -1825,6 +1916,9 @@ void AExtCharacter::CancelGettingUp()
 	check(GettingUpTimerHandle.IsValid());
 	GetWorldTimerManager().ClearTimer(GettingUpTimerHandle);
 	OnGettingUpCanceled();
+
+	if (UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement())
+		ExtCharacterMovement->NotifyLocomotionStateChanged();
 }
 
 void AExtCharacter::GettingUpTimer_OnTime()
@@ -1833,6 +1927,9 @@ void AExtCharacter::GettingUpTimer_OnTime()
 	// does not invalidate the handle automatically so we have to do it manually here.
 	GettingUpTimerHandle.Invalidate();
 	OnGettingUpComplete();
+
+	if (UExtCharacterMovementComponent* ExtCharacterMovement = GetExtCharacterMovement())
+		ExtCharacterMovement->NotifyLocomotionStateChanged();
 }
 
 void AExtCharacter::OnGettingUpComplete()
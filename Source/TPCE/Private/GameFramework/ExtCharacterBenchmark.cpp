@@ -0,0 +1,548 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/ExtCharacterBenchmark.h"
+#include "GameFramework/ExtCharacter.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Net/UnrealNetwork.h"
+#include "Kismet/Kismet.h"
+#include "ExtraStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogExtCharacterBenchmark, Log, All);
+
+/** Approximate memory in bytes of Object and what it allocates, including resources exclusive to it. */
+static SIZE_T GetObjectMemorySize(UObject* Object)
+{
+	FArchiveCountMem CountMem(Object);
+	return Object->GetClass()->GetStructureSize() + CountMem.GetMax() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
+/** Approximate memory in bytes owned by Character, its components and the anim instances of its meshes. */
+static FExtCharacterMemorySize GetCharacterMemorySize(AExtCharacter* Character)
+{
+	FExtCharacterMemorySize Size;
+	Size.Actor = GetObjectMemorySize(Character);
+
+	TInlineComponentArray<UActorComponent*> Components(Character);
+	for (UActorComponent* Component : Components)
+	{
+		Size.Components += GetObjectMemorySize(Component);
+
+		const USkeletalMeshComponent* Mesh = Cast<USkeletalMeshComponent>(Component);
+		if (UAnimInstance* AnimInstance = Mesh ? Mesh->GetAnimInstance() : nullptr)
+		{
+			Size.AnimInstances += GetObjectMemorySize(AnimInstance);
+			if (Mesh == Character->GetMesh())
+				Size.AnimInstanceObject = AnimInstance->GetClass()->GetStructureSize();
+		}
+	}
+
+	return Size;
+}
+
+static void ExecBenchmarkCommand(const TArray<FString>& Args, UWorld* World)
+{
+	if (!World || World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogExtCharacterBenchmark, Warning, TEXT("TPCE.Benchmark can only be started on the server."));
+		return;
+	}
+
+	for (TActorIterator<AExtCharacterBenchmark> It(World); It; ++It)
+	{
+		if (It->IsRunning())
+		{
+			UE_LOG(LogExtCharacterBenchmark, Warning, TEXT("A benchmark is already running."));
+			return;
+		}
+	}
+
+	FVector Location = FVector::ZeroVector;
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Location = It->GetActorLocation();
+		break;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.bDeferConstruction = true;
+	AExtCharacterBenchmark* Benchmark = World->SpawnActor<AExtCharacterBenchmark>(Location, FRotator::ZeroRotator, SpawnParams);
+	if (!Benchmark)
+		return;
+
+	if (Args.Num() > 0)
+	{
+		Benchmark->CharacterCounts.Reset();
+		for (const FString& Arg : Args)
+		{
+			const int32 Count = FCString::Atoi(*Arg);
+			if (Count > 0)
+				Benchmark->CharacterCounts.Add(Count);
+		}
+	}
+
+	// Without a configured character use the game's own so animation costs are representative
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	if (!Benchmark->CharacterClass && GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(AExtCharacter::StaticClass()))
+	{
+		Benchmark->CharacterClass = *GameMode->DefaultPawnClass;
+	}
+
+	// Automation tests run the benchmark headless too but keep the application running for the next test
+	Benchmark->bQuitWhenFinished = FParse::Param(FCommandLine::Get(), TEXT("nullrhi")) && !GIsAutomationTesting;
+	Benchmark->FinishSpawning(FTransform(Location));
+	Benchmark->StartBenchmark();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+	TEXT("TPCE.Benchmark"),
+	TEXT("Spawn an increasing number of ExtCharacters with scripted inputs and record movement, animation and replication costs to CSV.\n")
+	TEXT("Usage: TPCE.Benchmark [Count1 Count2 ...]. Defaults to 1 10 100 500.\n"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ExecBenchmarkCommand)
+);
+
+FORCEINLINE static const TCHAR* GetNetModeName(ENetMode NetMode)
+{
+	switch (NetMode)
+	{
+	case NM_DedicatedServer:
+		return TEXT("DedicatedServer");
+	case NM_ListenServer:
+		return TEXT("ListenServer");
+	case NM_Client:
+		return TEXT("Client");
+	default:
+		return TEXT("Standalone");
+	}
+}
+
+
+
+/// Benchmark
+
+AExtCharacterBenchmark::AExtCharacterBenchmark()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 10.f;
+
+	CharacterCounts = { 1, 10, 100, 500 };
+	WarmupTime = 2.f;
+	SampleTime = 10.f;
+	SegmentDuration = 2.f;
+	Spacing = 300.f;
+	OutputFileName = TEXT("ExtCharacterBenchmark");
+	bQuitWhenFinished = false;
+
+	StageIndex = INDEX_NONE;
+	Phase = EExtCharacterBenchmarkPhase::Idle;
+	SampledStageIndex = INDEX_NONE;
+}
+
+void AExtCharacterBenchmark::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AExtCharacterBenchmark, StageIndex);
+	DOREPLIFETIME(AExtCharacterBenchmark, Phase);
+}
+
+void AExtCharacterBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Results.Add(TEXT("NetMode,Characters,Frames,FrameMs,MovementMs,AnimUpdateMs,AnimNodesMs,ReplicationMs,MovementUsPerCharacter,AnimUpdateUsPerCharacter,AnimNodesUsPerCharacter,ReplicationUsPerCharacter,KBPerCharacter,AnimInstanceBytes"));
+	CharacterResults.Add(TEXT("NetMode,Characters,Character,Role,ServerAnimationMode,MovementUs,AnimUpdateUs,AnimNodesUs,ReplicationUs,TotalUs,ActorBytes,ComponentBytes,AnimInstanceBytes,AnimInstanceObjectBytes,TotalBytes"));
+}
+
+void AExtCharacterBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Keep partial results of clients losing the connection or an interrupted run
+	if (bIsSampling)
+		EndSample();
+
+	if (Phase != EExtCharacterBenchmarkPhase::Finished && Results.Num() > 1)
+		Finish();
+
+	if (HasAuthority())
+		DestroyCharacters();
+
+	FCharacterBenchmarkTimers::bEnabled = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AExtCharacterBenchmark::StartBenchmark()
+{
+	if (!HasAuthority())
+		return;
+
+	if (!CharacterClass || CharacterClass->HasAnyClassFlags(CLASS_Abstract))
+	{
+		Fail(*FString::Printf(TEXT("CharacterClass %s is not a concrete ExtCharacter. Set it in the game config or use an ExtCharacter as default pawn."), *GetNameSafe(*CharacterClass)));
+		return;
+	}
+
+	if (CharacterCounts.Num() == 0)
+	{
+		Fail(TEXT("No character counts to run."));
+		return;
+	}
+
+	DestroyCharacters();
+	SpawnCharacters(CharacterCounts[0]);
+	if (Characters.Num() == 0)
+	{
+		Fail(*FString::Printf(TEXT("No %s could be spawned."), *CharacterClass->GetName()));
+		return;
+	}
+
+	SetStage(0, EExtCharacterBenchmarkPhase::Warmup);
+}
+
+void AExtCharacterBenchmark::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bIsSampling)
+		++SampledFrames;
+
+	if (!HasAuthority() || !IsRunning())
+		return;
+
+	UpdateCharacterInputs();
+
+	PhaseTime += DeltaSeconds;
+	if (Phase == EExtCharacterBenchmarkPhase::Warmup)
+	{
+		if (PhaseTime >= WarmupTime)
+			SetStage(StageIndex, EExtCharacterBenchmarkPhase::Sampling);
+	}
+	else if (PhaseTime >= SampleTime)
+	{
+		EndSample();
+		DestroyCharacters();
+
+		const int32 NextStageIndex = StageIndex + 1;
+		if (CharacterCounts.IsValidIndex(NextStageIndex))
+		{
+			SpawnCharacters(CharacterCounts[NextStageIndex]);
+			if (Characters.Num() == 0)
+			{
+				Fail(*FString::Printf(TEXT("No %s could be spawned."), *CharacterClass->GetName()));
+				return;
+			}
+
+			SetStage(NextStageIndex, EExtCharacterBenchmarkPhase::Warmup);
+		}
+		else
+		{
+			SetStage(StageIndex, EExtCharacterBenchmarkPhase::Finished);
+		}
+	}
+}
+
+void AExtCharacterBenchmark::OnRep_Stage()
+{
+	UpdateSampling();
+}
+
+void AExtCharacterBenchmark::SetStage(int32 NewStageIndex, EExtCharacterBenchmarkPhase NewPhase)
+{
+	StageIndex = NewStageIndex;
+	Phase = NewPhase;
+	PhaseTime = 0.f;
+
+	ForceNetUpdate();
+	UpdateSampling();
+}
+
+void AExtCharacterBenchmark::UpdateSampling()
+{
+	const bool bShouldSample = Phase == EExtCharacterBenchmarkPhase::Sampling;
+	if (bIsSampling && (!bShouldSample || SampledStageIndex != StageIndex))
+		EndSample();
+
+	if (bShouldSample && !bIsSampling)
+		BeginSample();
+
+	if (Phase == EExtCharacterBenchmarkPhase::Finished)
+		Finish();
+}
+
+void AExtCharacterBenchmark::BeginSample()
+{
+	bIsSampling = true;
+	SampledStageIndex = StageIndex;
+	SampledFrames = 0;
+	SampleStartTime = FPlatformTime::Seconds();
+
+	// Count characters actually present, clients only know about relevant proxies
+	CharacterSamples.Reset();
+	for (TActorIterator<AExtCharacter> It(GetWorld()); It; ++It)
+	{
+		FExtCharacterBenchmarkSample& Sample = CharacterSamples[CharacterSamples.AddDefaulted()];
+		Sample.Character = *It;
+		Sample.Name = It->GetName();
+		Sample.Memory = GetCharacterMemorySize(*It);
+
+		It->GetBenchmarkCycles().Reset();
+	}
+	SampledCharacters = CharacterSamples.Num();
+
+	FCharacterBenchmarkTimers::Reset();
+	FCharacterBenchmarkTimers::bEnabled = true;
+}
+
+void AExtCharacterBenchmark::EndSample()
+{
+	if (!bIsSampling)
+		return;
+
+	FCharacterBenchmarkTimers::bEnabled = false;
+	bIsSampling = false;
+
+	if (SampledFrames == 0)
+		return;
+
+	const double FrameMs = (FPlatformTime::Seconds() - SampleStartTime) * 1000.0 / SampledFrames;
+
+	double SystemMs[(int32)ECharacterBenchmarkSystem::Count];
+	for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+	{
+		SystemMs[Index] = FCharacterBenchmarkTimers::GetMilliseconds((ECharacterBenchmarkSystem)Index) / SampledFrames;
+	}
+
+	const double UsPerCharacter = SampledCharacters > 0 ? 1000.0 / SampledCharacters : 0.0;
+
+	SIZE_T SampledCharacterMemory = 0;
+	SIZE_T SampledAnimInstanceSize = 0;
+	for (const FExtCharacterBenchmarkSample& Sample : CharacterSamples)
+	{
+		SampledCharacterMemory += Sample.Memory.GetTotal();
+		SampledAnimInstanceSize += Sample.Memory.AnimInstanceObject;
+	}
+
+	FString Row = FString::Printf(TEXT("%s,%d,%d,%.4f"), GetNetModeName(GetNetMode()), SampledCharacters, SampledFrames, FrameMs);
+	for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+	{
+		Row += FString::Printf(TEXT(",%.4f"), SystemMs[Index]);
+	}
+	for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+	{
+		Row += FString::Printf(TEXT(",%.4f"), SystemMs[Index] * UsPerCharacter);
+	}
+	Row += FString::Printf(TEXT(",%.2f"), SampledCharacters > 0 ? SampledCharacterMemory / 1024.0 / SampledCharacters : 0.0);
+	Row += FString::Printf(TEXT(",%.0f"), SampledCharacters > 0 ? (double)SampledAnimInstanceSize / SampledCharacters : 0.0);
+
+	UE_LOG(LogExtCharacterBenchmark, Log, TEXT("%s"), *Row);
+	Results.Add(MoveTemp(Row));
+
+	// Characters destroyed before the sample ended, e.g. proxies that stopped being relevant, are reported without costs
+	for (const FExtCharacterBenchmarkSample& Sample : CharacterSamples)
+	{
+		const AExtCharacter* Character = Sample.Character.Get();
+
+		FString CharacterRow = FString::Printf(TEXT("%s,%d,%s,%s,%s"), GetNetModeName(GetNetMode()), SampledCharacters, *Sample.Name,
+			Character ? *GetEnumeratorDisplayName(ENetRole, Character->Role.GetValue()) : TEXT(""),
+			Character ? *GetEnumeratorDisplayName(EDedicatedServerAnimationMode, Character->GetActiveServerAnimationMode()) : TEXT(""));
+
+		double TotalUs = 0.0;
+		for (int32 Index = 0; Index < (int32)ECharacterBenchmarkSystem::Count; ++Index)
+		{
+			const double SystemUs = Character ? Character->GetBenchmarkCycles().GetMilliseconds((ECharacterBenchmarkSystem)Index) * 1000.0 / SampledFrames : 0.0;
+			CharacterRow += FString::Printf(TEXT(",%.2f"), SystemUs);
+			TotalUs += SystemUs;
+		}
+		CharacterRow += FString::Printf(TEXT(",%.2f"), TotalUs);
+
+		CharacterRow += FString::Printf(TEXT(",%llu,%llu,%llu,%llu,%llu"), (uint64)Sample.Memory.Actor, (uint64)Sample.Memory.Components,
+			(uint64)Sample.Memory.AnimInstances, (uint64)Sample.Memory.AnimInstanceObject, (uint64)Sample.Memory.GetTotal());
+
+		CharacterResults.Add(MoveTemp(CharacterRow));
+	}
+
+	CharacterSamples.Reset();
+}
+
+void AExtCharacterBenchmark::Finish()
+{
+	SaveResults(Results, TEXT(""));
+	SaveResults(CharacterResults, TEXT("-Characters"));
+
+	// Only keep the headers so an interrupted run does not save twice
+	Results.SetNum(1);
+	CharacterResults.SetNum(1);
+
+	if (bQuitWhenFinished)
+		FPlatformMisc::RequestExit(false);
+}
+
+void AExtCharacterBenchmark::Fail(const TCHAR* Reason)
+{
+	UE_LOG(LogExtCharacterBenchmark, Error, TEXT("Benchmark failed: %s"), Reason);
+
+	DestroyCharacters();
+	SetStage(StageIndex, EExtCharacterBenchmarkPhase::Failed);
+
+	if (bQuitWhenFinished)
+		FPlatformMisc::RequestExit(false);
+}
+
+void AExtCharacterBenchmark::SaveResults(const TArray<FString>& Rows, const TCHAR* Suffix) const
+{
+	const FString FileName = FString::Printf(TEXT("%s%s-%s-%s.csv"), *OutputFileName, Suffix, GetNetModeName(GetNetMode()), *FDateTime::Now().ToString());
+	const FString FilePath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("TPCE"), FileName);
+
+	if (FFileHelper::SaveStringToFile(FString::Join(Rows, LINE_TERMINATOR) + LINE_TERMINATOR, *FilePath))
+	{
+		UE_LOG(LogExtCharacterBenchmark, Log, TEXT("Benchmark results saved to %s"), *FPaths::ConvertRelativePathToFull(FilePath));
+	}
+	else
+	{
+		UE_LOG(LogExtCharacterBenchmark, Error, TEXT("Failed to save benchmark results to %s"), *FilePath);
+	}
+}
+
+void AExtCharacterBenchmark::SpawnCharacters(int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (!World || !CharacterClass)
+		return;
+
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt((float)Count));
+	const FVector Origin = GetActorLocation() - FVector(GridSize - 1, GridSize - 1, 0.f) * Spacing * 0.5f;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	Characters.Reserve(Count);
+	Segments.Reserve(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location = Origin + FVector(Index % GridSize, Index / GridSize, 0.f) * Spacing;
+		AExtCharacter* Character = World->SpawnActor<AExtCharacter>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (!Character)
+			continue;
+
+		if (AController* Controller = World->SpawnActor<AExtCharacterBenchmarkController>(Location, FRotator::ZeroRotator, SpawnParams))
+			Controller->Possess(Character);
+
+		Characters.Add(Character);
+		Segments.Add(EExtCharacterBenchmarkSegment::Count);
+	}
+}
+
+void AExtCharacterBenchmark::DestroyCharacters()
+{
+	for (AExtCharacter* Character : Characters)
+	{
+		if (!IsValid(Character))
+			continue;
+
+		if (AController* Controller = Character->GetController())
+		{
+			Controller->UnPossess();
+			Controller->Destroy();
+		}
+
+		Character->Destroy();
+	}
+
+	Characters.Reset();
+	Segments.Reset();
+}
+
+void AExtCharacterBenchmark::UpdateCharacterInputs()
+{
+	const float Time = GetWorld()->GetTimeSeconds();
+	const int32 NumSegments = (int32)EExtCharacterBenchmarkSegment::Count;
+
+	for (int32 Index = 0; Index < Characters.Num(); ++Index)
+	{
+		AExtCharacter* Character = Characters[Index];
+		if (!IsValid(Character))
+			continue;
+
+		// Offset each character so all segments are represented in every frame
+		const float CharacterTime = Time + Index * SegmentDuration / NumSegments;
+		const int32 SegmentCounter = FMath::FloorToInt(CharacterTime / SegmentDuration);
+		const EExtCharacterBenchmarkSegment Segment = (EExtCharacterBenchmarkSegment)(SegmentCounter % NumSegments);
+		const float SegmentTime = CharacterTime - SegmentCounter * SegmentDuration;
+
+		const bool bSegmentChanged = Segments[Index] != Segment;
+		Segments[Index] = Segment;
+
+		ApplySegmentInputs(Character, Segment, bSegmentChanged, SegmentTime, SegmentCounter / NumSegments);
+	}
+}
+
+void AExtCharacterBenchmark::ApplySegmentInputs(AExtCharacter* Character, EExtCharacterBenchmarkSegment Segment, bool bSegmentChanged, float SegmentTime, int32 Cycle)
+{
+	// Alternate direction every cycle so characters stay around their spawn location
+	FVector Direction = (Cycle % 2 == 0) ? FVector::ForwardVector : FVector::BackwardVector;
+
+	if (bSegmentChanged)
+	{
+		Character->StopJumping();
+		Character->UnCrouch();
+		Character->UnSprint();
+
+		switch (Segment)
+		{
+		case EExtCharacterBenchmarkSegment::Walk:
+			Character->Walk();
+			break;
+		case EExtCharacterBenchmarkSegment::Sprint:
+			Character->UnWalk();
+			Character->Sprint();
+			break;
+		case EExtCharacterBenchmarkSegment::Crouch:
+			Character->Crouch();
+			break;
+		case EExtCharacterBenchmarkSegment::Jump:
+			Character->Jump();
+			break;
+		default:
+			break;
+		}
+
+		Character->SetRotationMode(Segment == EExtCharacterBenchmarkSegment::TurnInPlace ? ECharacterRotationMode::OrientToController : ECharacterRotationMode::OrientToMovement);
+	}
+
+	switch (Segment)
+	{
+	case EExtCharacterBenchmarkSegment::Pivot:
+		// Reverse direction twice a second
+		if (FMath::FloorToInt(SegmentTime * 2.f) % 2 == 1)
+			Direction = -Direction;
+		break;
+	case EExtCharacterBenchmarkSegment::TurnInPlace:
+		// Stand still and step the control rotation by 120 degrees a second
+		if (AController* Controller = Character->GetController())
+			Controller->SetControlRotation(FRotator(0.f, FMath::FloorToInt(SegmentTime) * 120.f + Cycle * 45.f, 0.f));
+		return;
+	default:
+		break;
+	}
+
+	Character->AddMovementInput(Direction, 1.f, true);
+}
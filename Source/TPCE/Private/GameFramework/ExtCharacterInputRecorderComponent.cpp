@@ -0,0 +1,563 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/ExtCharacterInputRecorderComponent.h"
+#include "GameFramework/ExtCharacter.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerInput.h"
+#include "Components/InputComponent.h"
+#include "Engine/World.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogExtCharacterInputRecorder, Log, All);
+
+static const uint32 InputRecordingMagic = 0x43524945; // "EIRC"
+static const int32 InputRecordingVersion = 1;
+
+static AExtCharacter* GetLocalExtCharacter(UWorld* World)
+{
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	return PlayerController ? Cast<AExtCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+static void ExecRecordInputCommand(const TArray<FString>& Args, UWorld* World)
+{
+	AExtCharacter* Character = GetLocalExtCharacter(World);
+	if (!Character)
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("TPCE.RecordInput requires a locally controlled ExtCharacter."));
+		return;
+	}
+
+	UExtCharacterInputRecorderComponent* Recorder = UExtCharacterInputRecorderComponent::FindOrAdd(Character);
+	if (Recorder->GetState() == EExtCharacterInputRecorderState::Recording)
+	{
+		Recorder->StopRecording();
+	}
+	else
+	{
+		Recorder->StartRecording(Args.Num() > 0 ? Args[0] : FDateTime::Now().ToString());
+	}
+}
+
+static void ExecReplayInputCommand(const TArray<FString>& Args, UWorld* World)
+{
+	AExtCharacter* Character = GetLocalExtCharacter(World);
+	if (!Character || Args.Num() == 0)
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("TPCE.ReplayInput requires a recording name and a locally controlled ExtCharacter."));
+		return;
+	}
+
+	UExtCharacterInputRecorderComponent* Recorder = UExtCharacterInputRecorderComponent::FindOrAdd(Character);
+	Recorder->bQuitWhenReplayFinished = FParse::Param(FCommandLine::Get(), TEXT("nullrhi"));
+	Recorder->StartReplay(Args[0]);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RecordInputCommand(
+	TEXT("TPCE.RecordInput"),
+	TEXT("Start or stop recording the input of the local ExtCharacter. Usage: TPCE.RecordInput [Name]\n"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ExecRecordInputCommand)
+);
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayInputCommand(
+	TEXT("TPCE.ReplayInput"),
+	TEXT("Replay a recorded input stream on the local ExtCharacter and compare the resulting trajectory. Usage: TPCE.ReplayInput Name\n"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ExecReplayInputCommand)
+);
+
+
+
+/// Recording
+
+FArchive& operator<<(FArchive& Ar, FExtCharacterInputFrame& Frame)
+{
+	Ar << Frame.Time;
+	Ar << Frame.ControlRotation;
+	Ar << Frame.AxisValues;
+	Ar << Frame.HeldActions;
+
+	FRepExtMovement& Movement = Frame.Movement;
+	Ar << Movement.Location;
+	Ar << Movement.Rotation;
+	Ar << Movement.Velocity;
+	Ar << Movement.Acceleration;
+	Ar << Movement.TurnInPlaceTargetYaw;
+
+	uint8 bIsPivotTurning = Movement.bIsPivotTurning;
+	Ar << bIsPivotTurning;
+	Movement.bIsPivotTurning = bIsPivotTurning;
+
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FExtCharacterInputRecording& Recording)
+{
+	uint32 Magic = InputRecordingMagic;
+	int32 Version = InputRecordingVersion;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Magic != InputRecordingMagic || Version != InputRecordingVersion)
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Recording.AxisNames;
+	Ar << Recording.ActionNames;
+	Ar << Recording.MovementMode;
+
+	uint8 RotationMode = (uint8)Recording.RotationMode;
+	uint8 Flags = (Recording.bIsCrouched << 0) | (Recording.bIsWalkingInsteadOfRunning << 1) | (Recording.bIsSprinting << 2);
+	Ar << RotationMode;
+	Ar << Flags;
+	Recording.RotationMode = (ECharacterRotationMode)RotationMode;
+	Recording.bIsCrouched = (Flags & (1 << 0)) ? 1 : 0;
+	Recording.bIsWalkingInsteadOfRunning = (Flags & (1 << 1)) ? 1 : 0;
+	Recording.bIsSprinting = (Flags & (1 << 2)) ? 1 : 0;
+
+	Ar << Recording.Frames;
+
+	return Ar;
+}
+
+FRepExtMovement FExtCharacterInputRecording::SampleMovement(float Time) const
+{
+	if (Frames.Num() == 0)
+		return FRepExtMovement();
+
+	// Index of the first frame after Time
+	const int32 Index = Algo::UpperBoundBy(Frames, Time, [](const FExtCharacterInputFrame& Frame) { return Frame.Time; });
+	if (Index == 0)
+		return Frames[0].Movement;
+	if (Index == Frames.Num())
+		return Frames.Last().Movement;
+
+	const FExtCharacterInputFrame& A = Frames[Index - 1];
+	const FExtCharacterInputFrame& B = Frames[Index];
+	const float Alpha = (B.Time > A.Time) ? (Time - A.Time) / (B.Time - A.Time) : 0.f;
+
+	FRepExtMovement Result = A.Movement;
+	Result.Location = FMath::Lerp(A.Movement.Location, B.Movement.Location, Alpha);
+	Result.Rotation = FQuat::Slerp(A.Movement.Rotation.Quaternion(), B.Movement.Rotation.Quaternion(), Alpha).Rotator();
+	Result.Velocity = FMath::Lerp(A.Movement.Velocity, B.Movement.Velocity, Alpha);
+	return Result;
+}
+
+bool FExtCharacterInputRecording::SaveToFile(const FString& FilePath) const
+{
+	FBufferArchive Writer;
+	Writer << const_cast<FExtCharacterInputRecording&>(*this);
+	return FFileHelper::SaveArrayToFile(Writer, *FilePath);
+}
+
+bool FExtCharacterInputRecording::LoadFromFile(const FString& FilePath)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath))
+		return false;
+
+	FMemoryReader Reader(Data, true);
+	Reader << *this;
+	return !Reader.IsError();
+}
+
+FString FExtCharacterInputRecording::GetFilePath(const FString& Name)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TPCE"), TEXT("InputRecordings"), Name + TEXT(".bin"));
+}
+
+
+
+/// Component
+
+UExtCharacterInputRecorderComponent::UExtCharacterInputRecorderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	LocationTolerance = 1.f;
+	bQuitWhenReplayFinished = false;
+
+	State = EExtCharacterInputRecorderState::Idle;
+}
+
+UExtCharacterInputRecorderComponent* UExtCharacterInputRecorderComponent::FindOrAdd(AExtCharacter* Character)
+{
+	check(Character);
+
+	UExtCharacterInputRecorderComponent* Recorder = Character->FindComponentByClass<UExtCharacterInputRecorderComponent>();
+	if (!Recorder)
+	{
+		Recorder = NewObject<UExtCharacterInputRecorderComponent>(Character);
+		Recorder->RegisterComponent();
+	}
+
+	return Recorder;
+}
+
+void UExtCharacterInputRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ExtCharacterOwner = Cast<AExtCharacter>(GetOwner());
+	if (!ExtCharacterOwner)
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Error, TEXT("%s can only be used with ExtCharacters."), *GetPathName());
+	}
+}
+
+void UExtCharacterInputRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (State == EExtCharacterInputRecorderState::Recording)
+	{
+		StopRecording();
+	}
+	else if (State == EExtCharacterInputRecorderState::Replaying)
+	{
+		StopReplay();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UExtCharacterInputRecorderComponent::UpdateTickDependencies()
+{
+	if (AController* Controller = ExtCharacterOwner->GetController())
+		AddTickPrerequisiteActor(Controller);
+
+	if (UExtCharacterMovementComponent* MovementComponent = ExtCharacterOwner->GetExtCharacterMovement())
+		MovementComponent->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+}
+
+void UExtCharacterInputRecorderComponent::GatherMovement(FRepExtMovement& Movement) const
+{
+	UExtCharacterMovementComponent* MovementComponent = ExtCharacterOwner->GetExtCharacterMovement();
+	check(MovementComponent);
+
+	Movement.Location = ExtCharacterOwner->GetActorLocation();
+	Movement.Rotation = ExtCharacterOwner->GetActorRotation();
+	Movement.Velocity = MovementComponent->Velocity;
+	Movement.Acceleration = MovementComponent->GetCurrentAcceleration().GetSafeNormal();
+	Movement.bIsPivotTurning = MovementComponent->IsPivotTurning();
+	Movement.TurnInPlaceTargetYaw = MovementComponent->GetTurnInPlaceTargetYaw();
+}
+
+bool UExtCharacterInputRecorderComponent::StartRecording(const FString& Name)
+{
+	if (!ExtCharacterOwner || !ExtCharacterOwner->InputComponent || !ExtCharacterOwner->IsLocallyControlled())
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("Cannot record %s: character must be locally controlled and have input bound."), *GetNameSafe(GetOwner()));
+		return false;
+	}
+
+	if (State == EExtCharacterInputRecorderState::Replaying)
+		StopReplay();
+
+	Recording = FExtCharacterInputRecording();
+	RecordingName = Name;
+	Time = 0.f;
+
+	UInputComponent* Input = ExtCharacterOwner->InputComponent;
+	for (const FInputAxisBinding& Binding : Input->AxisBindings)
+	{
+		Recording.AxisNames.AddUnique(Binding.AxisName);
+	}
+
+	for (int32 Index = 0; Index < Input->GetNumActionBindings(); ++Index)
+	{
+		Recording.ActionNames.AddUnique(Input->GetActionBinding(Index).GetActionName());
+	}
+
+	if (Recording.ActionNames.Num() > 32)
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("Only the first 32 bound actions of %s are recorded."), *GetNameSafe(GetOwner()));
+		Recording.ActionNames.SetNum(32);
+	}
+
+	UExtCharacterMovementComponent* MovementComponent = ExtCharacterOwner->GetExtCharacterMovement();
+	Recording.MovementMode = MovementComponent->MovementMode;
+	Recording.RotationMode = ExtCharacterOwner->GetRotationMode();
+	Recording.bIsCrouched = ExtCharacterOwner->bIsCrouched;
+	Recording.bIsWalkingInsteadOfRunning = ExtCharacterOwner->bIsWalkingInsteadOfRunning;
+	Recording.bIsSprinting = ExtCharacterOwner->bIsSprinting;
+
+	State = EExtCharacterInputRecorderState::Recording;
+	UpdateTickDependencies();
+	SetComponentTickEnabled(true);
+
+	UE_LOG(LogExtCharacterInputRecorder, Log, TEXT("Recording input of %s as '%s'."), *GetNameSafe(GetOwner()), *RecordingName);
+	return true;
+}
+
+bool UExtCharacterInputRecorderComponent::StopRecording()
+{
+	if (State != EExtCharacterInputRecorderState::Recording)
+		return false;
+
+	State = EExtCharacterInputRecorderState::Idle;
+	SetComponentTickEnabled(false);
+
+	const FString FilePath = FExtCharacterInputRecording::GetFilePath(RecordingName);
+	if (!Recording.SaveToFile(FilePath))
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Error, TEXT("Failed to save input recording to %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogExtCharacterInputRecorder, Log, TEXT("Saved %d frames (%.2fs) of input to %s"), Recording.Frames.Num(), Recording.GetDuration(), *FPaths::ConvertRelativePathToFull(FilePath));
+	return true;
+}
+
+bool UExtCharacterInputRecorderComponent::StartReplay(const FString& Name)
+{
+	if (!ExtCharacterOwner || !ExtCharacterOwner->InputComponent || !ExtCharacterOwner->IsLocallyControlled())
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("Cannot replay on %s: character must be locally controlled and have input bound."), *GetNameSafe(GetOwner()));
+		return false;
+	}
+
+	if (State == EExtCharacterInputRecorderState::Recording)
+		StopRecording();
+	else if (State == EExtCharacterInputRecorderState::Replaying)
+		StopReplay();
+
+	const FString FilePath = FExtCharacterInputRecording::GetFilePath(Name);
+	if (!Recording.LoadFromFile(FilePath) || Recording.Frames.Num() == 0)
+	{
+		UE_LOG(LogExtCharacterInputRecorder, Error, TEXT("Failed to load input recording from %s"), *FilePath);
+		return false;
+	}
+
+	RecordingName = Name;
+	Time = 0.f;
+	ReplayFrameIndex = INDEX_NONE;
+	ReplayHeldActions = 0;
+	ReplayLocationErrorSum = 0.f;
+	ReplayResult = FExtCharacterReplayResult();
+
+	// Live input would otherwise be mixed with the replayed one
+	if (APlayerController* PlayerController = Cast<APlayerController>(ExtCharacterOwner->GetController()))
+		ExtCharacterOwner->DisableInput(PlayerController);
+
+	ApplyInitialState();
+
+	State = EExtCharacterInputRecorderState::Replaying;
+	UpdateTickDependencies();
+	SetComponentTickEnabled(true);
+
+	UE_LOG(LogExtCharacterInputRecorder, Log, TEXT("Replaying input '%s' (%d frames, %.2fs) on %s."), *RecordingName, Recording.Frames.Num(), Recording.GetDuration(), *GetNameSafe(GetOwner()));
+	return true;
+}
+
+void UExtCharacterInputRecorderComponent::StopReplay()
+{
+	if (State != EExtCharacterInputRecorderState::Replaying)
+		return;
+
+	State = EExtCharacterInputRecorderState::Idle;
+	SetComponentTickEnabled(false);
+
+	// Release anything still held
+	for (int32 Index = 0; Index < Recording.ActionNames.Num(); ++Index)
+	{
+		if (ReplayHeldActions & (1u << Index))
+			ExecuteAction(Recording.ActionNames[Index], false);
+	}
+	ReplayHeldActions = 0;
+
+	if (APlayerController* PlayerController = Cast<APlayerController>(ExtCharacterOwner->GetController()))
+		ExtCharacterOwner->EnableInput(PlayerController);
+
+	ReplayResult.AverageLocationError = ReplayResult.Frames > 0 ? ReplayLocationErrorSum / ReplayResult.Frames : 0.f;
+
+	UE_LOG(LogExtCharacterInputRecorder, Log, TEXT("Replay of '%s' %s: Frames=%d MaxLocationError=%.3f AverageLocationError=%.3f MaxRotationError=%.3f MaxVelocityError=%.3f DivergenceTime=%.3f"),
+		*RecordingName, ReplayResult.IsMatch() ? TEXT("matched") : TEXT("diverged"), ReplayResult.Frames, ReplayResult.MaxLocationError,
+		ReplayResult.AverageLocationError, ReplayResult.MaxRotationError, ReplayResult.MaxVelocityError, ReplayResult.DivergenceTime);
+
+	ReplayFinishedDelegate.Broadcast(this, ReplayResult);
+
+	if (bQuitWhenReplayFinished)
+		FPlatformMisc::RequestExit(false);
+}
+
+void UExtCharacterInputRecorderComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!ExtCharacterOwner)
+		return;
+
+	if (State == EExtCharacterInputRecorderState::Recording)
+	{
+		RecordFrame();
+	}
+	else if (State == EExtCharacterInputRecorderState::Replaying)
+	{
+		ReplayFrame(DeltaTime);
+	}
+
+	Time += DeltaTime;
+}
+
+void UExtCharacterInputRecorderComponent::RecordFrame()
+{
+	AController* Controller = ExtCharacterOwner->GetController();
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	UInputComponent* Input = ExtCharacterOwner->InputComponent;
+	if (!Input)
+		return;
+
+	FExtCharacterInputFrame& Frame = Recording.Frames[Recording.Frames.AddDefaulted()];
+	Frame.Time = Time;
+	Frame.ControlRotation = Controller ? Controller->GetControlRotation() : FRotator::ZeroRotator;
+
+	Frame.AxisValues.Reserve(Recording.AxisNames.Num());
+	for (const FName& AxisName : Recording.AxisNames)
+	{
+		Frame.AxisValues.Add(Input->GetAxisValue(AxisName));
+	}
+
+	if (PlayerController && PlayerController->PlayerInput)
+	{
+		for (int32 Index = 0; Index < Recording.ActionNames.Num(); ++Index)
+		{
+			for (const FInputActionKeyMapping& Mapping : PlayerController->PlayerInput->GetKeysForAction(Recording.ActionNames[Index]))
+			{
+				if (PlayerController->IsInputKeyDown(Mapping.Key))
+				{
+					Frame.HeldActions |= (1u << Index);
+					break;
+				}
+			}
+		}
+	}
+
+	GatherMovement(Frame.Movement);
+}
+
+void UExtCharacterInputRecorderComponent::ReplayFrame(float DeltaTime)
+{
+	if (Time > Recording.GetDuration())
+	{
+		StopReplay();
+		return;
+	}
+
+	CompareFrame();
+
+	// Advance to the last recorded frame not later than the current time. Action changes of skipped frames are still applied
+	// so replaying at a lower frame rate does not drop short presses.
+	while (Recording.Frames.IsValidIndex(ReplayFrameIndex + 1) && Recording.Frames[ReplayFrameIndex + 1].Time <= Time)
+	{
+		++ReplayFrameIndex;
+
+		const uint32 HeldActions = Recording.Frames[ReplayFrameIndex].HeldActions;
+		const uint32 ChangedActions = HeldActions ^ ReplayHeldActions;
+		for (int32 Index = 0; Index < Recording.ActionNames.Num(); ++Index)
+		{
+			if (ChangedActions & (1u << Index))
+				ExecuteAction(Recording.ActionNames[Index], (HeldActions & (1u << Index)) != 0);
+		}
+
+		ReplayHeldActions = HeldActions;
+	}
+
+	if (ReplayFrameIndex == INDEX_NONE)
+		return;
+
+	const FExtCharacterInputFrame& Frame = Recording.Frames[ReplayFrameIndex];
+
+	if (AController* Controller = ExtCharacterOwner->GetController())
+		Controller->SetControlRotation(Frame.ControlRotation);
+
+	// Axes are fed to their bound handlers the same way UPlayerInput would
+	UInputComponent* Input = ExtCharacterOwner->InputComponent;
+	for (FInputAxisBinding& Binding : Input->AxisBindings)
+	{
+		const int32 AxisIndex = Recording.AxisNames.IndexOfByKey(Binding.AxisName);
+		Binding.AxisValue = Frame.AxisValues.IsValidIndex(AxisIndex) ? Frame.AxisValues[AxisIndex] : 0.f;
+		Binding.AxisDelegate.Execute(Binding.AxisValue);
+	}
+}
+
+void UExtCharacterInputRecorderComponent::ApplyInitialState()
+{
+	UExtCharacterMovementComponent* MovementComponent = ExtCharacterOwner->GetExtCharacterMovement();
+	check(MovementComponent);
+
+	const FExtCharacterInputFrame& Frame = Recording.Frames[0];
+
+	ExtCharacterOwner->SetActorLocationAndRotation(Frame.Movement.Location, Frame.Movement.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	MovementComponent->SetMovementMode((EMovementMode)Recording.MovementMode);
+	MovementComponent->Velocity = Frame.Movement.Velocity;
+
+	if (AController* Controller = ExtCharacterOwner->GetController())
+		Controller->SetControlRotation(Frame.ControlRotation);
+
+	ExtCharacterOwner->SetRotationMode(Recording.RotationMode);
+
+	if (Recording.bIsCrouched)
+		ExtCharacterOwner->Crouch();
+	else
+		ExtCharacterOwner->UnCrouch();
+
+	if (Recording.bIsWalkingInsteadOfRunning)
+		ExtCharacterOwner->Walk();
+	else
+		ExtCharacterOwner->UnWalk();
+
+	if (Recording.bIsSprinting)
+		ExtCharacterOwner->Sprint();
+	else
+		ExtCharacterOwner->UnSprint();
+}
+
+void UExtCharacterInputRecorderComponent::ExecuteAction(FName ActionName, bool bPressed)
+{
+	UInputComponent* Input = ExtCharacterOwner->InputComponent;
+	if (!Input)
+		return;
+
+	const EInputEvent KeyEvent = bPressed ? IE_Pressed : IE_Released;
+	for (int32 Index = 0; Index < Input->GetNumActionBindings(); ++Index)
+	{
+		FInputActionBinding& Binding = Input->GetActionBinding(Index);
+		if (Binding.GetActionName() == ActionName && Binding.KeyEvent == KeyEvent)
+			Binding.ActionDelegate.Execute(EKeys::Invalid);
+	}
+}
+
+void UExtCharacterInputRecorderComponent::CompareFrame()
+{
+	const FRepExtMovement Recorded = Recording.SampleMovement(Time);
+
+	FRepExtMovement Current;
+	GatherMovement(Current);
+
+	const float LocationError = FVector::Dist(Current.Location, Recorded.Location);
+	const float RotationError = FMath::RadiansToDegrees(Current.Rotation.Quaternion().AngularDistance(Recorded.Rotation.Quaternion()));
+	const float VelocityError = FVector::Dist(Current.Velocity, Recorded.Velocity);
+
+	ReplayResult.Frames++;
+	ReplayResult.MaxLocationError = FMath::Max(ReplayResult.MaxLocationError, LocationError);
+	ReplayResult.MaxRotationError = FMath::Max(ReplayResult.MaxRotationError, RotationError);
+	ReplayResult.MaxVelocityError = FMath::Max(ReplayResult.MaxVelocityError, VelocityError);
+	ReplayLocationErrorSum += LocationError;
+
+	if (LocationError > LocationTolerance && ReplayResult.IsMatch())
+	{
+		ReplayResult.DivergenceTime = Time;
+		UE_LOG(LogExtCharacterInputRecorder, Warning, TEXT("Replay of '%s' diverged at %.3fs by %.3f (recorded %s, replayed %s)."),
+			*RecordingName, Time, LocationError, *Recorded.Location.ToString(), *Current.Location.ToString());
+	}
+}
@@ -2,7 +2,10 @@
 
 #include "GameFramework/ExtCharacterMovementComponent.h"
 #include "GameFramework/ExtCharacter.h"
+#include "GameFramework/CrowdMovementManager.h"
+#include "GameFramework/LedgeMapVolume.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/PhysicsVolume.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SkeletalMeshComponent.h"
@@ -10,6 +13,7 @@
 #include "Navigation/PathFollowingComponent.h"
 #include "Net/UnrealNetwork.h"
 #include "Engine/NetworkObjectList.h"
+#include "Engine/World.h"
 #include "PhysicsEngine/ConstraintInstance.h"
 #include "Curves/CurveFloat.h"
 
@@ -18,9 +22,34 @@
 
 #include "DrawDebugHelpers.h"
 #include "ExtraMacros.h"
+#include "ExtraStats.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogExtCharacterMovement, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("ExtCharacterMovement"), STATGROUP_ExtCharacterMovement, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Client Replay Moves"), STAT_ExtCharacterMovement_ClientReplay, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Client Corrections"), STAT_ExtCharacterMovement_ClientCorrections, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Client Replayed Moves"), STAT_ExtCharacterMovement_ClientReplayedMoves, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Saved Move Pool Allocations"), STAT_ExtCharacterMovement_MovePoolAllocations, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Saved Move Heap Allocations"), STAT_ExtCharacterMovement_MoveHeapAllocations, STATGROUP_ExtCharacterMovement);
+DECLARE_CYCLE_STAT(TEXT("Landing Prediction"), STAT_ExtCharacterMovement_LandingPrediction, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Batched Velocity Hits"), STAT_ExtCharacterMovement_CrowdVelocityHits, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Batched Velocity Misses"), STAT_ExtCharacterMovement_CrowdVelocityMisses, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Batched Rotation Hits"), STAT_ExtCharacterMovement_CrowdRotationHits, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Sweeps"), STAT_ExtCharacterMovement_FloorSweeps, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Cache Hits"), STAT_ExtCharacterMovement_FloorCacheHits, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Prefetches"), STAT_ExtCharacterMovement_FloorPrefetches, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ledge Sweeps"), STAT_ExtCharacterMovement_LedgeSweeps, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ledge Map Hits"), STAT_ExtCharacterMovement_LedgeMapHits, STATGROUP_ExtCharacterMovement);
+DECLARE_CYCLE_STAT(TEXT("Tick Full Physics"), STAT_ExtCharacterMovement_TickFull, STATGROUP_ExtCharacterMovement);
+DECLARE_CYCLE_STAT(TEXT("Tick Movement LOD"), STAT_ExtCharacterMovement_TickLOD, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Full Physics"), STAT_ExtCharacterMovement_NumFull, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Movement LOD"), STAT_ExtCharacterMovement_NumLOD, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Sleeping"), STAT_ExtCharacterMovement_NumSleeping, STATGROUP_ExtCharacterMovement);
+DECLARE_CYCLE_STAT(TEXT("Tick Fixed Timestep"), STAT_ExtCharacterMovement_TickFixed, STATGROUP_ExtCharacterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Timesteps"), STAT_ExtCharacterMovement_FixedSteps, STATGROUP_ExtCharacterMovement);
+
 FORCEINLINE static int32 GetCVarNetEnableSkipProxyPredictionOnNetUpdate()
 {
 	static const auto CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("p.NetEnableSkipProxyPredictionOnNetUpdate"));
@@ -35,6 +64,20 @@ FMovementPropertiesEx::FMovementPropertiesEx() :
 {
 }
 
+FMovementParametersOverride::FMovementParametersOverride() :
+	MovementMode(MOVE_Walking),
+	Condition(EMovementParameterCondition::Default),
+	bOverride_MaxSpeed(false),
+	bOverride_MaxAcceleration(false),
+	bOverride_BrakingDeceleration(false),
+	bOverride_BrakingFrictionFactor(false),
+	MaxSpeed(0.f),
+	MaxAcceleration(0.f),
+	BrakingDeceleration(0.f),
+	BrakingFrictionFactor(0.f)
+{
+}
+
 #if WITH_EDITOR
 const FName UExtCharacterMovementComponent::NAME_TurnInPlaceTargetYaw_None(TEXT("None"));
 const FName UExtCharacterMovementComponent::NAME_TurnInPlaceTargetYaw_Suspended(TEXT("Suspended"));
@@ -42,6 +85,8 @@ const FName UExtCharacterMovementComponent::NAME_TurnInPlaceTargetYaw_Suspended(
 
 const float UExtCharacterMovementComponent::AngleTolerance = 1e-3f;
 
+uint32 UExtCharacterMovementComponent::FloorCacheGeneration = 0;
+
 UExtCharacterMovementComponent::UExtCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -75,6 +120,49 @@ UExtCharacterMovementComponent::UExtCharacterMovementComponent(const FObjectInit
 	// Character shouldn't normally accelerate when falling (contribution of gravity is not affected by this property)
 	MaxFallingAcceleration = 0.f;
 
+	// Landing Prediction
+	bEnableLandingPrediction = true;
+	LandingPredictionMaxTime = 2.0f;
+	LandingPredictionSweepCount = 4;
+	LandingPredictionVelocityTolerance = 50.f;
+	LandingPredictionTimeToLand = -1.f;
+	PredictedLandingNormal = FVector::UpVector;
+
+	// Crowd Movement
+	bUseCrowdMovementManager = false;
+	CrowdBatchIndex = INDEX_NONE;
+	bEnableCrowdAvoidance = false;
+	CrowdAvoidanceRadius = 0.f;
+	CrowdAvoidancePriority = 1.f;
+	CrowdAvoidanceTimeHorizon = 0.5f;
+
+	// Floor Cache
+	bEnableFloorCache = true;
+	bUseLedgeMap = true;
+	FloorCacheTolerance = 0.5f;
+	CachedFloorGeneration = 0;
+
+	// Movement LOD
+	bEnableMovementLOD = false;
+	MovementLODDistance = 5000.f;
+	MovementLODHysteresis = 500.f;
+	MovementLODCheckInterval = 0.5f;
+	MovementLODTimeCounter = 0.f;
+
+	// Sleep
+	bEnableSleep = false;
+	SleepDelay = 2.0f;
+	SleepTickInterval = 0.5f;
+	SleepTimeCounter = 0.f;
+
+	// Fixed Timestep
+	bUseFixedTimestep = false;
+	FixedTimestep = 1.f / 60.f;
+	MaxFixedTimestepIterations = 4;
+	FixedTimestepAccumulator = 0.f;
+	FixedTimestepPrevLocation = FVector::ZeroVector;
+	FixedTimestepPrevRotation = FQuat::Identity;
+
 	// Max Speed
 	MaxWalkSpeed = 400.f;
 
@@ -105,6 +193,8 @@ UExtCharacterMovementComponent::UExtCharacterMovementComponent(const FObjectInit
 	BrakingSpeedTolerance = 1.f; 
 
 	// Rotation Settings
+	bUseQuaternionRotation = false;
+	CharacterUpVector = FVector::UpVector;
 	RotationRateFactor = 1.0f;
 	bInterpolateToTargetRotation = false;
 	LookAngleThreshold = 60.0f;
@@ -136,6 +226,10 @@ UExtCharacterMovementComponent::UExtCharacterMovementComponent(const FObjectInit
 	bCanWalkOffLedgesWhenRunning = true;
 	bCanWalkOffLedgesWhenSprinting = true;
 	bCanWalkOffLedgesWhenPerformingGenericAction = true;
+
+	// Movement Parameters
+	MaxFallingGroundSpeed = 0.f;
+	RebuildMovementParameterTable();
 }
 
 #if WITH_EDITOR
@@ -161,6 +255,13 @@ bool UExtCharacterMovementComponent::CanEditChange(const UProperty* InProperty)
 	return bCanChange;
 }
 
+void UExtCharacterMovementComponent::PostEditChangeProperty(struct FPropertyChangedEvent& e)
+{
+	Super::PostEditChangeProperty(e);
+
+	RebuildMovementParameterTable();
+}
+
 #endif
 
 void UExtCharacterMovementComponent::PostLoad()
@@ -168,6 +269,8 @@ void UExtCharacterMovementComponent::PostLoad()
 	Super::PostLoad();
 
 	ExtCharacterOwner = Cast<AExtCharacter>(CharacterOwner);
+
+	RebuildMovementParameterTable();
 }
 
 void UExtCharacterMovementComponent::SetUpdatedComponent(USceneComponent* NewUpdatedComponent)
@@ -183,12 +286,76 @@ void UExtCharacterMovementComponent::BeginPlay()
 
 	ResetMoveState();
 	ResetExtraMoveState();
+	RebuildMovementParameterTable();
+
+	// Only AI on the server can be batched but the controller may change later on so this is checked again every frame.
+	if (bUseCrowdMovementManager && GetOwnerRole() == ROLE_Authority)
+	{
+		CrowdMovementManager = ACrowdMovementManager::Get(GetWorld());
+		if (CrowdMovementManager)
+			CrowdMovementManager->Register(this);
+	}
+}
+
+void UExtCharacterMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (CrowdMovementManager)
+	{
+		if (UActorComponent* PrerequisiteComponent = CrowdTickPrerequisiteComponent.Get())
+			CrowdMovementManager->PrimaryActorTick.RemovePrerequisite(PrerequisiteComponent, PrerequisiteComponent->PrimaryComponentTick);
+
+		CrowdTickPrerequisiteController = nullptr;
+		CrowdTickPrerequisiteComponent = nullptr;
+
+		CrowdMovementManager->Unregister(this);
+		CrowdMovementManager = nullptr;
+	}
+
+	CrowdBatchIndex = INDEX_NONE;
+
+	Super::EndPlay(EndPlayReason);
 }
 
 
 void UExtCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(Movement, ExtCharacterOwner ? &ExtCharacterOwner->GetBenchmarkCycles() : nullptr);
+
+	UpdateSleepState(DeltaTime);
+
+	if (bIsSleeping)
+	{
+		INC_DWORD_STAT(STAT_ExtCharacterMovement_NumSleeping);
+
+		SleepTimeCounter += DeltaTime;
+		if (SleepTimeCounter < SleepTickInterval)
+			return;
+
+		SleepTimeCounter = 0.f;
+	}
+
+	UpdateMovementLOD(DeltaTime);
+
+	const bool bFixedTimestep = bUseFixedTimestep && !bIsMovementLODActive && CanUseFixedTimestepInCurrentState();
+	if (!bFixedTimestep && bHasFixedTimestepVisualOffset)
+		ResetFixedTimestep();
+
+	if (bFixedTimestep)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ExtCharacterMovement_TickFixed);
+		TickFixedTimestep(DeltaTime, TickType, ThisTickFunction);
+	}
+	else
+	{
+		// Movement LOD and full physics only differ in the movement mode, they are just accounted apart
+		FScopeCycleCounter CycleCounter(bIsMovementLODActive ? GET_STATID(STAT_ExtCharacterMovement_TickLOD) : GET_STATID(STAT_ExtCharacterMovement_TickFull));
+		if (bIsMovementLODActive)
+			INC_DWORD_STAT(STAT_ExtCharacterMovement_NumLOD);
+		else
+			INC_DWORD_STAT(STAT_ExtCharacterMovement_NumFull);
+
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	}
 
 #if WITH_EDITOR
 	TurnInPlaceTargetYawDisplayText = FMath::IsFinite(TurnInPlaceTargetYaw) ? FString::SanitizeFloat(TurnInPlaceTargetYaw) :
@@ -196,6 +363,195 @@ void UExtCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelT
 #endif
 }
 
+/// Sleep
+
+bool UExtCharacterMovementComponent::CanSleepInCurrentState() const
+{
+	if (!HasValidData() || !ExtCharacterOwner)
+		return false;
+
+	if (CharacterOwner->Role == ROLE_AutonomousProxy || (CharacterOwner->IsLocallyControlled() && CharacterOwner->IsPlayerControlled()))
+		return false;
+
+	if (!IsMovingOnGround() || ExtCharacterOwner->IsRagdoll() || ExtCharacterOwner->IsGettingUp() || ExtCharacterOwner->IsLanding())
+		return false;
+
+	if (!Velocity.IsZero() || !Acceleration.IsZero() || !GetPendingInputVector().IsZero() || bHasRequestedVelocity || CharacterOwner->bPressedJump)
+		return false;
+
+	if (!PendingImpulseToApply.IsZero() || !PendingForceToApply.IsZero() || !PendingLaunchVelocity.IsZero())
+		return false;
+
+	if (HasAnimRootMotion() || CurrentRootMotion.HasActiveRootMotionSources() || bIsPivotTurning || FMath::IsFinite(TurnInPlaceTargetYaw))
+		return false;
+
+	// Moving bases would carry the character without notice
+	const UPrimitiveComponent* Base = GetMovementBase();
+	if (Base && Base->Mobility != EComponentMobility::Static)
+		return false;
+
+	// Pending state changes are only known on the authority, simulated proxies are woken up by the character when replicated state changes.
+	if (CharacterOwner->Role == ROLE_Authority
+		&& (bWantsToCrouch != IsCrouching()
+		|| bWantsToWalkInsteadOfRun != ExtCharacterOwner->bIsWalkingInsteadOfRunning
+		|| bWantsToSprint != ExtCharacterOwner->bIsSprinting
+		|| bWantsToPerformGenericAction != ExtCharacterOwner->bIsPerformingGenericAction))
+		return false;
+
+	return true;
+}
+
+void UExtCharacterMovementComponent::UpdateSleepState(float DeltaSeconds)
+{
+	// Look rotation is taken from the control rotation by movement updates, so while asleep only the control rotation changes unless replicated
+	if (!bEnableSleep || !CanSleepInCurrentState() 
+		|| (bIsSleeping && !(CharacterOwner->Role >= ROLE_AutonomousProxy ? CharacterOwner->GetControlRotation() : ExtCharacterOwner->GetLookRotation()).Equals(SleepLookRotation, AngleTolerance)))
+	{
+		WakeUp();
+		return;
+	}
+
+	if (!bIsSleeping)
+	{
+		SleepTimeCounter += DeltaSeconds;
+		if (SleepTimeCounter >= SleepDelay)
+		{
+			bIsSleeping = true;
+			SleepTimeCounter = 0.f;
+			SleepLookRotation = ExtCharacterOwner->GetLookRotation();
+		}
+	}
+}
+
+void UExtCharacterMovementComponent::WakeUp()
+{
+	bIsSleeping = false;
+	SleepTimeCounter = 0.f;
+}
+
+void UExtCharacterMovementComponent::NotifyLocomotionStateChanged()
+{
+	WakeUp();
+	PublishLocomotionSnapshot();
+}
+
+void UExtCharacterMovementComponent::AddInputVector(FVector WorldVector, bool bForce)
+{
+	if (!WorldVector.IsZero())
+		WakeUp();
+
+	Super::AddInputVector(WorldVector, bForce);
+}
+
+void UExtCharacterMovementComponent::AddImpulse(FVector Impulse, bool bVelocityChange)
+{
+	WakeUp();
+
+	Super::AddImpulse(Impulse, bVelocityChange);
+}
+
+void UExtCharacterMovementComponent::AddForce(FVector Force)
+{
+	WakeUp();
+
+	Super::AddForce(Force);
+}
+
+void UExtCharacterMovementComponent::Launch(FVector const& LaunchVel)
+{
+	WakeUp();
+
+	Super::Launch(LaunchVel);
+}
+
+void UExtCharacterMovementComponent::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+	WakeUp();
+
+	Super::RequestDirectMove(MoveVelocity, bForceMaxSpeed);
+}
+
+void UExtCharacterMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
+{
+	WakeUp();
+
+	Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+}
+
+
+
+/// Fixed Timestep
+
+bool UExtCharacterMovementComponent::CanUseFixedTimestepInCurrentState() const
+{
+	if (FixedTimestep <= 0.f || !HasValidData())
+		return false;
+
+	// Moves of remote players are performed by the server when they arrive and simulated proxies are smoothed instead.
+	return CharacterOwner->IsLocallyControlled() || (CharacterOwner->Role == ROLE_Authority && !CharacterOwner->IsPlayerControlled());
+}
+
+void UExtCharacterMovementComponent::TickFixedTimestep(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	FixedTimestepAccumulator = FMath::Min(FixedTimestepAccumulator + DeltaTime, FixedTimestep * FMath::Max(MaxFixedTimestepIterations, 1));
+
+	// Each step consumes the input vector so the input of this frame is captured once and fed to every step.
+	// Input of a frame without steps is dropped, it is added again the next frame.
+	const FVector InputVector = ConsumeInputVector();
+
+	while (FixedTimestepAccumulator >= FixedTimestep)
+	{
+		FixedTimestepAccumulator -= FixedTimestep;
+		INC_DWORD_STAT(STAT_ExtCharacterMovement_FixedSteps);
+
+		FixedTimestepPrevLocation = UpdatedComponent->GetComponentLocation();
+		FixedTimestepPrevRotation = UpdatedComponent->GetComponentQuat();
+
+		// Bypass our override, restoring input must not wake up the character
+		Super::AddInputVector(InputVector, true);
+		Super::TickComponent(FixedTimestep, TickType, ThisTickFunction);
+
+		// Don't interpolate across teleports
+		if (bJustTeleported)
+		{
+			FixedTimestepPrevLocation = UpdatedComponent->GetComponentLocation();
+			FixedTimestepPrevRotation = UpdatedComponent->GetComponentQuat();
+		}
+	}
+
+	UpdateFixedTimestepVisuals(FixedTimestepAccumulator / FixedTimestep);
+}
+
+void UExtCharacterMovementComponent::UpdateFixedTimestepVisuals(float Alpha)
+{
+	USkeletalMeshComponent* Mesh = CharacterOwner->GetMesh();
+	if (!Mesh || Mesh->IsSimulatingPhysics() || Mesh->GetAttachParent() != UpdatedComponent)
+		return;
+
+	// The mesh trails the simulated capsule by the fraction of a step that has not been simulated yet
+	const FTransform& Current = UpdatedComponent->GetComponentTransform();
+	const FVector TranslationOffset = FMath::Lerp(FixedTimestepPrevLocation, Current.GetLocation(), Alpha) - Current.GetLocation();
+	const FQuat RotationOffset = Current.GetRotation().Inverse() * FQuat::Slerp(FixedTimestepPrevRotation, Current.GetRotation(), Alpha);
+
+	Mesh->SetRelativeLocationAndRotation(
+		Current.InverseTransformVectorNoScale(TranslationOffset) + CharacterOwner->GetBaseTranslationOffset(),
+		RotationOffset * CharacterOwner->GetBaseRotationOffset());
+
+	bHasFixedTimestepVisualOffset = true;
+}
+
+void UExtCharacterMovementComponent::ResetFixedTimestep()
+{
+	FixedTimestepAccumulator = 0.f;
+
+	USkeletalMeshComponent* Mesh = CharacterOwner ? CharacterOwner->GetMesh() : nullptr;
+	if (Mesh && !Mesh->IsSimulatingPhysics() && Mesh->GetAttachParent() == UpdatedComponent)
+		Mesh->SetRelativeLocationAndRotation(CharacterOwner->GetBaseTranslationOffset(), CharacterOwner->GetBaseRotationOffset());
+
+	bHasFixedTimestepVisualOffset = false;
+}
+
+
 /// Replication
 
 
@@ -223,19 +579,9 @@ void UExtCharacterMovementComponent::SetReplicatedTurnInPlace(float InTurnInPlac
 
 /// Movement Update
 
-void UExtCharacterMovementComponent::ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration)
+FORCEINLINE static void ApplyBraking(FVector& Velocity, float DeltaTime, float Friction, float FrictionFactor, float BrakingDeceleration, float SpeedTolerance)
 {
-	// Full override to let speed tolerance be configurable possibly to a higher value than the originally hardcoded 0.1mm/s.
-	// After all perception of movement depends on several things including environment scale, camera distance, etc.
-	FULL_OVERRIDE();
-
-	if (Velocity.IsZero() || !HasValidData() || HasAnimRootMotion() || DeltaTime < MIN_TICK_TIME)
-	{
-		return;
-	}
-
-	const float FrictionFactor = FMath::Max(0.f, GetBrakingFrictionFactor());
-	Friction = FMath::Max(0.f, Friction * FrictionFactor);
+	Friction = FMath::Max(0.f, Friction * FMath::Max(0.f, FrictionFactor));
 	BrakingDeceleration = FMath::Max(0.f, BrakingDeceleration);
 	const bool bZeroFriction = (Friction == 0.f);
 	const bool bZeroBraking = (BrakingDeceleration == 0.f);
@@ -273,12 +619,69 @@ void UExtCharacterMovementComponent::ApplyVelocityBraking(float DeltaTime, float
 
 	// Clamp to zero if nearly zero, or if below min threshold and braking.
 	const float VSizeSq = Velocity.SizeSquared();
-	if (VSizeSq <= FMath::Square(BrakingSpeedTolerance) || (!bZeroBraking && VSizeSq <= (BRAKE_TO_STOP_VELOCITY * BRAKE_TO_STOP_VELOCITY)))
+	if (VSizeSq <= FMath::Square(SpeedTolerance) || (!bZeroBraking && VSizeSq <= (BRAKE_TO_STOP_VELOCITY * BRAKE_TO_STOP_VELOCITY)))
 	{
 		Velocity = FVector::ZeroVector;
 	}
 }
 
+void UExtCharacterMovementComponent::ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration)
+{
+	// Full override to let speed tolerance be configurable possibly to a higher value than the originally hardcoded 0.1mm/s.
+	// After all perception of movement depends on several things including environment scale, camera distance, etc.
+	FULL_OVERRIDE();
+
+	if (Velocity.IsZero() || !HasValidData() || HasAnimRootMotion() || DeltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	ApplyBraking(Velocity, DeltaTime, Friction, GetBrakingFrictionFactor(), BrakingDeceleration, BrakingSpeedTolerance);
+}
+
+void UExtCharacterMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
+{
+	// Use the velocity computed by the crowd movement manager if the inputs it was computed from are the ones we'd have used. 
+	// Movement settings behind max speed, acceleration and braking were sampled when the manager gathered the batch earlier this frame.
+	if (CrowdBatchIndex != INDEX_NONE && !bHasCrowdBatchedVelocity)
+	{
+		check(CrowdMovementManager);
+		const FCrowdMovementBatch& Batch = CrowdMovementManager->GetBatch();
+		const int32 Index = CrowdBatchIndex;
+		if (Batch.Components.IsValidIndex(Index) && Batch.Components[Index] == this
+			&& !bFluid
+			&& !bForceMaxAccel
+			&& !bUseRVOAvoidance
+			&& !HasAnimRootMotion()
+			&& Acceleration == Batch.Accelerations[Index]
+			&& bHasRequestedVelocity == ((Batch.Flags[Index] & FCrowdMovementBatch::FLAG_RequestedVelocity) != 0)
+			&& (!bHasRequestedVelocity || RequestedVelocity == Batch.RequestedVelocities[Index]))
+		{
+			// Crowd avoidance steers the input acceleration and the requested velocity, and applies even if the velocity has to be computed here
+			Acceleration = Batch.OutAccelerations[Index];
+			if (bHasRequestedVelocity)
+				RequestedVelocity = Batch.OutRequestedVelocities[Index];
+
+			if (DeltaTime == Batch.DeltaTimes[Index]
+				&& FMath::Max(0.f, Friction) == Batch.Frictions[Index]
+				&& BrakingDeceleration == Batch.BrakingDecelerations[Index]
+				&& Velocity == Batch.Velocities[Index]
+				&& AnalogInputModifier == Batch.AnalogInputModifiers[Index])
+			{
+				INC_DWORD_STAT(STAT_ExtCharacterMovement_CrowdVelocityHits);
+				bHasCrowdBatchedVelocity = true;
+				Velocity = Batch.OutVelocities[Index];
+				return;
+			}
+		}
+
+		INC_DWORD_STAT(STAT_ExtCharacterMovement_CrowdVelocityMisses);
+		CrowdBatchIndex = INDEX_NONE;
+	}
+
+	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+}
+
 void UExtCharacterMovementComponent::SimulateMovement(float DeltaSeconds)
 {
 	// Full override needed because original implementation sets Acceleration to Velocity normal but we want to use the SimulatedAcceleration
@@ -480,18 +883,100 @@ void UExtCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const
 		LastAcceleratedVelocity = Velocity;
 	}
 
-	// Calculate Drift
-	if (USkeletalMeshComponent* Mesh = ExtCharacterOwner->GetMesh())
-	{
-		const FRotator MeshOrientation = (Mesh->GetComponentQuat() * ExtCharacterOwner->GetBaseRotationOffset().Inverse()).Rotator();
-		MovementDrift = FMath::FindDeltaAngleDegrees(MeshOrientation.Yaw, LastMovementVelocity.Rotation().Yaw);
-	}
-	else
+	// Calculate Drift. Nothing can turn a sleeping character so drift is left as is.
+	if (!bIsSleeping)
 	{
-		MovementDrift = 0.f;
+		if (USkeletalMeshComponent* Mesh = ExtCharacterOwner->GetMesh())
+		{
+			const FRotator MeshOrientation = (Mesh->GetComponentQuat() * ExtCharacterOwner->GetBaseRotationOffset().Inverse()).Rotator();
+			MovementDrift = FMath::FindDeltaAngleDegrees(MeshOrientation.Yaw, LastMovementVelocity.Rotation().Yaw);
+		}
+		else
+		{
+			MovementDrift = 0.f;
+		}
 	}
 
+	if (MovementMode == MOVE_Falling)
+		UpdateLandingPrediction();
+
 	ExtCharacterOwner->OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	// Published last so the character state changed by the movement update is included
+	PublishLocomotionSnapshot();
+}
+
+void UExtCharacterMovementComponent::FillLocomotionSnapshot(FExtLocomotionSnapshot& Snapshot) const
+{
+	Snapshot.bIsJumping = ExtCharacterOwner->bIsJumping;
+	Snapshot.bIsCrouched = ExtCharacterOwner->bIsCrouched;
+	Snapshot.bIsPerformingGenericAction = ExtCharacterOwner->bIsPerformingGenericAction;
+	Snapshot.bIsRagdoll = ExtCharacterOwner->IsRagdoll();
+	Snapshot.bIsGettingUp = ExtCharacterOwner->IsGettingUp();
+	Snapshot.bEnableFootIK = ExtCharacterOwner->bEnableFootIK;
+	Snapshot.bIsPivotTurning = bIsPivotTurning;
+	Snapshot.bIsLandingPredicted = IsLandingPredicted();
+	Snapshot.bIsSleeping = bIsSleeping;
+
+	Snapshot.MovementMode = MovementMode;
+	Snapshot.CustomMovementMode = CustomMovementMode;
+	Snapshot.Gait = ExtCharacterOwner->GetGait();
+	Snapshot.RotationMode = ExtCharacterOwner->GetRotationMode();
+	Snapshot.TurnInPlaceState = GetTurnInPlaceState();
+
+	Snapshot.MovementDrift = MovementDrift;
+	Snapshot.TurnInPlaceTargetYaw = TurnInPlaceTargetYaw;
+	Snapshot.GetUpDelay = ExtCharacterOwner->GetUpDelay;
+	Snapshot.TimeToLand = Snapshot.bIsLandingPredicted ? GetTimeToLand() : -1.f;
+
+	Snapshot.Location = ExtCharacterOwner->GetActorLocation();
+	Snapshot.Rotation = ExtCharacterOwner->GetActorRotation();
+	Snapshot.LookRotation = ExtCharacterOwner->GetLookRotation();
+
+	Snapshot.Velocity = Velocity;
+	Snapshot.Acceleration = Acceleration;
+	Snapshot.LastMovementAcceleration = LastMovementAcceleration;
+	Snapshot.LandingLocation = Snapshot.bIsLandingPredicted ? PredictedLandingLocation : Snapshot.Location;
+	Snapshot.LandingNormal = Snapshot.bIsLandingPredicted ? PredictedLandingNormal : FVector::UpVector;
+}
+
+void UExtCharacterMovementComponent::PublishLocomotionSnapshot()
+{
+	if (!ExtCharacterOwner)
+		return;
+
+	// Publish N writes buffer N & 1, the one not holding the latest snapshot
+	const int32 Index = NumLocomotionSnapshotsStarted.Increment() - 1;
+	FPlatformMisc::MemoryBarrier();
+
+	FExtLocomotionSnapshot& Snapshot = LocomotionSnapshots[Index & 1];
+	FillLocomotionSnapshot(Snapshot);
+
+	// Stops are only predicted when braking or reversing on the ground, the cases animation matches against
+	float StopTime;
+	Snapshot.bIsStopPredicted = IsMovingOnGround() && Velocity.SizeSquared2D() > KINDA_SMALL_NUMBER && (Acceleration | Velocity) <= 0.f
+		&& PredictStop(Snapshot.StopLocation, StopTime, Snapshot.StopDistance);
+
+	FPlatformMisc::MemoryBarrier();
+	NumLocomotionSnapshots.Set(Index + 1);
+}
+
+bool UExtCharacterMovementComponent::ReadLocomotionSnapshot(FExtLocomotionSnapshot& OutSnapshot) const
+{
+	for (;;)
+	{
+		const int32 Count = NumLocomotionSnapshots.GetValue();
+		if (Count == 0)
+			return false;
+
+		FPlatformMisc::MemoryBarrier();
+		OutSnapshot = LocomotionSnapshots[(Count - 1) & 1];
+		FPlatformMisc::MemoryBarrier();
+
+		// The buffer copied is only written again by publish Count + 1
+		if (NumLocomotionSnapshotsStarted.GetValue() <= Count + 1)
+			return true;
+	}
 }
 
 void UExtCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
@@ -508,6 +993,18 @@ void UExtCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previou
 		bIsPivotTurning = false;
 	}
 
+	// Landing prediction is only valid for the fall it was computed for.
+	bHasLandingPrediction = false;
+
+	// Floor found in one mode is not necessarily valid for another
+	bHasCachedFloor = false;
+
+	WakeUp();
+
+	// Movement LOD is only active while nav walking
+	if (MovementMode != MOVE_NavWalking)
+		bIsMovementLODActive = false;
+
 	switch (MovementMode)
 	{
 	case MOVE_Walking:
@@ -519,6 +1016,7 @@ void UExtCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previou
 		MaxAcceleration = MaxFallingAcceleration;
 		// Save last ground speed as max falling speed to prevent accelerating in mid air.
 		MaxFallingGroundSpeed = Velocity.Size2D();
+		RebuildMovementParameterTable();
 		// Set fall rotation to be the movement direction or default to the character's rotation
 		FallRotation = CharacterOwner->GetActorRotation();
 		// Reset LookCardinalDirection
@@ -526,6 +1024,8 @@ void UExtCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previou
 		break;
 	}
 
+	UpdateMovementParameterKey();
+
 	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
 };
 
@@ -570,12 +1070,13 @@ void UExtCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float De
 		Sprint(false);
 	}
 
+	MaxAcceleration = GetMaxModeAcceleration();
+
 	switch (MovementMode)
 	{
 	case MOVE_Walking:
 	case MOVE_NavWalking:
 		{
-			MaxAcceleration = MaxWalkAcceleration;
 			GroundFriction = WalkFriction;
 
 			// Calculate the cosine of the shortest angle between Velocity and Acceleration. It indicates how aligned the vectors are in the range [+1, -1]
@@ -622,19 +1123,14 @@ void UExtCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float De
 			SkipPivotTurnAdjusts: void(0);
 		}
 		break;
-	case MOVE_Falling:
-		MaxAcceleration = MaxFallingAcceleration;
-		break;
 	case MOVE_Swimming:
-		MaxAcceleration = MaxSwimAcceleration;
 		// TODO: Implement buoyancy if swimming in ragdoll (increased linear/angular damp and counter gravity accel)
 		break;
 	case MOVE_Flying:
-		MaxAcceleration = MaxFlyAcceleration;
 		// TODO: Implement zero gravity if flying in ragdoll (counter the gravity accel)
 		break;
 	default:
-		MaxAcceleration = 0.f;
+		break;
 	}
 
 	// Call character
@@ -674,74 +1170,155 @@ void UExtCharacterMovementComponent::UpdateCharacterStateAfterMovement(float Del
 
 /// Speed, Acceleration and Deceleration
 
-float UExtCharacterMovementComponent::GetMaxSpeed() const
+FORCEINLINE uint32 UExtCharacterMovementComponent::GetMovementParameterKey() const
 {
-	// Full override to support different max speeds for each movement mode including a ground speed limit for falling.
-	FULL_OVERRIDE();
-
-	switch (MovementMode)
-	{
-	case MOVE_Walking:
-	case MOVE_NavWalking:
-		return MaxWalkSpeed;
-	case MOVE_Falling:
-		return MaxFallingGroundSpeed;
-	case MOVE_Swimming:
-		return MaxSwimSpeed;
-	case MOVE_Flying:
-		return MaxFlySpeed;
-	case MOVE_Custom:
-		return MaxCustomMovementSpeed;
-	default:
-		return 0.f;
-	}
+	// Ragdoll rows are duplicated for landing so both flags can be packed without branching.
+	const uint32 Condition = ExtCharacterOwner ? (uint32(ExtCharacterOwner->IsLanding()) | (uint32(ExtCharacterOwner->IsRagdoll()) << 1)) : 0;
+	return (uint32(MovementMode.GetValue()) & 0x7) | (Condition << 3);
 }
 
-FVector UExtCharacterMovementComponent::ScaleInputAcceleration(const FVector& InputAcceleration) const
+void FMovementParameters::Apply(const FMovementParametersOverride& Override)
 {
-	return Super::ScaleInputAcceleration(InputAcceleration) * InputAccelerationScale;
-}
+	if (Override.bOverride_MaxSpeed)
+		MaxSpeed = Override.MaxSpeed;
 
-float UExtCharacterMovementComponent::GetMaxBrakingDeceleration() const
-{
-	FULL_OVERRIDE();
+	if (Override.bOverride_MaxAcceleration)
+		MaxAcceleration = Override.MaxAcceleration;
 
-	check(ExtCharacterOwner);
-	if (ExtCharacterOwner->IsRagdoll())
-		return BrakingDecelerationRagdoll;
+	if (Override.bOverride_BrakingDeceleration)
+		BrakingDeceleration = Override.BrakingDeceleration;
 
-	if (ExtCharacterOwner->IsLanding())
-		return BrakingDecelerationLanding;
+	if (Override.bOverride_BrakingFrictionFactor)
+		BrakingFrictionFactor = Override.BrakingFrictionFactor;
+}
 
-	switch (MovementMode)
+FMovementParameters UExtCharacterMovementComponent::GetSettingsMovementParameters(EMovementMode Mode, EMovementParameterCondition Condition) const
+{
+	FMovementParameters Parameters;
+
+	switch (Mode)
 	{
 	case MOVE_Walking:
 	case MOVE_NavWalking:
-		return BrakingDecelerationWalking;
+		Parameters.MaxSpeed = MaxWalkSpeed;
+		Parameters.MaxAcceleration = MaxWalkAcceleration;
+		Parameters.BrakingDeceleration = BrakingDecelerationWalking;
+		break;
 	case MOVE_Falling:
-		return BrakingDecelerationFalling;
+		Parameters.MaxSpeed = MaxFallingGroundSpeed;
+		Parameters.MaxAcceleration = MaxFallingAcceleration;
+		Parameters.BrakingDeceleration = BrakingDecelerationFalling;
+		break;
 	case MOVE_Swimming:
-		return BrakingDecelerationSwimming;
+		Parameters.MaxSpeed = MaxSwimSpeed;
+		Parameters.MaxAcceleration = MaxSwimAcceleration;
+		Parameters.BrakingDeceleration = BrakingDecelerationSwimming;
+		break;
 	case MOVE_Flying:
-		return BrakingDecelerationFlying;
+		Parameters.MaxSpeed = MaxFlySpeed;
+		Parameters.MaxAcceleration = MaxFlyAcceleration;
+		Parameters.BrakingDeceleration = BrakingDecelerationFlying;
+		break;
+	case MOVE_Custom:
+		Parameters.MaxSpeed = MaxCustomMovementSpeed;
+		break;
 	default:
-		return 0.f;
+		break;
 	}
-}
-
-float UExtCharacterMovementComponent::GetBrakingFrictionFactor() const
-{
-	if (ExtCharacterOwner->IsRagdoll())
-		return BrakingFrictionFactorRagdoll;
 
-	if (ExtCharacterOwner->IsLanding())
-		return BrakingFrictionFactorLanding;
+	Parameters.BrakingFrictionFactor = BrakingFrictionFactor;
 
-	return BrakingFrictionFactor;
-}
-
-FVector UExtCharacterMovementComponent::GetSimulatedAcceleration() const
-{
+	switch (Condition)
+	{
+	case EMovementParameterCondition::Landing:
+		Parameters.BrakingDeceleration = BrakingDecelerationLanding;
+		Parameters.BrakingFrictionFactor = BrakingFrictionFactorLanding;
+		break;
+	case EMovementParameterCondition::Ragdoll:
+		Parameters.BrakingDeceleration = BrakingDecelerationRagdoll;
+		Parameters.BrakingFrictionFactor = BrakingFrictionFactorRagdoll;
+		break;
+	default:
+		break;
+	}
+
+	return Parameters;
+}
+
+void UExtCharacterMovementComponent::RebuildMovementParameterTable()
+{
+	for (uint32 Condition = 0; Condition < 3; ++Condition)
+	{
+		for (uint32 Mode = 0; Mode < 8; ++Mode)
+		{
+			MovementParameterTable[Mode | (Condition << 3)] = GetSettingsMovementParameters(EMovementMode(Mode), EMovementParameterCondition(Condition));
+		}
+	}
+
+	for (const FMovementParametersOverride& Override : MovementParameterOverrides)
+	{
+		const uint32 Mode = uint32(Override.MovementMode.GetValue()) & 0x7;
+		const uint32 Condition = uint32(Override.Condition);
+
+		MovementParameterTable[Mode | (Condition << 3)].Apply(Override);
+
+		if (Mode == MOVE_Walking)
+			MovementParameterTable[MOVE_NavWalking | (Condition << 3)].Apply(Override);
+	}
+
+	// NavWalking keeps its own overrides over those inherited from Walking
+	for (const FMovementParametersOverride& Override : MovementParameterOverrides)
+	{
+		if (Override.MovementMode == MOVE_NavWalking)
+			MovementParameterTable[MOVE_NavWalking | (uint32(Override.Condition) << 3)].Apply(Override);
+	}
+
+	// Ragdoll takes precedence over landing
+	for (uint32 Mode = 0; Mode < 8; ++Mode)
+	{
+		MovementParameterTable[Mode | (3 << 3)] = MovementParameterTable[Mode | (2 << 3)];
+	}
+
+	UpdateMovementParameterKey();
+}
+
+void UExtCharacterMovementComponent::UpdateMovementParameterKey()
+{
+	MovementParameterKey = GetMovementParameterKey();
+}
+
+float UExtCharacterMovementComponent::GetMaxSpeed() const
+{
+	// Full override to support different max speeds for each movement mode including a ground speed limit for falling.
+	FULL_OVERRIDE();
+
+	return MovementParameterTable[MovementParameterKey].MaxSpeed;
+}
+
+float UExtCharacterMovementComponent::GetMaxModeAcceleration() const
+{
+	return MovementParameterTable[MovementParameterKey].MaxAcceleration;
+}
+
+FVector UExtCharacterMovementComponent::ScaleInputAcceleration(const FVector& InputAcceleration) const
+{
+	return Super::ScaleInputAcceleration(InputAcceleration) * InputAccelerationScale;
+}
+
+float UExtCharacterMovementComponent::GetMaxBrakingDeceleration() const
+{
+	FULL_OVERRIDE();
+
+	return MovementParameterTable[MovementParameterKey].BrakingDeceleration;
+}
+
+float UExtCharacterMovementComponent::GetBrakingFrictionFactor() const
+{
+	return MovementParameterTable[MovementParameterKey].BrakingFrictionFactor;
+}
+
+FVector UExtCharacterMovementComponent::GetSimulatedAcceleration() const
+{
 	return SimulatedAcceleration;
 }
 
@@ -870,32 +1447,52 @@ FRotator UExtCharacterMovementComponent::GetDeltaRotation(const FRotator& Curren
 		);
 }
 
+float UExtCharacterMovementComponent::GetDeltaYaw(const float CurrentYaw, const float DesiredYaw, float DeltaSeconds) const
+{
+	const float InterpSpeed = GetRotationInterpSpeed(RotationRate, AdaptiveRotationSettings.Speed, AdaptiveRotationSettings.RotationRateFactor, AdaptiveRotationSettings.RotationRateLimit).Yaw;
+
+	return bInterpolateToTargetRotation 
+		? CalculateInterpDeltaRotationAxis(CurrentYaw, DesiredYaw, DeltaSeconds, InterpSpeed) 
+		: CalculateConstantDeltaRotationAxis(CurrentYaw, DesiredYaw, DeltaSeconds, InterpSpeed);
+}
+
 FRotator UExtCharacterMovementComponent::ComputeOrientToMovementRotation(const FRotator& CurrentRotation, float DeltaSeconds, FRotator& DeltaRotation) const
 {
 	return Super::ComputeOrientToMovementRotation(CurrentRotation, DeltaSeconds, DeltaRotation);
 }
 
-FRotator UExtCharacterMovementComponent::ComputeOrientToMovementRotation(const FRotator& CurrentRotation, float DeltaSeconds)
+FVector UExtCharacterMovementComponent::ComputeOrientToMovementDirection() const
 {
 	if (Velocity.SizeSquared() < KINDA_SMALL_NUMBER)
-		return CurrentRotation;
+		return FVector::ZeroVector;
 
 	if (bUseVelocityAsMovementVector)
-		return Velocity.GetSafeNormal().Rotation();
+		return Velocity;
 	else
 	{
 		if (Acceleration.SizeSquared() < KINDA_SMALL_NUMBER)
 			// AI path following request can orient us in that direction (it's effectively an acceleration)
-			return (bHasRequestedVelocity && RequestedVelocity.SizeSquared() > KINDA_SMALL_NUMBER) ? RequestedVelocity.GetSafeNormal().Rotation() : CurrentRotation;
+			return (bHasRequestedVelocity && RequestedVelocity.SizeSquared() > KINDA_SMALL_NUMBER) ? RequestedVelocity : FVector::ZeroVector;
 		else 
 			// Rotate toward direction of acceleration.
-			return Acceleration.GetSafeNormal().Rotation();
+			return Acceleration;
 	}
 }
 
+FRotator UExtCharacterMovementComponent::ComputeOrientToMovementRotation(const FRotator& CurrentRotation, float DeltaSeconds)
+{
+	const FVector Direction = ComputeOrientToMovementDirection();
+	return Direction.IsZero() ? CurrentRotation : Direction.GetSafeNormal().Rotation();
+}
+
 FRotator UExtCharacterMovementComponent::ComputeOrientToLookRotation(const FRotator& ControlRotation, const float NorthSegmentHalfWidth, float Buffer, float DeltaSeconds)
 {
-	float LookYawDelta = FMath::FindDeltaAngleDegrees(ControlRotation.Yaw, (Acceleration.SizeSquared2D() > KINDA_SMALL_NUMBER ? Acceleration : Velocity).Rotation().Yaw);
+	const float LookYawDelta = FMath::FindDeltaAngleDegrees(ControlRotation.Yaw, (Acceleration.SizeSquared2D() > KINDA_SMALL_NUMBER ? Acceleration : Velocity).Rotation().Yaw);
+	return FRotator(ControlRotation.Pitch, ControlRotation.Yaw + UpdateLookRotationOffset(LookYawDelta, NorthSegmentHalfWidth, Buffer, DeltaSeconds), ControlRotation.Roll);
+}
+
+float UExtCharacterMovementComponent::UpdateLookRotationOffset(float LookYawDelta, const float NorthSegmentHalfWidth, float Buffer, float DeltaSeconds)
+{
 	LookCardinalDirection = FMathEx::FindCardinalDirection(LookYawDelta, LookCardinalDirection, NorthSegmentHalfWidth, Buffer);
 	switch (LookCardinalDirection)
 	{
@@ -915,7 +1512,7 @@ FRotator UExtCharacterMovementComponent::ComputeOrientToLookRotation(const FRota
 
 	RotationOffset = FMathEx::FSafeInterpTo(RotationOffset, LookYawDelta, DeltaSeconds, 5.0f);
 
-	return FRotator(ControlRotation.Pitch, ControlRotation.Yaw + RotationOffset, ControlRotation.Roll);
+	return RotationOffset;
 }
 
 bool UExtCharacterMovementComponent::CanTurnInPlaceInCurrentState() const
@@ -960,6 +1557,12 @@ void UExtCharacterMovementComponent::PhysicsRotation(float DeltaSeconds)
 		return;
 	}
 
+	if (bUseQuaternionRotation)
+	{
+		PhysicsRotationQuat(DeltaSeconds);
+		return;
+	}
+
 	FRotator CurrentRotation = UpdatedComponent->GetComponentRotation(); // Normalized
 	CurrentRotation.DiagnosticCheckNaN(TEXT("CharacterMovementComponent::PhysicsRotation(): CurrentRotation"));
 
@@ -978,6 +1581,34 @@ void UExtCharacterMovementComponent::PhysicsRotation(float DeltaSeconds)
 
 		const float AdjustedDeltaSeconds = RotationRateFactor * DeltaSeconds;
 
+		// Use the rotation computed by the crowd movement manager if velocity was also taken from the batch and did not change much during the move.
+		if (bHasCrowdBatchedVelocity && CrowdBatchIndex != INDEX_NONE)
+		{
+			const FCrowdMovementBatch& Batch = CrowdMovementManager->GetBatch();
+			const int32 Index = CrowdBatchIndex;
+			bHasCrowdBatchedVelocity = false;
+			CrowdBatchIndex = INDEX_NONE;
+
+			if (Batch.Components.IsValidIndex(Index) && Batch.Components[Index] == this
+				&& (Batch.Flags[Index] & FCrowdMovementBatch::FLAG_OrientToMovement)
+				&& IsMovingOnGround()
+				&& CurrentRotation.Pitch == 0.f && CurrentRotation.Roll == 0.f && CurrentRotation.Yaw == Batch.Yaws[Index]
+				&& AdjustedDeltaSeconds == Batch.RotationDeltaTimes[Index]
+				&& Acceleration == Batch.OutAccelerations[Index]
+				&& (!bHasRequestedVelocity || RequestedVelocity == Batch.OutRequestedVelocities[Index])
+				&& (Velocity - Batch.OutVelocities[Index]).SizeSquared() <= FMath::Square(BrakingSpeedTolerance))
+			{
+				INC_DWORD_STAT(STAT_ExtCharacterMovement_CrowdRotationHits);
+
+				if (Batch.OutDeltaYaws[Index] == 0.f)
+					return;
+
+				DeltaRot.Yaw = Batch.OutDeltaYaws[Index];
+				MoveUpdatedComponent(FVector::ZeroVector, CurrentRotation + DeltaRot, true);
+				return;
+			}
+		}
+
 		// If falling use FallRotation which was set when the character started to fall which includes jumping, otherwise compute the movement rotation
 		FRotator TargetRotation = (MovementMode != MOVE_Falling || (bCanRotateWhileJumping && ExtCharacterOwner->bIsJumping)) ? ComputeOrientToMovementRotation(CurrentRotation, AdjustedDeltaSeconds) : FallRotation;
 		if (ShouldRemainVertical())
@@ -1020,88 +1651,8 @@ void UExtCharacterMovementComponent::PhysicsRotation(float DeltaSeconds)
 			{
 				ResetControllerDesireRotationState();
 
-				if (CanTurnInPlaceInCurrentState())
-				{
-					// Restore TurnInPlace from suspension.
-					if (!FMath::IsFinite(TurnInPlaceTargetYaw) && TurnInPlaceTargetYaw < 0.f)
-					{
-						TurnInPlaceTargetYaw = INFINITY;
-					}
-					
-					if (bUseTurnInPlaceDelay && TurnInPlaceDelay > 0.01f)
-					{
-						if (!FMath::IsFinite(TurnInPlaceTargetYaw)) // if not turning in place
-						{
-							const float MaxLookYawAngle = FMath::Clamp(LookAngleThreshold, 45.f, 90.f);
-							const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentRotation.Yaw, ControlRotation.Yaw);
-							const float LookYawAngle = FMath::Abs(LookYawDelta);
-
-							if (LookYawAngle > MaxLookYawAngle)
-							{
-								TurnInPlaceTimeCounter += DeltaSeconds;
-								if (TurnInPlaceTimeCounter > TurnInPlaceDelay)
-								{
-									const bool bIsLookingRight = LookYawDelta >= 0.0f;
-									const int32 TurnInPlaceSteps = ((FMath::FloorToInt(LookYawAngle - MaxLookYawAngle) / 90) + 1);
-									const float TurnInPlaceAngle = TurnInPlaceSteps * (bIsLookingRight ? 90.0f : -90.f);
-
-									TurnInPlaceTargetYaw = CurrentRotation.Yaw + TurnInPlaceAngle;
-									TurnInPlaceTimeCounter = 0.0f;
-								}
-							}
-							else
-							{
-								TurnInPlaceTimeCounter = 0.0f;
-							}
-						}
-					}
-					else
-					{
-						// Reset timer from delayed turn in place for when switched off in the middle of a countdown.
-						TurnInPlaceTimeCounter = 0.0f;
-
-						// Enforce max angular distance if needed.
-						if (TurnInPlaceMaxDistance > 0.0f)
-						{
-							const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentRotation.Yaw, ControlRotation.Yaw);
-							if (LookYawDelta < -TurnInPlaceMaxDistance)
-							{
-								if (bCanEnforceTurnInPlaceRotationMaxDistance)
-									CurrentRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw + TurnInPlaceMaxDistance);
-							}
-							else if (LookYawDelta > TurnInPlaceMaxDistance)
-							{
-								if (bCanEnforceTurnInPlaceRotationMaxDistance)
-									CurrentRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw - TurnInPlaceMaxDistance);
-							}
-							else
-							{
-								bCanEnforceTurnInPlaceRotationMaxDistance = true;
-							}
-						}
-
-						// Follow the current character rotation.
-						const float CurrentTargetYaw = FMath::IsFinite(TurnInPlaceTargetYaw) ? TurnInPlaceTargetYaw : CurrentRotation.Yaw;
-						const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentTargetYaw, ControlRotation.Yaw);
-
-						const float MaxLookYawAngle = FMath::Clamp(LookAngleThreshold, 45.f, 90.f);
-						const float LookYawAngle = FMath::Abs(LookYawDelta);
-						
-						if (LookYawAngle > MaxLookYawAngle)
-						{
-							const bool bIsLookingRight = LookYawDelta >= 0.0f;
-							const int32 TurnInPlaceSteps = ((FMath::FloorToInt(LookYawAngle - MaxLookYawAngle) / 90) + 1);
-							const float TurnInPlaceAngle = TurnInPlaceSteps * (bIsLookingRight ? 90.0f : -90.f);
-
-							TurnInPlaceTargetYaw = FMath::UnwindDegrees(CurrentTargetYaw + TurnInPlaceAngle);
-						}
-					}
-				}
-				else // if (!CanTurnInPlaceInCurrentState())
-				{
-					ResetTurnInPlaceState();
+				if (!UpdateTurnInPlaceTarget(CurrentRotation.Yaw, ControlRotation.Yaw, DeltaSeconds))
 					return;
-				}
 
 				FRotator TargetRotation(
 					ControlRotation.Pitch,
@@ -1129,31 +1680,7 @@ void UExtCharacterMovementComponent::PhysicsRotation(float DeltaSeconds)
 			{
 				ResetTurnInPlaceState();
 
-				// Enforce max angular distance if defined.
-				if (ControlRotationMaxDistance > 0.0f)
-				{
-					float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentRotation.Yaw, ControlRotation.Yaw);
-					if (LookYawDelta < -ControlRotationMaxDistance)
-					{
-						if (bCanEnforceControlRotationMaxDistance)
-						{
-							CurrentRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw + ControlRotationMaxDistance);
-							LookYawDelta = -ControlRotationMaxDistance;
-						}
-					}
-					else  if (LookYawDelta > ControlRotationMaxDistance)
-					{
-						if (bCanEnforceControlRotationMaxDistance)
-						{
-							CurrentRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw - ControlRotationMaxDistance);
-							LookYawDelta = ControlRotationMaxDistance;
-						}
-					}
-					else
-					{
-						bCanEnforceControlRotationMaxDistance = true;
-					}
-				}
+				EnforceControlRotationMaxDistance(CurrentRotation.Yaw, ControlRotation.Yaw);
 
 				FRotator TargetRotation = ComputeOrientToLookRotation(ControlRotation, LookAngleThreshold, 5.0f, DeltaSeconds);
 				if (ShouldRemainVertical())
@@ -1189,6 +1716,236 @@ void UExtCharacterMovementComponent::PhysicsRotation(float DeltaSeconds)
 	MoveUpdatedComponent(FVector::ZeroVector, DesiredRotation, true);
 }
 
+bool UExtCharacterMovementComponent::UpdateTurnInPlaceTarget(float& CurrentYaw, const float ControlYaw, float DeltaSeconds)
+{
+	if (CanTurnInPlaceInCurrentState())
+	{
+		// Restore TurnInPlace from suspension.
+		if (!FMath::IsFinite(TurnInPlaceTargetYaw) && TurnInPlaceTargetYaw < 0.f)
+		{
+			TurnInPlaceTargetYaw = INFINITY;
+		}
+		
+		if (bUseTurnInPlaceDelay && TurnInPlaceDelay > 0.01f)
+		{
+			if (!FMath::IsFinite(TurnInPlaceTargetYaw)) // if not turning in place
+			{
+				const float MaxLookYawAngle = FMath::Clamp(LookAngleThreshold, 45.f, 90.f);
+				const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentYaw, ControlYaw);
+				const float LookYawAngle = FMath::Abs(LookYawDelta);
+
+				if (LookYawAngle > MaxLookYawAngle)
+				{
+					TurnInPlaceTimeCounter += DeltaSeconds;
+					if (TurnInPlaceTimeCounter > TurnInPlaceDelay)
+					{
+						const bool bIsLookingRight = LookYawDelta >= 0.0f;
+						const int32 TurnInPlaceSteps = ((FMath::FloorToInt(LookYawAngle - MaxLookYawAngle) / 90) + 1);
+						const float TurnInPlaceAngle = TurnInPlaceSteps * (bIsLookingRight ? 90.0f : -90.f);
+
+						TurnInPlaceTargetYaw = CurrentYaw + TurnInPlaceAngle;
+						TurnInPlaceTimeCounter = 0.0f;
+					}
+				}
+				else
+				{
+					TurnInPlaceTimeCounter = 0.0f;
+				}
+			}
+		}
+		else
+		{
+			// Reset timer from delayed turn in place for when switched off in the middle of a countdown.
+			TurnInPlaceTimeCounter = 0.0f;
+
+			// Enforce max angular distance if needed.
+			if (TurnInPlaceMaxDistance > 0.0f)
+			{
+				const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentYaw, ControlYaw);
+				if (LookYawDelta < -TurnInPlaceMaxDistance)
+				{
+					if (bCanEnforceTurnInPlaceRotationMaxDistance)
+						CurrentYaw = FRotator::NormalizeAxis(ControlYaw + TurnInPlaceMaxDistance);
+				}
+				else if (LookYawDelta > TurnInPlaceMaxDistance)
+				{
+					if (bCanEnforceTurnInPlaceRotationMaxDistance)
+						CurrentYaw = FRotator::NormalizeAxis(ControlYaw - TurnInPlaceMaxDistance);
+				}
+				else
+				{
+					bCanEnforceTurnInPlaceRotationMaxDistance = true;
+				}
+			}
+
+			// Follow the current character rotation.
+			const float CurrentTargetYaw = FMath::IsFinite(TurnInPlaceTargetYaw) ? TurnInPlaceTargetYaw : CurrentYaw;
+			const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentTargetYaw, ControlYaw);
+
+			const float MaxLookYawAngle = FMath::Clamp(LookAngleThreshold, 45.f, 90.f);
+			const float LookYawAngle = FMath::Abs(LookYawDelta);
+			
+			if (LookYawAngle > MaxLookYawAngle)
+			{
+				const bool bIsLookingRight = LookYawDelta >= 0.0f;
+				const int32 TurnInPlaceSteps = ((FMath::FloorToInt(LookYawAngle - MaxLookYawAngle) / 90) + 1);
+				const float TurnInPlaceAngle = TurnInPlaceSteps * (bIsLookingRight ? 90.0f : -90.f);
+
+				TurnInPlaceTargetYaw = FMath::UnwindDegrees(CurrentTargetYaw + TurnInPlaceAngle);
+			}
+		}
+	}
+	else // if (!CanTurnInPlaceInCurrentState())
+	{
+		ResetTurnInPlaceState();
+		return false;
+	}
+
+	return true;
+}
+
+void UExtCharacterMovementComponent::EnforceControlRotationMaxDistance(float& CurrentYaw, const float ControlYaw)
+{
+	if (ControlRotationMaxDistance > 0.0f)
+	{
+		const float LookYawDelta = FMath::FindDeltaAngleDegrees(CurrentYaw, ControlYaw);
+		if (LookYawDelta < -ControlRotationMaxDistance)
+		{
+			if (bCanEnforceControlRotationMaxDistance)
+				CurrentYaw = FRotator::NormalizeAxis(ControlYaw + ControlRotationMaxDistance);
+		}
+		else if (LookYawDelta > ControlRotationMaxDistance)
+		{
+			if (bCanEnforceControlRotationMaxDistance)
+				CurrentYaw = FRotator::NormalizeAxis(ControlYaw - ControlRotationMaxDistance);
+		}
+		else
+		{
+			bCanEnforceControlRotationMaxDistance = true;
+		}
+	}
+}
+
+FORCEINLINE static bool GetYawInFrame(const FQuat& Frame, const FVector& Direction, float& OutYaw)
+{
+	// Yaw in degrees of Direction around the up axis of Frame. Fails if Direction is parallel to the up axis.
+	const FVector LocalDirection = Frame.UnrotateVector(Direction);
+	if (LocalDirection.SizeSquared2D() < KINDA_SMALL_NUMBER)
+		return false;
+
+	OutYaw = FMath::RadiansToDegrees(FMath::Atan2(LocalDirection.Y, LocalDirection.X));
+	return true;
+}
+
+void UExtCharacterMovementComponent::PhysicsRotationQuat(float DeltaSeconds)
+{
+	// Batched rotations are computed as world yaw
+	bHasCrowdBatchedVelocity = false;
+	CrowdBatchIndex = INDEX_NONE;
+
+	if (ExtCharacterOwner->IsRagdoll() || ExtCharacterOwner->IsGettingUp())
+		return;
+
+	// Every rotation is reduced to a yaw around the up axis of this frame
+	const FVector UpVector = CharacterUpVector.IsNearlyZero() ? FVector::UpVector : CharacterUpVector.GetSafeNormal();
+	const FQuat Frame = FQuat::FindBetweenNormals(FVector::UpVector, UpVector);
+
+	FQuat CurrentQuat = UpdatedComponent->GetComponentQuat();
+	CurrentQuat.DiagnosticCheckNaN(TEXT("CharacterMovementComponent::PhysicsRotationQuat(): CurrentQuat"));
+
+	float CurrentYaw = 0.f;
+	GetYawInFrame(Frame, CurrentQuat.GetForwardVector(), CurrentYaw);
+
+	// Keep the capsule aligned to the up vector
+	if (FVector::DotProduct(CurrentQuat.GetUpVector(), UpVector) < THRESH_NORMALS_ARE_PARALLEL)
+	{
+		CurrentQuat = Frame * FQuat(FVector::UpVector, FMath::DegreesToRadians(CurrentYaw));
+		MoveUpdatedComponent(FVector::ZeroVector, CurrentQuat, true);
+	}
+
+	const float InitialYaw = CurrentYaw;
+	float DeltaYaw = 0.f;
+
+	const bool bUseFallRotation = MovementMode == MOVE_Falling && !(bCanRotateWhileJumping && ExtCharacterOwner->bIsJumping);
+
+	if (bOrientRotationToMovement)
+	{
+		ResetTurnInPlaceState();
+		ResetControllerDesireRotationState();
+
+		// Sanity check
+		check(RotationRateFactor >= 0.f && RotationRateFactor <= 1.f);
+
+		float TargetYaw;
+		if (!GetYawInFrame(Frame, bUseFallRotation ? FallRotation.Vector() : ComputeOrientToMovementDirection(), TargetYaw))
+			return;
+
+		DeltaYaw = GetDeltaYaw(CurrentYaw, TargetYaw, RotationRateFactor * DeltaSeconds);
+	}
+	else if (CharacterOwner->Controller && bUseControllerDesiredRotation)
+	{
+		float ControlYaw = CurrentYaw;
+		GetYawInFrame(Frame, CharacterOwner->Controller->GetDesiredRotation().Vector(), ControlYaw);
+
+		if (bUseFallRotation)
+		{
+			ResetTurnInPlaceState();
+			ResetControllerDesireRotationState();
+
+			float TargetYaw;
+			if (!GetYawInFrame(Frame, FallRotation.Vector(), TargetYaw))
+				return;
+
+			DeltaYaw = GetDeltaYaw(CurrentYaw, TargetYaw, DeltaSeconds);
+		}
+		else if (FVector::VectorPlaneProject(Velocity, UpVector).SizeSquared() < KINDA_SMALL_NUMBER)
+		{
+			ResetControllerDesireRotationState();
+
+			if (!UpdateTurnInPlaceTarget(CurrentYaw, ControlYaw, DeltaSeconds))
+				return;
+
+			const float TargetYaw = FMath::IsFinite(TurnInPlaceTargetYaw) ? TurnInPlaceTargetYaw : CurrentYaw;
+			if (FMath::Abs(FMath::FindDeltaAngleDegrees(CurrentYaw, TargetYaw)) <= AngleTolerance)
+			{
+				TurnInPlaceTargetYaw = INFINITY;
+				return;
+			}
+
+			DeltaYaw = CalculateConstantDeltaRotationAxis(CurrentYaw, TargetYaw, DeltaSeconds, TurnInPlaceRotationRate.Yaw);
+		}
+		else
+		{
+			ResetTurnInPlaceState();
+
+			EnforceControlRotationMaxDistance(CurrentYaw, ControlYaw);
+
+			const FVector PlaneAcceleration = FVector::VectorPlaneProject(Acceleration, UpVector);
+			float MovementYaw = ControlYaw;
+			GetYawInFrame(Frame, PlaneAcceleration.SizeSquared() > KINDA_SMALL_NUMBER ? PlaneAcceleration : Velocity, MovementYaw);
+
+			const float TargetYaw = ControlYaw + UpdateLookRotationOffset(FMath::FindDeltaAngleDegrees(ControlYaw, MovementYaw), LookAngleThreshold, 5.0f, DeltaSeconds);
+
+			DeltaYaw = GetDeltaYaw(CurrentYaw, TargetYaw, RotationRateFactor * DeltaSeconds);
+		}
+	}
+	else
+	{
+		ResetTurnInPlaceState();
+		ResetControllerDesireRotationState();
+
+		return;
+	}
+
+	if (FMath::Abs(DeltaYaw) <= AngleTolerance && CurrentYaw == InitialYaw)
+		return;
+
+	const FQuat DesiredQuat = Frame * FQuat(FVector::UpVector, FMath::DegreesToRadians(CurrentYaw + DeltaYaw));
+
+	DesiredQuat.DiagnosticCheckNaN(TEXT("CharacterMovementComponent::PhysicsRotationQuat(): DesiredQuat"));
+	MoveUpdatedComponent(FVector::ZeroVector, DesiredQuat, true);
+}
+
 void UExtCharacterMovementComponent::ResetRotationRateFactor()
 {
 	RotationRateFactor = 0.0f;
@@ -1448,20 +2205,689 @@ bool UExtCharacterMovementComponent::CanWalkOffLedges() const
 	return true;
 }
 
+bool UExtCharacterMovementComponent::CheckLedgeDirection(const FVector& OldLocation, const FVector& SideStep, const FVector& GravDir) const
+{
+	// Ledge maps are baked along world Z
+	if (bUseLedgeMap && GravDir.Z < 0.f && GravDir.SizeSquared2D() <= KINDA_SMALL_NUMBER)
+	{
+		const FVector SideDest = OldLocation + SideStep;
+		if (const ALedgeMapVolume* LedgeMap = ALedgeMapVolume::Find(GetWorld(), SideDest))
+		{
+			float PawnRadius, PawnHalfHeight;
+			CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+
+			// Same range as the sweeps: a floor not higher than a step up and not lower than a step down plus the ledge threshold
+			const float FeetZ = OldLocation.Z - PawnHalfHeight;
+			const ELedgeMapQueryResult Result = LedgeMap->QueryFloor(SideDest, PawnRadius, FeetZ - (MaxStepHeight + LedgeCheckThreshold), FeetZ + MaxStepHeight);
+
+			// The map has no lateral blocking data so only a missing floor is conclusive, the sweeps decide whether the side step is blocked
+			if (Result == ELedgeMapQueryResult::NoFloor)
+			{
+				INC_DWORD_STAT(STAT_ExtCharacterMovement_LedgeMapHits);
+				return false;
+			}
+		}
+	}
+
+	INC_DWORD_STAT(STAT_ExtCharacterMovement_LedgeSweeps);
+	return Super::CheckLedgeDirection(OldLocation, SideStep, GravDir);
+}
+
+
+
+/// Floor Cache
+
+bool UExtCharacterMovementComponent::CanReuseCachedFloor(const FVector& CapsuleLocation) const
+{
+	if (!bHasCachedFloor || CachedFloorGeneration != FloorCacheGeneration)
+		return false;
+
+	// Base must still exist and be static
+	const UPrimitiveComponent* Base = CachedFloor.HitResult.Component.Get();
+	if (!Base || Base->Mobility != EComponentMobility::Static)
+		return false;
+
+	if (FVector::DistSquared(CapsuleLocation, CachedFloorLocation) > FMath::Square(FloorCacheTolerance))
+		return false;
+
+	float Radius, HalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+	return CachedFloorCapsuleSize.X == Radius && CachedFloorCapsuleSize.Y == HalfHeight;
+}
+
+void UExtCharacterMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult) const
+{
+	if (bEnableFloorCache && !DownwardSweepResult && !bForceNextFloorCheck && HasValidData() && CanReuseCachedFloor(CapsuleLocation))
+	{
+		INC_DWORD_STAT(STAT_ExtCharacterMovement_FloorCacheHits);
+
+		// Floor distances are measured from the capsule so they change with its height.
+		const float DeltaZ = CapsuleLocation.Z - CachedFloorLocation.Z;
+		OutFloorResult = CachedFloor;
+		OutFloorResult.FloorDist += DeltaZ;
+		if (OutFloorResult.bLineTrace)
+			OutFloorResult.LineDist += DeltaZ;
+
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_ExtCharacterMovement_FloorSweeps);
+
+	Super::FindFloor(CapsuleLocation, OutFloorResult, bCanUseCachedLocation, DownwardSweepResult);
+
+	bHasCachedFloor = false;
+	if (bEnableFloorCache && HasValidData())
+		CacheFloor(CapsuleLocation, OutFloorResult);
+}
+
+void UExtCharacterMovementComponent::CacheFloor(const FVector& CapsuleLocation, const FFindFloorResult& FloorResult) const
+{
+	if (!FloorResult.IsWalkableFloor())
+		return;
+
+	const UPrimitiveComponent* Base = FloorResult.HitResult.Component.Get();
+	if (!Base || Base->Mobility != EComponentMobility::Static)
+		return;
+
+	float Radius, HalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+
+	CachedFloor = FloorResult;
+	CachedFloorLocation = CapsuleLocation;
+	CachedFloorCapsuleSize = FVector2D(Radius, HalfHeight);
+	CachedFloorGeneration = FloorCacheGeneration;
+	bHasCachedFloor = true;
+}
+
+
+
+/// Movement LOD
+
+bool UExtCharacterMovementComponent::CanUseMovementLODInCurrentState() const
+{
+	return bEnableMovementLOD
+		&& HasValidData()
+		&& ExtCharacterOwner
+		&& GetOwnerRole() == ROLE_Authority
+		&& !CharacterOwner->IsPlayerControlled()
+		&& !ExtCharacterOwner->IsRagdoll()
+		&& !ExtCharacterOwner->IsGettingUp()
+		&& !HasAnimRootMotion();
+}
+
+void UExtCharacterMovementComponent::UpdateMovementLOD(float DeltaSeconds)
+{
+	MovementLODTimeCounter += DeltaSeconds;
+	if (MovementLODTimeCounter < MovementLODCheckInterval)
+		return;
+
+	MovementLODTimeCounter = 0.f;
+
+	const bool bCanUseMovementLOD = CanUseMovementLODInCurrentState();
+	if (!bCanUseMovementLOD && !bIsMovementLODActive)
+		return;
+
+	// Find distance to the closest player view point.
+	float MinDistanceSquared = BIG_NUMBER;
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(Location, ViewLocation));
+		}
+	}
+
+	if (bIsMovementLODActive)
+	{
+		// Promote back to full physics when relevant to a player or when nav walking went through something it should have collided with.
+		bool bShouldPromote = !bCanUseMovementLOD || MinDistanceSquared < FMath::Square(FMath::Max(0.f, MovementLODDistance - MovementLODHysteresis));
+		if (!bShouldPromote)
+		{
+			// Other characters are not obstacles, they are avoided by path following and crowd movement. Otherwise a crowd would keep promoting itself.
+			FCollisionObjectQueryParams ObjectQueryParams(FCollisionObjectQueryParams::AllDynamicObjects);
+			ObjectQueryParams.RemoveObjectTypesToQuery(ECC_Pawn);
+
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ExtCharacterMovementLOD), false, CharacterOwner);
+			TArray<FOverlapResult> Overlaps;
+			GetWorld()->OverlapMultiByObjectType(Overlaps, Location, UpdatedComponent->GetComponentQuat(), ObjectQueryParams, GetPawnCapsuleCollisionShape(SHRINK_None), QueryParams);
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				if (!Cast<AExtCharacter>(Overlap.GetActor()))
+				{
+					bShouldPromote = true;
+					break;
+				}
+			}
+		}
+
+		if (bShouldPromote)
+		{
+			bIsMovementLODActive = false;
+			if (MovementMode == MOVE_NavWalking)
+				SetMovementMode(MOVE_Walking);
+		}
+	}
+	else if (MovementMode == MOVE_Walking && MinDistanceSquared > FMath::Square(MovementLODDistance))
+	{
+		SetMovementMode(MOVE_NavWalking);
+		bIsMovementLODActive = (MovementMode == MOVE_NavWalking);
+	}
+}
+
+
+
+/// Landing Prediction
+
+void UExtCharacterMovementComponent::UpdateLandingPrediction()
+{
+	if (!bEnableLandingPrediction)
+	{
+		bHasLandingPrediction = false;
+		return;
+	}
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	// Keep the current prediction while velocity follows the predicted ballistic path
+	if (bHasLandingPrediction)
+	{
+		const float ElapsedTime = WorldTime - LandingPredictionWorldTime;
+		const FVector ExpectedVelocity = LandingPredictionVelocity + FVector(0.f, 0.f, GetGravityZ() * ElapsedTime);
+		const bool bHasLookAheadExpired = LandingPredictionTimeToLand < 0.f && ElapsedTime > 0.5f * LandingPredictionMaxTime;
+		if (!bHasLookAheadExpired && (Velocity - ExpectedVelocity).SizeSquared() <= FMath::Square(LandingPredictionVelocityTolerance))
+			return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ExtCharacterMovement_LandingPrediction);
+
+	bHasLandingPrediction = true;
+	LandingPredictionWorldTime = WorldTime;
+	LandingPredictionVelocity = Velocity;
+
+	if (!PredictLanding(UpdatedComponent->GetComponentLocation(), Velocity, LandingPredictionTimeToLand, PredictedLandingLocation, PredictedLandingNormal))
+	{
+		LandingPredictionTimeToLand = -1.f;
+		PredictedLandingNormal = FVector::UpVector;
+	}
+}
+
+bool UExtCharacterMovementComponent::PredictLanding(const FVector& Start, const FVector& InVelocity, float& OutTimeToLand, FVector& OutLocation, FVector& OutNormal) const
+{
+	if (!HasValidData() || LandingPredictionMaxTime <= 0.f)
+		return false;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ExtCharacterPredictLanding), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
+	const FCollisionShape CapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_None);
+
+	const FVector Gravity(0.f, 0.f, GetGravityZ());
+	const int32 SweepCount = FMath::Max(1, LandingPredictionSweepCount);
+	const float SweepTime = LandingPredictionMaxTime / SweepCount;
+
+	FVector SegmentStart = Start;
+	for (int32 Index = 0; Index < SweepCount; ++Index)
+	{
+		const float Time = (Index + 1) * SweepTime;
+		const FVector SegmentEnd = Start + InVelocity * Time + 0.5f * Gravity * FMath::Square(Time);
+
+		FHitResult Hit(1.f);
+		if (GetWorld()->SweepSingleByChannel(Hit, SegmentStart, SegmentEnd, UpdatedComponent->GetComponentQuat(), CollisionChannel, CapsuleShape, QueryParams, ResponseParam))
+		{
+			OutTimeToLand = (Index + Hit.Time) * SweepTime;
+			OutLocation = Hit.Location;
+			OutNormal = Hit.ImpactNormal;
+			return true;
+		}
+
+		SegmentStart = SegmentEnd;
+	}
+
+	return false;
+}
+
+bool UExtCharacterMovementComponent::IsLandingPredicted() const
+{
+	return MovementMode == MOVE_Falling && bHasLandingPrediction && LandingPredictionTimeToLand >= 0.f;
+}
+
+float UExtCharacterMovementComponent::GetTimeToLand() const
+{
+	if (!IsLandingPredicted())
+		return -1.f;
+
+	const float ElapsedTime = GetWorld()->GetTimeSeconds() - LandingPredictionWorldTime;
+	return FMath::Max(LandingPredictionTimeToLand - ElapsedTime, 0.f);
+}
+
+
+
+/// Crowd Movement
+
+bool UExtCharacterMovementComponent::GatherBatchedMovement(float DeltaSeconds, FCrowdMovementBatch& Batch)
+{
+	CrowdBatchIndex = INDEX_NONE;
+	bHasCrowdBatchedVelocity = false;
+
+	UpdateCrowdTickPrerequisites();
+
+	// Only AI moving on ground on the server is batched. Anything else may depend on state we can't predict here.
+	if (DeltaSeconds < MIN_TICK_TIME
+		|| !HasValidData()
+		|| !ExtCharacterOwner
+		|| GetOwnerRole() != ROLE_Authority
+		|| CharacterOwner->IsPlayerControlled()
+		|| !IsMovingOnGround()
+		|| !IsActive()
+		|| UpdatedComponent->Mobility != EComponentMobility::Movable 
+		|| UpdatedComponent->IsSimulatingPhysics()
+		|| HasAnimRootMotion() 
+		|| CurrentRootMotion.HasActiveRootMotionSources()
+		|| bUseRVOAvoidance
+		|| ExtCharacterOwner->IsRagdoll())
+	{
+		return false;
+	}
+
+	// Same steps as TickComponent, ControlledCharacterMove and PhysWalking to get the inputs to CalcVelocity for the first iteration.
+	const float TimeDilatedDeltaSeconds = DeltaSeconds * CharacterOwner->CustomTimeDilation;
+	const float DeltaTime = GetSimulationTimeStep(TimeDilatedDeltaSeconds, 1);
+
+	FVector BatchVelocity = Velocity;
+	if (BatchVelocity.Z != 0.f)
+	{
+		if (bMaintainHorizontalGroundVelocity)
+			BatchVelocity.Z = 0.f;
+		else
+			BatchVelocity = BatchVelocity.GetSafeNormal2D() * BatchVelocity.Size();
+	}
+
+	FVector BatchAcceleration = ScaleInputAcceleration(ConstrainInputAcceleration(CharacterOwner->GetPendingMovementInputVector()));
+	BatchAcceleration.Z = 0.f;
+
+	const float MaxAccel = GetMaxAcceleration();
+	const float BatchAnalogInputModifier = (BatchAcceleration.SizeSquared() > 0.f && MaxAccel > SMALL_NUMBER) ? FMath::Clamp(BatchAcceleration.Size() / MaxAccel, 0.f, 1.f) : 0.f;
+
+	const int32 Index = Batch.Add(this);
+
+	Batch.Velocities[Index] = BatchVelocity;
+	Batch.Accelerations[Index] = BatchAcceleration;
+	Batch.AnalogInputModifiers[Index] = BatchAnalogInputModifier;
+	Batch.DeltaTimes[Index] = DeltaTime;
+	Batch.MaxInputSpeeds[Index] = FMath::Max(GetMaxSpeed() * BatchAnalogInputModifier, GetMinAnalogSpeed());
+	Batch.MaxAccelerations[Index] = MaxAccel;
+	Batch.Frictions[Index] = FMath::Max(0.f, GroundFriction);
+	Batch.BrakingFrictions[Index] = bUseSeparateBrakingFriction ? BrakingFriction : FMath::Max(0.f, GroundFriction);
+	Batch.BrakingFrictionFactors[Index] = GetBrakingFrictionFactor();
+	Batch.BrakingDecelerations[Index] = GetMaxBrakingDeceleration();
+	Batch.BrakingSpeedTolerances[Index] = BrakingSpeedTolerance;
+	Batch.RequestedVelocities[Index] = bHasRequestedVelocity ? RequestedVelocity : FVector::ZeroVector;
+	Batch.MaxSpeeds[Index] = GetMaxSpeed();
+
+	Batch.Yaws[Index] = UpdatedComponent->GetComponentRotation().Yaw;
+	Batch.YawRates[Index] = RotationRate.Yaw;
+	Batch.RotationDeltaTimes[Index] = RotationRateFactor * TimeDilatedDeltaSeconds;
+	Batch.AdaptiveRotationSettings[Index] = AdaptiveRotationSettings;
+	Batch.Flags[Index] = (bOrientRotationToMovement && !bUseVelocityAsMovementVector && !ExtCharacterOwner->IsGettingUp() ? FCrowdMovementBatch::FLAG_OrientToMovement : 0)
+		| (bInterpolateToTargetRotation ? FCrowdMovementBatch::FLAG_InterpolateRotation : 0)
+		| (bEnableAdaptiveRotationRate ? FCrowdMovementBatch::FLAG_AdaptiveRotationRate : 0)
+		| (bEnableCrowdAvoidance ? FCrowdMovementBatch::FLAG_Avoidance : 0)
+		| (bHasRequestedVelocity ? FCrowdMovementBatch::FLAG_RequestedVelocity : 0)
+		| (bRequestedMoveWithMaxSpeed ? FCrowdMovementBatch::FLAG_RequestedMoveWithMaxSpeed : 0)
+		| (bRequestedMoveUseAcceleration ? FCrowdMovementBatch::FLAG_RequestedMoveUseAcceleration : 0);
+
+	// Every batched character is an obstacle to the others, avoiding or not
+	const float AvoidanceRadius = CrowdAvoidanceRadius > 0.f ? CrowdAvoidanceRadius : CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	Batch.Locations[Index] = UpdatedComponent->GetComponentLocation();
+	Batch.AvoidanceRadii[Index] = AvoidanceRadius;
+	Batch.AvoidancePriorities[Index] = CrowdAvoidancePriority;
+	Batch.AvoidanceTimeHorizons[Index] = CrowdAvoidanceTimeHorizon;
+	Batch.MaxAvoidanceRadius = FMath::Max(Batch.MaxAvoidanceRadius, AvoidanceRadius);
+	Batch.MaxSpeed = FMath::Max(Batch.MaxSpeed, BatchVelocity.Size());
+	Batch.bHasAvoidance |= bEnableCrowdAvoidance;
+
+	CrowdBatchIndex = Index;
+	return true;
+}
+
+void UExtCharacterMovementComponent::UpdateCrowdTickPrerequisites()
+{
+	AController* Controller = CharacterOwner ? CharacterOwner->GetController() : nullptr;
+	if (!CrowdMovementManager || Controller == CrowdTickPrerequisiteController.Get())
+		return;
+
+	CrowdTickPrerequisiteController = Controller;
+
+	// Path following requests movement from its own tick. Unless it ticks before the manager its requests are never batched.
+	UActorComponent* PathFollowingComponent = Controller ? Controller->FindComponentByClass<UPathFollowingComponent>() : nullptr;
+	UActorComponent* OldPathFollowingComponent = CrowdTickPrerequisiteComponent.Get();
+	if (PathFollowingComponent == OldPathFollowingComponent)
+		return;
+
+	if (OldPathFollowingComponent)
+		CrowdMovementManager->PrimaryActorTick.RemovePrerequisite(OldPathFollowingComponent, OldPathFollowingComponent->PrimaryComponentTick);
+
+	CrowdTickPrerequisiteComponent = PathFollowingComponent;
+	if (PathFollowingComponent)
+		CrowdMovementManager->PrimaryActorTick.AddPrerequisite(PathFollowingComponent, PathFollowingComponent->PrimaryComponentTick);
+}
+
+/** Number of closest characters considered for crowd avoidance. */
+static const int32 MaxCrowdAvoidanceNeighbours = 10;
+
+/** Candidate directions in degrees relative to the preferred direction, in order of preference. */
+static const float CrowdAvoidanceCandidateAngles[] = { 0.f, 15.f, -15.f, 35.f, -35.f, 60.f, -60.f, 90.f, -90.f, 135.f, -135.f };
+
+/** 
+ * Time until two discs collide moving at relative velocity RelativeVelocity or BIG_NUMBER if they never do. 
+ * Zero if already overlapping and getting closer.
+ */
+FORCEINLINE static float CalculateTimeToCollision(const FVector2D& RelativeLocation, const FVector2D& RelativeVelocity, float CombinedRadius)
+{
+	const float B = RelativeLocation | RelativeVelocity;
+	if (B <= 0.f)
+		return BIG_NUMBER; // Moving apart
+
+	const float C = RelativeLocation.SizeSquared() - FMath::Square(CombinedRadius);
+	if (C <= 0.f)
+		return 0.f;
+
+	const float A = RelativeVelocity.SizeSquared();
+	const float Discriminant = B * B - A * C;
+	if (Discriminant <= 0.f)
+		return BIG_NUMBER;
+
+	return (B - FMath::Sqrt(Discriminant)) / A;
+}
+
+/** 
+ * Steer PreferredVelocity away from the characters around entry Index of the batch, sampling candidate directions against reciprocal velocity obstacles.
+ * Each candidate is penalized by how much it deviates from the preferred velocity and how soon it would lead to a collision.
+ * @return false if the preferred velocity is free. Otherwise OutVelocity is the best candidate at the preferred speed or zero if stopping is better.
+ */
+static bool ComputeCrowdAvoidanceVelocity(const FCrowdMovementBatch& Batch, int32 Index, const FVector2D& PreferredVelocity, FVector2D& OutVelocity)
+{
+	const float PreferredSpeed = PreferredVelocity.Size();
+	if (PreferredSpeed <= KINDA_SMALL_NUMBER)
+		return false;
+
+	const FVector2D Location(Batch.Locations[Index]);
+	const FVector2D Velocity(Batch.Velocities[Index]);
+	const float Radius = Batch.AvoidanceRadii[Index];
+	const float Priority = Batch.AvoidancePriorities[Index];
+	const float TimeHorizon = Batch.AvoidanceTimeHorizons[Index];
+
+	// Keep only the closest neighbours sorted by distance
+	TArray<TPair<float, int32>, TInlineAllocator<MaxCrowdAvoidanceNeighbours>> Neighbours;
+	const float QueryRadius = Radius + Batch.MaxAvoidanceRadius + (PreferredSpeed + Batch.MaxSpeed) * TimeHorizon;
+	Batch.SpatialHash.Query(Batch.Locations[Index], QueryRadius, [&](int32 OtherIndex)
+	{
+		if (OtherIndex == Index)
+			return;
+
+		const float DistSquared = (FVector2D(Batch.Locations[OtherIndex]) - Location).SizeSquared();
+		if (DistSquared > FMath::Square(QueryRadius))
+			return;
+
+		if (Neighbours.Num() == MaxCrowdAvoidanceNeighbours)
+		{
+			if (DistSquared >= Neighbours.Last().Key)
+				return;
+
+			Neighbours.Pop(false);
+		}
+
+		int32 InsertIndex = Neighbours.Num();
+		while (InsertIndex > 0 && Neighbours[InsertIndex - 1].Key > DistSquared)
+			--InsertIndex;
+
+		Neighbours.Insert(TPair<float, int32>(DistSquared, OtherIndex), InsertIndex);
+	});
+
+	if (Neighbours.Num() == 0)
+		return false;
+
+	const FVector2D PreferredDirection = PreferredVelocity / PreferredSpeed;
+
+	// Penalty of a candidate velocity, stopping is evaluated as a zero candidate
+	auto EvaluateCandidate = [&](const FVector2D& Candidate) -> float
+	{
+		float MinTimeToCollision = TimeHorizon;
+		for (const TPair<float, int32>& Neighbour : Neighbours)
+		{
+			const int32 OtherIndex = Neighbour.Value;
+			const float OtherPriority = Batch.AvoidancePriorities[OtherIndex];
+			const float TotalPriority = Priority + OtherPriority;
+
+			// Our share of the avoidance is the other's priority over the sum, so the lower priority takes the larger share.
+			// Two zero priorities split it equally and a share too small to divide by means the other character does all the avoiding.
+			const float Share = (TotalPriority > KINDA_SMALL_NUMBER) ? OtherPriority / TotalPriority : 0.5f;
+			if (Share <= KINDA_SMALL_NUMBER)
+				continue;
+
+			// Assume the other character takes the rest of the avoidance, only our share of the velocity change counts
+			const FVector2D EffectiveVelocity = Velocity + (Candidate - Velocity) / Share;
+			const FVector2D RelativeVelocity = EffectiveVelocity - FVector2D(Batch.Velocities[OtherIndex]);
+			const FVector2D RelativeLocation = FVector2D(Batch.Locations[OtherIndex]) - Location;
+
+			MinTimeToCollision = FMath::Min(MinTimeToCollision, CalculateTimeToCollision(RelativeLocation, RelativeVelocity, Radius + Batch.AvoidanceRadii[OtherIndex]));
+		}
+
+		const float CollisionPenalty = (MinTimeToCollision < TimeHorizon) ? TimeHorizon / FMath::Max(MinTimeToCollision, KINDA_SMALL_NUMBER) - 1.f : 0.f;
+		return (Candidate - PreferredVelocity).Size() / PreferredSpeed + CollisionPenalty;
+	};
+
+	FVector2D BestDirection = PreferredDirection;
+	float BestPenalty = BIG_NUMBER;
+	for (const float Angle : CrowdAvoidanceCandidateAngles)
+	{
+		const FVector2D Direction = (Angle == 0.f) ? PreferredDirection : PreferredDirection.GetRotated(Angle);
+		const float Penalty = EvaluateCandidate(Direction * PreferredSpeed);
+		if (Penalty < BestPenalty)
+		{
+			BestPenalty = Penalty;
+			BestDirection = Direction;
+		}
+
+		// Preferred direction is free, nothing to avoid
+		if (BestPenalty == 0.f)
+			return false;
+	}
+
+	OutVelocity = (EvaluateCandidate(FVector2D::ZeroVector) < BestPenalty) ? FVector2D::ZeroVector : BestDirection * PreferredSpeed;
+	return true;
+}
+
+void UExtCharacterMovementComponent::ProcessBatchedMovement(FCrowdMovementBatch& Batch, int32 Index)
+{
+	const uint8 Flags = Batch.Flags[Index];
+
+	const float MaxInputSpeed = Batch.MaxInputSpeeds[Index];
+
+	// Steer input acceleration and requested velocity first, so velocity and rotation follow the avoiding direction.
+	FVector InAcceleration = Batch.Accelerations[Index];
+	FVector InRequestedVelocity = Batch.RequestedVelocities[Index];
+	if (Flags & FCrowdMovementBatch::FLAG_Avoidance)
+	{
+		FVector2D AvoidanceVelocity;
+
+		// Input acceleration is evaluated at the max input speed and keeps its own size
+		if (!InAcceleration.IsZero() && MaxInputSpeed > KINDA_SMALL_NUMBER
+			&& ComputeCrowdAvoidanceVelocity(Batch, Index, FVector2D(InAcceleration.GetSafeNormal2D()) * MaxInputSpeed, AvoidanceVelocity))
+		{
+			InAcceleration = FVector(AvoidanceVelocity * (InAcceleration.Size() / MaxInputSpeed), 0.f);
+		}
+
+		// Requested velocity is evaluated at the speed ApplyRequestedMove will use and keeps its own size so the max speed flag still applies
+		if (Flags & FCrowdMovementBatch::FLAG_RequestedVelocity)
+		{
+			const FVector2D RequestedVelocity2D(InRequestedVelocity);
+			const float RequestedSize2D = RequestedVelocity2D.Size();
+			const float RequestedSpeed = (Flags & FCrowdMovementBatch::FLAG_RequestedMoveWithMaxSpeed) ? Batch.MaxSpeeds[Index] : FMath::Min(Batch.MaxSpeeds[Index], InRequestedVelocity.Size());
+			if (RequestedSize2D > KINDA_SMALL_NUMBER && RequestedSpeed > KINDA_SMALL_NUMBER
+				&& ComputeCrowdAvoidanceVelocity(Batch, Index, RequestedVelocity2D * (RequestedSpeed / RequestedSize2D), AvoidanceVelocity))
+			{
+				InRequestedVelocity = AvoidanceVelocity.IsZero() ? FVector::ZeroVector : FVector(AvoidanceVelocity * (RequestedSize2D / RequestedSpeed), InRequestedVelocity.Z);
+			}
+		}
+	}
+
+	Batch.OutAccelerations[Index] = InAcceleration;
+	Batch.OutRequestedVelocities[Index] = InRequestedVelocity;
+
+	// Velocity, mirrors CalcVelocity and ApplyRequestedMove for ground movement without root motion or RVO avoidance.
+	FVector NewVelocity = Batch.Velocities[Index];
+	const float InDeltaTime = Batch.DeltaTimes[Index];
+	const float InFriction = Batch.Frictions[Index];
+
+	if (InDeltaTime >= MIN_TICK_TIME)
+	{
+		// Path following
+		bool bZeroRequestedAcceleration = true;
+		FVector RequestedAcceleration = FVector::ZeroVector;
+		float RequestedSpeed = 0.f;
+		if ((Flags & FCrowdMovementBatch::FLAG_RequestedVelocity) && InRequestedVelocity.SizeSquared() >= KINDA_SMALL_NUMBER)
+		{
+			const float MaxSpeed = Batch.MaxSpeeds[Index];
+			const FVector RequestedMoveDir = InRequestedVelocity.GetSafeNormal();
+			RequestedSpeed = (Flags & FCrowdMovementBatch::FLAG_RequestedMoveWithMaxSpeed) ? MaxSpeed : FMath::Min(MaxSpeed, InRequestedVelocity.Size());
+
+			const FVector MoveVelocity = RequestedMoveDir * RequestedSpeed;
+			if ((Flags & FCrowdMovementBatch::FLAG_RequestedMoveUseAcceleration) && NewVelocity.SizeSquared() < FMath::Square(RequestedSpeed * 1.01f))
+			{
+				// Turn in the same manner as with input acceleration.
+				const float VelSize = NewVelocity.Size();
+				NewVelocity = NewVelocity - (NewVelocity - RequestedMoveDir * VelSize) * FMath::Min(InDeltaTime * InFriction, 1.f);
+
+				const float MaxAccel = Batch.MaxAccelerations[Index];
+				RequestedAcceleration = ((MoveVelocity - NewVelocity) / InDeltaTime).GetClampedToMaxSize(MaxAccel);
+				bZeroRequestedAcceleration = false;
+			}
+			else
+			{
+				// If decelerating we do so instantly, so we don't slide through the destination if we can't brake fast enough.
+				NewVelocity = MoveVelocity;
+			}
+		}
+
+		// Braking keeps the larger of the requested speed and the max input speed
+		const float MaxSpeedForBraking = FMath::Max(RequestedSpeed, MaxInputSpeed);
+		const bool bZeroAcceleration = InAcceleration.IsZero();
+		const bool bVelocityOverMax = NewVelocity.SizeSquared() > FMath::Square(FMath::Max(0.f, MaxSpeedForBraking)) * 1.01f;
+
+		// Only apply braking if there is no acceleration, or we are over our max speed and need to slow down to it.
+		if ((bZeroAcceleration && bZeroRequestedAcceleration) || bVelocityOverMax)
+		{
+			const FVector OldVelocity = NewVelocity;
+			if (!NewVelocity.IsZero())
+				ApplyBraking(NewVelocity, InDeltaTime, Batch.BrakingFrictions[Index], Batch.BrakingFrictionFactors[Index], Batch.BrakingDecelerations[Index], Batch.BrakingSpeedTolerances[Index]);
+
+			// Don't allow braking to lower us below max speed if we started above it.
+			if (bVelocityOverMax && NewVelocity.SizeSquared() < FMath::Square(MaxSpeedForBraking) && FVector::DotProduct(InAcceleration, OldVelocity) > 0.0f)
+				NewVelocity = OldVelocity.GetSafeNormal() * MaxSpeedForBraking;
+		}
+		else if (!bZeroAcceleration)
+		{
+			// Friction affects our ability to change direction. This is only done for input acceleration, not path following.
+			const FVector AccelDir = InAcceleration.GetSafeNormal();
+			const float VelSize = NewVelocity.Size();
+			NewVelocity = NewVelocity - (NewVelocity - AccelDir * VelSize) * FMath::Min(InDeltaTime * InFriction, 1.f);
+		}
+
+		// Apply input acceleration
+		if (!bZeroAcceleration)
+		{
+			const float NewMaxInputSpeed = (NewVelocity.SizeSquared() > FMath::Square(FMath::Max(0.f, MaxInputSpeed)) * 1.01f) ? NewVelocity.Size() : MaxInputSpeed;
+			NewVelocity += InAcceleration * InDeltaTime;
+			NewVelocity = NewVelocity.GetClampedToMaxSize(NewMaxInputSpeed);
+		}
+
+		// Apply additional requested acceleration
+		if (!bZeroRequestedAcceleration)
+		{
+			const float NewMaxRequestedSpeed = (NewVelocity.SizeSquared() > FMath::Square(FMath::Max(0.f, RequestedSpeed)) * 1.01f) ? NewVelocity.Size() : RequestedSpeed;
+			NewVelocity += RequestedAcceleration * InDeltaTime;
+			NewVelocity = NewVelocity.GetClampedToMaxSize(NewMaxRequestedSpeed);
+		}
+	}
+
+	Batch.OutVelocities[Index] = NewVelocity;
+
+	// Rotation, mirrors PhysicsRotation when orienting to movement on ground. Path following orients like acceleration when there is none.
+	const FVector MovementDirection = (InAcceleration.SizeSquared() >= KINDA_SMALL_NUMBER) ? InAcceleration
+		: ((Flags & FCrowdMovementBatch::FLAG_RequestedVelocity) && InRequestedVelocity.SizeSquared() > KINDA_SMALL_NUMBER) ? InRequestedVelocity : FVector::ZeroVector;
+
+	float DeltaYaw = 0.f;
+	if ((Flags & FCrowdMovementBatch::FLAG_OrientToMovement) && NewVelocity.SizeSquared() >= KINDA_SMALL_NUMBER && !MovementDirection.IsZero())
+	{
+		const float CurrentYaw = Batch.Yaws[Index];
+		const float TargetYaw = MovementDirection.GetSafeNormal().Rotation().Yaw;
+		if (FMath::Abs(FRotator::NormalizeAxis(CurrentYaw - TargetYaw)) > AngleTolerance)
+		{
+			float YawRate = Batch.YawRates[Index];
+			if (Flags & FCrowdMovementBatch::FLAG_AdaptiveRotationRate)
+			{
+				const FAdaptiveRotationSettings& Settings = Batch.AdaptiveRotationSettings[Index];
+				const float AdaptiveRotationFactor = CalculateAdaptiveRotationRateFactor(FMath::Square(Settings.Speed), Settings.RotationRateFactor, NewVelocity.SizeSquared2D());
+				YawRate = FMath::Clamp(YawRate * AdaptiveRotationFactor, Settings.RotationRateLimit.LowerBound, Settings.RotationRateLimit.UpperBound);
+			}
+
+			DeltaYaw = (Flags & FCrowdMovementBatch::FLAG_InterpolateRotation) 
+				? CalculateInterpDeltaRotationAxis(CurrentYaw, TargetYaw, Batch.RotationDeltaTimes[Index], YawRate)
+				: CalculateConstantDeltaRotationAxis(CurrentYaw, TargetYaw, Batch.RotationDeltaTimes[Index], YawRate);
+		}
+	}
+
+	Batch.OutDeltaYaws[Index] = DeltaYaw;
+}
+
+void UExtCharacterMovementComponent::PrefetchBatchedFloor(const FCrowdMovementBatch& Batch, int32 Index) const
+{
+	if (!bEnableFloorCache || bForceNextFloorCheck || !CurrentFloor.IsWalkableFloor())
+		return;
+
+	// Same delta as the first iteration of PhysWalking moving along the current floor
+	const FVector& BatchVelocity = Batch.OutVelocities[Index];
+	const FVector Delta = ComputeGroundMovementDelta(FVector(BatchVelocity.X, BatchVelocity.Y, 0.f) * Batch.DeltaTimes[Index], CurrentFloor.HitResult, CurrentFloor.bLineTrace);
+	if (Delta.IsNearlyZero())
+		return;
+
+	const FVector PredictedLocation = Batch.Locations[Index] + Delta;
+	if (CanReuseCachedFloor(PredictedLocation))
+		return;
+
+	INC_DWORD_STAT(STAT_ExtCharacterMovement_FloorPrefetches);
+
+	// Call the base implementation directly, the cache must be left as is if the floor can't be cached
+	FFindFloorResult FloorResult;
+	UCharacterMovementComponent::FindFloor(PredictedLocation, FloorResult, false);
+	CacheFloor(PredictedLocation, FloorResult);
+}
+
 
 
 /// Stop Prediction
 
 bool UExtCharacterMovementComponent::PredictStopLocation(FVector& OutStopLocation, const float TimeLimit, const float TimeStep)
 {
+	float StopTime, StopDistance;
+	return PredictStop(OutStopLocation, StopTime, StopDistance, TimeLimit, TimeStep);
+}
+
+bool UExtCharacterMovementComponent::PredictStop(FVector& OutStopLocation, float& OutStopTime, float& OutStopDistance, const float TimeLimit, const float TimeStep)
+{
+	OutStopTime = 0.f;
+	OutStopDistance = 0.f;
+
 	// Cannot predict a stop with invalid data
 	if (!HasValidData())
 		return false;
 
-	// Cannot predict a stop in anything below autonomous
-	if (GetIsReplicated() && CharacterOwner->Role < ROLE_Authority)
-		return false;
-
 	// Cannot predict a stop if TimeStep or TimeLit are too small
 	if (TimeStep < MIN_TICK_TIME || TimeLimit < TimeStep)
 		return false;
@@ -1505,42 +2931,40 @@ bool UExtCharacterMovementComponent::PredictStopLocation(FVector& OutStopLocatio
 
 	OutStopLocation = UpdatedComponent->GetComponentLocation();
 
-	const int32 MaxPredictionIterations = TimeLimit / TimeStep;
-	for (int32 Iterations = 0; Iterations < MaxPredictionIterations; ++Iterations)
-	{
-		// Only apply braking if there is no acceleration
-		if (bZeroAcceleration)
-		{
-			const FVector OldVelocity = LastVelocity;
+	// Speed under which the character is considered stopped
+	const float StopSpeed = bZeroBraking ? BrakingSpeedTolerance : FMath::Max(BrakingSpeedTolerance, BRAKE_TO_STOP_VELOCITY);
 
-			// subdivide braking to get reasonably consistent results at lower frame rates
-			// (important for packet loss situations w/ networking)
-			float RemainingTime = TimeStep;
-			const float MaxTimeStep = (1.0f / 33.0f);
-
-			// Decelerate to brake to a stop
-			const FVector RevAccel = (bZeroBraking ? FVector::ZeroVector : (BrakingDeceleration * LastVelocity.GetSafeNormal()));
-			while (RemainingTime >= MIN_TICK_TIME)
-			{
-				// Zero friction uses constant deceleration, so no need for iteration.
-				const float dt = ((RemainingTime > MaxTimeStep && !bZeroBrakingFriction) ? FMath::Min(MaxTimeStep, RemainingTime * 0.5f) : RemainingTime);
-				RemainingTime -= dt;
-
-				// apply friction and braking (reverse acceleration).
-				LastVelocity -= (LastVelocity * ActualBrakingFriction + RevAccel) * dt;
+	// Braking without acceleration follows dv/dt = -(f * v + d) along the velocity direction where fluid friction just adds up to
+	// braking friction, so it can be solved in closed form.
+	if (bZeroAcceleration)
+	{
+		const float Speed = LastVelocity.Size();
+		const FVector Direction = LastVelocity.GetSafeNormal();
+		const float TotalFriction = ActualBrakingFriction + (bZeroFluidFriction ? 0.f : Friction);
 
-				// Don't reverse direction
-				if ((LastVelocity | OldVelocity) <= 0.f)
-					return true;
-			}
-		}
-		else
+		float StopTime, StopDistance;
+		if (FMathEx::ComputeBrakingStop(Speed, TotalFriction, BrakingDeceleration, StopSpeed, StopTime, StopDistance) && StopTime <= TimeLimit)
 		{
-			// Friction affects our ability to change direction. This is only done for input acceleration, not path following.
-			const float VelSize = LastVelocity.Size();
-			LastVelocity = LastVelocity - (LastVelocity - AccelDir * VelSize) * FMath::Min(TimeStep * Friction, 1.f);
+			OutStopTime = StopTime;
+			OutStopDistance = StopDistance;
+			OutStopLocation += Direction * StopDistance;
+			return true;
 		}
 
+		OutStopTime = TimeLimit;
+		OutStopDistance = FMathEx::ComputeBrakingDistance(Speed, TotalFriction, BrakingDeceleration, TimeLimit);
+		OutStopLocation += Direction * OutStopDistance;
+		return false;
+	}
+
+	// Stepping fallback for when input acceleration is steering velocity
+	const int32 MaxPredictionIterations = TimeLimit / TimeStep;
+	for (int32 Iterations = 0; Iterations < MaxPredictionIterations; ++Iterations)
+	{
+		// Friction affects our ability to change direction. This is only done for input acceleration, not path following.
+		const float VelSize = LastVelocity.Size();
+		LastVelocity = LastVelocity - (LastVelocity - AccelDir * VelSize) * FMath::Min(TimeStep * Friction, 1.f);
+
 		// Apply fluid friction
 		if (bFluid)
 		{
@@ -1552,7 +2976,10 @@ bool UExtCharacterMovementComponent::PredictStopLocation(FVector& OutStopLocatio
 		if (LastVelocitySquared <= FMath::Square(BrakingSpeedTolerance) || (!bZeroBraking && LastVelocitySquared < (BRAKE_TO_STOP_VELOCITY * BRAKE_TO_STOP_VELOCITY)))
 			return true;
 
-		OutStopLocation += LastVelocity * TimeStep;
+		const FVector Delta = LastVelocity * TimeStep;
+		OutStopLocation += Delta;
+		OutStopDistance += Delta.Size();
+		OutStopTime += TimeStep;
 	}
 
 	return false;
@@ -1590,6 +3017,19 @@ FNetworkPredictionData_Client* UExtCharacterMovementComponent::GetPredictionData
 	return ClientPredictionData;
 }
 
+bool UExtCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ExtCharacterMovement_ClientReplay);
+
+	if (bUpdatePosition && ClientPredictionData)
+	{
+		INC_DWORD_STAT(STAT_ExtCharacterMovement_ClientCorrections);
+		INC_DWORD_STAT_BY(STAT_ExtCharacterMovement_ClientReplayedMoves, ClientPredictionData->SavedMoves.Num());
+	}
+
+	return Super::ClientUpdatePositionAfterServerUpdate();
+}
+
 void FSavedMove_ExtCharacter::Clear()
 {
 	Super::Clear();
@@ -1637,15 +3077,62 @@ uint8 FSavedMove_ExtCharacter::GetCompressedFlags() const
 
 FNetworkPredictionData_Client_ExtCharacter::FNetworkPredictionData_Client_ExtCharacter(const UCharacterMovementComponent& ClientMovement)
 	: Super(ClientMovement)
+	, MovePoolCursor(0)
 {
+	// Enough slots for a full saved move list plus the pending, last acked and newly created moves.
+	const int32 PoolSize = MaxSavedMoveCount + 3;
+	MovePool.SetNum(PoolSize);
+
+	// Moves are owned by the pool, the shared pointers must never delete them
+	MovePoolPtrs.Reserve(PoolSize);
+	for (FSavedMove_ExtCharacter& Move : MovePool)
+	{
+		MovePoolPtrs.Add(MakeShareable(&Move, [](FSavedMove_ExtCharacter*) {}));
+	}
+
+	// Prime the free list so that CreateSavedMove never has to call AllocateNewMove in the steady state.
+	const int32 NumFreeMoves = FMath::Min(PoolSize, MaxFreeMoveCount);
+	FreeMoves.Reserve(NumFreeMoves);
+	for (int32 Index = 0; Index < NumFreeMoves; ++Index)
+	{
+		FreeMoves.Push(AllocateNewMove());
+	}
+}
 
+FNetworkPredictionData_Client_ExtCharacter::~FNetworkPredictionData_Client_ExtCharacter()
+{
+	// Release every reference to pooled moves before the pool itself is destroyed as base members outlive ours.
+	SavedMoves.Empty();
+	FreeMoves.Empty();
+	PendingMove.Reset();
+	LastAckedMove.Reset();
+	MovePoolPtrs.Empty();
 }
 
 FSavedMovePtr FNetworkPredictionData_Client_ExtCharacter::AllocateNewMove()
 {
-	// Full override to instatiate our own saved move class
+	// Full override to instatiate our own saved move class from the contiguous pool
 	FULL_OVERRIDE();
 
+	const int32 PoolSize = MovePool.Num();
+	for (int32 Count = 0; Count < PoolSize; ++Count)
+	{
+		const int32 Index = MovePoolCursor;
+		MovePoolCursor = (MovePoolCursor + 1) % PoolSize;
+
+		// Only referenced by the pool, so neither saved, pending, acked nor in the free list
+		if (MovePoolPtrs[Index].GetSharedReferenceCount() == 1)
+		{
+			INC_DWORD_STAT(STAT_ExtCharacterMovement_MovePoolAllocations);
+
+			MovePool[Index].Clear();
+			return MovePoolPtrs[Index];
+		}
+	}
+
+	// Pool exhausted, this should only happen if MaxSavedMoveCount was changed after construction.
+	INC_DWORD_STAT(STAT_ExtCharacterMovement_MoveHeapAllocations);
+
 	return FSavedMovePtr(new FSavedMove_ExtCharacter());
 }
 
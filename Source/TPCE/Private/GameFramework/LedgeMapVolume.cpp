@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/LedgeMapVolume.h"
+#include "Components/BrushComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLedgeMap, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("LedgeMap Build"), STAT_LedgeMap_Build, STATGROUP_Game);
+
+TArray<ALedgeMapVolume*> ALedgeMapVolume::ActiveLedgeMaps;
+
+/** Marks an unused layer. */
+static const float NoLayerHeight = -MAX_flt;
+
+/** Upper bound on the number of traces per cell, thick geometry is crossed in steps of LayerClearance. */
+static const int32 MaxTracesPerCell = 64;
+
+ALedgeMapVolume::ALedgeMapVolume()
+{
+	GetBrushComponent()->SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+
+	bBuildOnBeginPlay = false;
+	CellSize = 25.f;
+	MaxLayers = 4;
+	LayerClearance = 180.f;
+	WalkableFloorAngle = 44.765f;
+	CollisionChannel = ECC_Pawn;
+
+	BakedOrigin = FVector::ZeroVector;
+	BakedSize = FIntPoint::ZeroValue;
+	BakedCellSize = CellSize;
+	BakedMaxLayers = MaxLayers;
+}
+
+void ALedgeMapVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bBuildOnBeginPlay)
+		Build();
+
+	ActiveLedgeMaps.AddUnique(this);
+}
+
+void ALedgeMapVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ActiveLedgeMaps.RemoveSwap(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALedgeMapVolume::Build()
+{
+	SCOPE_CYCLE_COUNTER(STAT_LedgeMap_Build);
+
+	UWorld* World = GetWorld();
+	const FBox Bounds = GetComponentsBoundingBox(true);
+	if (!World || !Bounds.IsValid)
+		return;
+
+	Modify();
+
+	BakedCellSize = FMath::Max(CellSize, 1.f);
+	BakedMaxLayers = FMath::Clamp(MaxLayers, 1, 8);
+	BakedOrigin = Bounds.Min;
+	BakedSize.X = FMath::Max(1, FMath::CeilToInt(Bounds.GetSize().X / BakedCellSize));
+	BakedSize.Y = FMath::Max(1, FMath::CeilToInt(Bounds.GetSize().Y / BakedCellSize));
+
+	LayerHeights.Init(NoLayerHeight, BakedSize.X * BakedSize.Y * BakedMaxLayers);
+	LayerFlags.Init(0, LayerHeights.Num());
+
+	const float WalkableFloorZ = FMath::Cos(FMath::DegreesToRadians(WalkableFloorAngle));
+	const float TraceStep = FMath::Max(LayerClearance, 1.f);
+
+	// Same channel characters sweep against, geometry that is not static is flagged since it may move. Pawns are never floors to bake.
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LedgeMapBuild), false, this);
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+
+	int32 NumFloors = 0;
+	int32 NumObstructed = 0;
+	int32 NumDynamic = 0;
+	for (int32 Y = 0; Y < BakedSize.Y; ++Y)
+	{
+		for (int32 X = 0; X < BakedSize.X; ++X)
+		{
+			const int32 CellIndex = GetCellIndex(X, Y);
+			const FVector2D Center(BakedOrigin.X + (X + 0.5f) * BakedCellSize, BakedOrigin.Y + (Y + 0.5f) * BakedCellSize);
+
+			// Trace down repeatedly from the top of the volume, skipping LayerClearance below every hit to find the floors beneath
+			float TopZ = Bounds.Max.Z;
+			int32 Layer = 0;
+			for (int32 Trace = 0; Trace < MaxTracesPerCell && Layer < BakedMaxLayers && TopZ > Bounds.Min.Z; ++Trace)
+			{
+				FHitResult Hit;
+				if (!World->LineTraceSingleByChannel(Hit, FVector(Center, TopZ), FVector(Center, Bounds.Min.Z), CollisionChannel, QueryParams, ResponseParams))
+					break;
+
+				if (!Hit.bStartPenetrating && Hit.ImpactNormal.Z >= WalkableFloorZ)
+				{
+					uint8 Flags = 0;
+
+					const UPrimitiveComponent* Component = Hit.Component.Get();
+					if (!Component || Component->Mobility != EComponentMobility::Static)
+					{
+						Flags |= LEDGEMAPLAYER_Dynamic;
+						++NumDynamic;
+					}
+
+					// A character must be able to stand on the floor, anything blocking above it obstructs a side step as it would the ledge sweep
+					FHitResult ClearanceHit;
+					const FVector FloorLocation(Center, Hit.ImpactPoint.Z + KINDA_SMALL_NUMBER);
+					if (World->LineTraceSingleByChannel(ClearanceHit, FloorLocation, FloorLocation + FVector(0.f, 0.f, TraceStep), CollisionChannel, QueryParams, ResponseParams))
+					{
+						Flags |= LEDGEMAPLAYER_Obstructed;
+						++NumObstructed;
+					}
+
+					LayerHeights[CellIndex + Layer] = Hit.ImpactPoint.Z;
+					LayerFlags[CellIndex + Layer] = Flags;
+					++Layer;
+					++NumFloors;
+				}
+
+				TopZ = (Hit.bStartPenetrating ? TopZ : Hit.ImpactPoint.Z) - TraceStep;
+			}
+		}
+	}
+
+	UE_LOG(LogLedgeMap, Log, TEXT("%s: baked %d floors (%d obstructed, %d dynamic) in %dx%d cells."), *GetName(), NumFloors, NumObstructed, NumDynamic, BakedSize.X, BakedSize.Y);
+}
+
+void ALedgeMapVolume::Clear()
+{
+	Modify();
+
+	LayerHeights.Empty();
+	LayerFlags.Empty();
+	BakedSize = FIntPoint::ZeroValue;
+}
+
+ELedgeMapQueryResult ALedgeMapVolume::QueryFloor(const FVector& Location, float Radius, float MinZ, float MaxZ) const
+{
+	if (!IsBuilt())
+		return ELedgeMapQueryResult::Unknown;
+
+	const int32 MinX = FMath::FloorToInt((Location.X - Radius - BakedOrigin.X) / BakedCellSize);
+	const int32 MinY = FMath::FloorToInt((Location.Y - Radius - BakedOrigin.Y) / BakedCellSize);
+	const int32 MaxX = FMath::FloorToInt((Location.X + Radius - BakedOrigin.X) / BakedCellSize);
+	const int32 MaxY = FMath::FloorToInt((Location.Y + Radius - BakedOrigin.Y) / BakedCellSize);
+	if (MinX < 0 || MinY < 0 || MaxX >= BakedSize.X || MaxY >= BakedSize.Y)
+		return ELedgeMapQueryResult::Unknown;
+
+	bool bHasDynamicFloor = false;
+	for (int32 Y = MinY; Y <= MaxY; ++Y)
+	{
+		for (int32 X = MinX; X <= MaxX; ++X)
+		{
+			const int32 CellIndex = GetCellIndex(X, Y);
+			for (int32 Layer = 0; Layer < BakedMaxLayers; ++Layer)
+			{
+				// Layers are sorted from top to bottom
+				const float Height = LayerHeights[CellIndex + Layer];
+				if (Height < MinZ)
+					break;
+
+				if (Height > MaxZ)
+					continue;
+
+				const uint8 Flags = LayerFlags[CellIndex + Layer];
+				if (Flags & LEDGEMAPLAYER_Dynamic)
+					bHasDynamicFloor = true;
+				else if (!(Flags & LEDGEMAPLAYER_Obstructed))
+					return ELedgeMapQueryResult::Floor;
+			}
+		}
+	}
+
+	return bHasDynamicFloor ? ELedgeMapQueryResult::Unknown : ELedgeMapQueryResult::NoFloor;
+}
+
+const ALedgeMapVolume* ALedgeMapVolume::Find(const UWorld* World, const FVector& Location)
+{
+	for (const ALedgeMapVolume* LedgeMap : ActiveLedgeMaps)
+	{
+		if (LedgeMap->GetWorld() != World || !LedgeMap->IsBuilt())
+			continue;
+
+		const FVector2D Local = FVector2D(Location - LedgeMap->BakedOrigin) / LedgeMap->BakedCellSize;
+		if (Local.X >= 0.f && Local.Y >= 0.f && Local.X < LedgeMap->BakedSize.X && Local.Y < LedgeMap->BakedSize.Y)
+			return LedgeMap;
+	}
+
+	return nullptr;
+}
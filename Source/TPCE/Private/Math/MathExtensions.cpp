@@ -396,6 +396,54 @@ FORCEINLINE static bool CheckCardinalDirection(const float Angle, const bool bIs
 		: (Angle >= (Min + Buffer) && Angle <= (Max - Buffer));
 }
 
+bool FMathEx::ComputeBrakingStop(const float Speed, const float Friction, const float Deceleration, const float StopSpeed, float& OutStopTime, float& OutStopDistance)
+{
+	OutStopTime = 0.f;
+	OutStopDistance = 0.f;
+
+	if (Speed <= StopSpeed)
+		return true;
+
+	if (Friction <= 0.f)
+	{
+		// Constant deceleration
+		if (Deceleration <= 0.f)
+			return false;
+
+		OutStopTime = (Speed - StopSpeed) / Deceleration;
+		OutStopDistance = (FMath::Square(Speed) - FMath::Square(StopSpeed)) / (2.f * Deceleration);
+		return true;
+	}
+
+	// Exponential decay towards -Deceleration/Friction. With no deceleration speed only approaches zero asymptotically.
+	if (Deceleration <= 0.f && StopSpeed <= 0.f)
+		return false;
+
+	OutStopTime = FMath::Loge((Friction * Speed + Deceleration) / (Friction * StopSpeed + Deceleration)) / Friction;
+	OutStopDistance = (Speed - StopSpeed - Deceleration * OutStopTime) / Friction;
+	return true;
+}
+
+float FMathEx::ComputeBrakingDistance(const float Speed, const float Friction, const float Deceleration, const float Time)
+{
+	if (Speed <= 0.f || Time <= 0.f)
+		return 0.f;
+
+	if (Friction <= 0.f)
+	{
+		if (Deceleration <= 0.f)
+			return Speed * Time;
+
+		const float T = FMath::Min(Time, Speed / Deceleration);
+		return Speed * T - 0.5f * Deceleration * FMath::Square(T);
+	}
+
+	// Limit time to when speed reaches zero
+	const float T = (Deceleration > 0.f) ? FMath::Min(Time, FMath::Loge(1.f + Friction * Speed / Deceleration) / Friction) : Time;
+	const float SpeedAtT = (Speed + Deceleration / Friction) * FMath::Exp(-Friction * T) - Deceleration / Friction;
+	return (Speed - FMath::Max(SpeedAtT, 0.f) - Deceleration * T) / Friction;
+}
+
 ECardinalDirection FMathEx::FindCardinalDirection(float Angle, const ECardinalDirection CurrentCardinalDirection, const float NorthSegmentHalfWidth, const float Buffer)
 {
 	if (CheckCardinalDirection(Angle, CurrentCardinalDirection == ECardinalDirection::North, -NorthSegmentHalfWidth, NorthSegmentHalfWidth, Buffer))
@@ -2,6 +2,8 @@
 
 #include "TPCE.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/World.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
 
 DEFINE_LOG_CATEGORY(LogTPCE)
 
@@ -9,15 +11,32 @@ DEFINE_LOG_CATEGORY(LogTPCE)
 
 class FTPCE: public IModuleInterface
 {
+private:
+
+	FDelegateHandle LevelAddedDelegateHandle;
+	FDelegateHandle LevelRemovedDelegateHandle;
+
+	static void HandleLevelChanged(ULevel* Level, UWorld* World)
+	{
+		UExtCharacterMovementComponent::InvalidateAllFloorCaches();
+	}
+
 public:
 
 	virtual void StartupModule() override
 	{
+		// Floors cached by character movement components may belong to levels being streamed in or out
+		LevelAddedDelegateHandle = FWorldDelegates::LevelAddedToWorld.AddStatic(&FTPCE::HandleLevelChanged);
+		LevelRemovedDelegateHandle = FWorldDelegates::LevelRemovedFromWorld.AddStatic(&FTPCE::HandleLevelChanged);
+
 		UE_LOG(LogTPCE, Log, TEXT("Third Person Character Extensions (TPCE) Module Started"));
 	}
     
 	virtual void ShutdownModule() override
 	{
+		FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedDelegateHandle);
+		FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedDelegateHandle);
+
 		UE_LOG(LogTPCE, Log, TEXT("Third Person Character Extensions (TPCE) Module Shutdown"));
 	}
 };
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/ExtCharacterBenchmark.h"
+#include "AssetRegistryModule.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameMapsSettings.h"
+#include "Misc/PackageName.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Time in seconds a benchmark may take before the test fails. Default stages take about a minute. */
+static const float ExtCharacterBenchmarkTimeout = 600.f;
+
+/** Wait until the benchmark started by TPCE.Benchmark in the current game world has written its results. Fails if it could not start or run. */
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FWaitForExtCharacterBenchmarkCommand, FAutomationTestBase*, Test);
+
+bool FWaitForExtCharacterBenchmarkCommand::Update()
+{
+	const AExtCharacterBenchmark* Benchmark = nullptr;
+	if (UWorld* World = AutomationCommon::GetAnyGameWorld())
+	{
+		for (TActorIterator<AExtCharacterBenchmark> It(World); It; ++It)
+		{
+			Benchmark = *It;
+			break;
+		}
+	}
+
+	if (!Benchmark)
+	{
+		Test->AddError(TEXT("Benchmark was not started, see the log for details."));
+		return true;
+	}
+
+	switch (Benchmark->GetPhase())
+	{
+	case EExtCharacterBenchmarkPhase::Finished:
+		return true;
+	case EExtCharacterBenchmarkPhase::Failed:
+	case EExtCharacterBenchmarkPhase::Idle:
+		Test->AddError(TEXT("Benchmark failed, see the log for details."));
+		return true;
+	default:
+		break;
+	}
+
+	if (GetCurrentRunTime() > ExtCharacterBenchmarkTimeout)
+	{
+		Test->AddError(FString::Printf(TEXT("Benchmark did not finish in %.0f seconds."), ExtCharacterBenchmarkTimeout));
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Load each map whose name contains "Benchmark", or the game default map if there is none, and run TPCE.Benchmark with its default stages. Results are written to the profiling directory.
+ * Run headless with: -nullrhi -ExecCmds="Automation RunTests TPCE.Benchmark"
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FExtCharacterBenchmarkTest, "TPCE.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FExtCharacterBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	TArray<FAssetData> MapAssets;
+	AssetRegistry.GetAssetsByClass(UWorld::StaticClass()->GetFName(), MapAssets);
+	for (const FAssetData& MapAsset : MapAssets)
+	{
+		const FString MapName = MapAsset.AssetName.ToString();
+		if (MapName.Contains(TEXT("Benchmark")))
+		{
+			OutBeautifiedNames.Add(MapName);
+			OutTestCommands.Add(MapAsset.PackageName.ToString());
+		}
+	}
+
+	// Without a dedicated map measure in the game default map
+	if (OutTestCommands.Num() == 0)
+	{
+		const FString DefaultMap = UGameMapsSettings::GetGameDefaultMap();
+		if (!DefaultMap.IsEmpty())
+		{
+			OutBeautifiedNames.Add(FPackageName::GetShortName(DefaultMap));
+			OutTestCommands.Add(DefaultMap);
+		}
+	}
+}
+
+bool FExtCharacterBenchmarkTest::RunTest(const FString& Parameters)
+{
+	if (!AutomationOpenMap(Parameters))
+	{
+		AddError(FString::Printf(TEXT("Could not open %s."), *Parameters));
+		return false;
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FExecWorldStringLatentCommand(TEXT("TPCE.Benchmark")));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForExtCharacterBenchmarkCommand(this));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/ExtCharacterTestCharacter.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Empty game world that has begun play, destroyed with the scope. */
+struct FExtCharacterTestWorld
+{
+	UWorld* World;
+
+	FExtCharacterTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+	}
+
+	~FExtCharacterTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+};
+
+/** Result of simulating a character moving forward with fixed timesteps. */
+struct FFixedTimestepResult
+{
+	FVector Location;
+	FVector Velocity;
+	FQuat Rotation;
+};
+
+/** Fly a character forward for Duration seconds ticking its movement at FrameRate with the same fixed timestep. */
+static FFixedTimestepResult SimulateFixedTimestep(UWorld* World, float FrameRate, float Duration)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.bDeferConstruction = true;
+
+	AExtCharacterTestCharacter* Character = World->SpawnActor<AExtCharacterTestCharacter>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	check(Character);
+
+	// Nothing but the fixed timestep may depend on the frame rate
+	UExtCharacterMovementComponent* Movement = Character->GetExtCharacterMovement();
+	Movement->bRunPhysicsWithNoController = true;
+	Movement->bUseFixedTimestep = true;
+	Movement->bUseCrowdMovementManager = false;
+	Movement->bEnableMovementLOD = false;
+	Movement->bEnableSleep = false;
+	Movement->FixedTimestep = 1.f / 64.f;
+	Movement->MaxFixedTimestepIterations = 4;
+
+	Character->FinishSpawning(FTransform::Identity);
+	Movement->SetMovementMode(MOVE_Flying);
+
+	// Frame rates are powers of two so frames add up to whole steps without rounding
+	const float DeltaTime = 1.f / FrameRate;
+	const int32 NumFrames = FMath::RoundToInt(Duration * FrameRate);
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Character->AddMovementInput(FVector::ForwardVector, 1.f, true);
+		Movement->TickComponent(DeltaTime, LEVELTICK_All, &Movement->PrimaryComponentTick);
+	}
+
+	FFixedTimestepResult Result;
+	Result.Location = Movement->UpdatedComponent->GetComponentLocation();
+	Result.Velocity = Movement->Velocity;
+	Result.Rotation = Movement->UpdatedComponent->GetComponentQuat();
+
+	Character->Destroy();
+	return Result;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FExtCharacterMovementFixedTimestepTest, "TPCE.Movement.FixedTimestep.FrameRateIndependence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FExtCharacterMovementFixedTimestepTest::RunTest(const FString& Parameters)
+{
+	FExtCharacterTestWorld TestWorld;
+
+	// Low frame rate runs two steps per frame, high frame rate one step every other frame
+	const FFixedTimestepResult Low = SimulateFixedTimestep(TestWorld.World, 32.f, 1.f);
+	const FFixedTimestepResult High = SimulateFixedTimestep(TestWorld.World, 128.f, 1.f);
+
+	TestTrue(TEXT("Character moved"), Low.Location.X > 0.f);
+
+	// Same steps with the same inputs must give bit identical results
+	TestTrue(FString::Printf(TEXT("Location at 32 and 128 FPS: %s and %s"), *Low.Location.ToString(), *High.Location.ToString()), Low.Location == High.Location);
+	TestTrue(FString::Printf(TEXT("Velocity at 32 and 128 FPS: %s and %s"), *Low.Velocity.ToString(), *High.Velocity.ToString()), Low.Velocity == High.Velocity);
+	TestTrue(FString::Printf(TEXT("Rotation at 32 and 128 FPS: %s and %s"), *Low.Rotation.ToString(), *High.Rotation.ToString()), Low.Rotation == High.Rotation);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
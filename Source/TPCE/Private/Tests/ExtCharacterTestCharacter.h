@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/ExtCharacter.h"
+
+#include "ExtCharacterTestCharacter.generated.h"
+
+/** Concrete ExtCharacter without mesh or animation assets, spawned by automation tests. */
+UCLASS(NotBlueprintable, NotPlaceable, Transient, HideDropdown)
+class AExtCharacterTestCharacter : public AExtCharacter
+{
+	GENERATED_BODY()
+};
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Animation/AnimNodeBase.h"
+#include "AnimNode_DistanceMatching.generated.h"
+
+class UAnimSequenceBase;
+struct FExtLocomotionSnapshot;
+struct FRichCurve;
+
+/** Movement event a distance matching node is matched against. */
+UENUM(BlueprintType)
+enum class EDistanceMatchingType : uint8
+{
+	/** Curve holds the distance travelled since the character started moving. */
+	Start,
+	/** Curve holds the distance remaining to the stop location, as generated by the Distance Curve factory. */
+	Stop,
+	/** Curve holds the signed distance to the pivot: negative while approaching it and positive after it. */
+	Pivot,
+	/** Curve holds the height above the landing location. */
+	Landing
+};
+
+/**
+ * Inverse of a monotonic curve sampled at uniform value intervals so value to time queries are a single lerp.
+ * Baked once per sequence instead of searching the curve keys on every query.
+ */
+struct TPCE_API FDistanceCurveLookupTable
+{
+	/** Times at uniformly spaced values from MinValue to MaxValue. */
+	TArray<float> Times;
+
+	float MinValue;
+	float MaxValue;
+
+	/** Number of samples per unit of value. */
+	float SamplesPerUnit;
+
+	/** Whether curve values increase over time. */
+	bool bIsIncreasing;
+
+	FDistanceCurveLookupTable() :
+		MinValue(0.f),
+		MaxValue(0.f),
+		SamplesPerUnit(0.f),
+		bIsIncreasing(true)
+	{}
+
+	/**
+	 * Bake NumSamples samples of the inverse of Curve.
+	 * @return false if the curve has less than two keys or is not monotonic, in which case the table is left empty.
+	 */
+	bool Bake(const FRichCurve& Curve, int32 NumSamples);
+
+	void Reset();
+
+	FORCEINLINE bool IsValid() const { return Times.Num() > 1; }
+
+	/** @return true if Value is at or beyond the value the curve ends with. */
+	FORCEINLINE bool IsPastEnd(float Value) const { return bIsIncreasing ? Value >= MaxValue : Value <= MinValue; }
+
+	/** @return time at which the curve reaches Value. Values out of range are clamped. */
+	FORCEINLINE float GetTime(float Value) const
+	{
+		const float Position = FMath::Clamp((Value - MinValue) * SamplesPerUnit, 0.f, float(Times.Num() - 1));
+		const int32 Index = FMath::Min(FMath::FloorToInt(Position), Times.Num() - 2);
+		return FMath::Lerp(Times[Index], Times[Index + 1], Position - Index);
+	}
+};
+
+/**
+ * Plays a sequence by matching a distance curve embedded in it to the distance the character has left or has covered,
+ * so feet do not slide when starting, stopping, pivoting or landing regardless of speed or braking settings.
+ *
+ * The curve is resolved once when the sequence is set and baked into a lookup table. The distance can be read from the stop and landing
+ * predictions in the locomotion snapshot of the owner's ExtCharacterMovementComponent or fed through the Distance pin.
+ * @see UExtCharacterMovementComponent::ReadLocomotionSnapshot, UExtCharacterMovementComponent::PredictStop
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct TPCE_API FAnimNode_DistanceMatching : public FAnimNode_AssetPlayerBase
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Sequence to play. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault))
+	UAnimSequenceBase* Sequence;
+
+	/** Name of the distance curve in Sequence. */
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FName DistanceCurveName;
+
+	/** Movement event to match. */
+	UPROPERTY(EditAnywhere, Category = Settings)
+	EDistanceMatchingType MatchingType;
+
+	/** If true the distance is computed from the locomotion snapshot of the owner's ExtCharacterMovementComponent, otherwise Distance is used. */
+	UPROPERTY(EditAnywhere, Category = Settings)
+	uint32 bUseMovementPrediction : 1;
+
+	/** Distance to match when bUseMovementPrediction is false, following the convention of MatchingType. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinShownByDefault))
+	float Distance;
+
+	/** Play rate once the matched distance is past the end of the curve, e.g. after the stop location has been reached. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault, ClampMin = "0", UIMin = "0"))
+	float PlayRate;
+
+	/** Number of samples in the baked lookup table. */
+	UPROPERTY(EditAnywhere, Category = Settings, meta = (ClampMin = "2", UIMin = "2", ClampMax = "1024", UIMax = "1024"), AdvancedDisplay)
+	int32 LookupTableSize;
+
+protected:
+
+	/** Sequence the lookup table was baked for. */
+	UAnimSequenceBase* BakedSequence;
+
+	FDistanceCurveLookupTable LookupTable;
+
+	/** Distance gathered from the locomotion snapshot in PreUpdate. */
+	float MovementDistance;
+
+	/** Whether MovementDistance holds a valid prediction. */
+	bool bHasMovementDistance;
+
+	/** [Start, Pivot] Location the distance is measured from. */
+	FVector MarkerLocation;
+
+	/** [Pivot] Whether MarkerLocation holds a predicted pivot. */
+	bool bHasPivotLocation;
+
+	/** Whether the node has just become relevant. */
+	bool bReinitialized;
+
+public:
+
+	FAnimNode_DistanceMatching();
+
+	// FAnimNode_AssetPlayerBase interface
+	virtual float GetCurrentAssetTime() override;
+	virtual float GetCurrentAssetLength() override;
+	virtual UAnimationAsset* GetAnimAsset() override;
+	// End of FAnimNode_AssetPlayerBase interface
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override {}
+	virtual void UpdateAssetPlayer(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void OverrideAsset(UAnimationAsset* NewAsset) override;
+	virtual bool HasPreUpdate() const override { return bUseMovementPrediction; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	// End of FAnimNode_Base interface
+
+protected:
+
+	/** Bake the lookup table if Sequence has changed. */
+	void UpdateLookupTable();
+
+	/** [game thread] Compute the distance to match from a locomotion snapshot. @return false if it cannot be predicted. */
+	bool GatherMovementDistance(const FExtLocomotionSnapshot& Locomotion, float& OutDistance);
+};
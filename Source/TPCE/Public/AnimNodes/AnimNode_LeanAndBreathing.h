@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "BoneContainer.h"
+#include "BonePose.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "AnimNode_LeanAndBreathing.generated.h"
+
+/** Bone rotated by a lean and breathing node and how much of each it takes. */
+USTRUCT(BlueprintType)
+struct FLeanAndBreathingBone
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FBoneReference Bone;
+
+	/** Fraction of the lean applied to this bone. Fractions of the chain should add up to 1. */
+	UPROPERTY(EditAnywhere, Category = Settings, meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "1.0", UIMax = "1.0"))
+	float LeanWeight;
+
+	/** Fraction of the breathing applied to this bone. Fractions of the chain should add up to 1. */
+	UPROPERTY(EditAnywhere, Category = Settings, meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "1.0", UIMax = "1.0"))
+	float BreathingWeight;
+
+	FLeanAndBreathingBone() :
+		LeanWeight(0.f),
+		BreathingWeight(0.f)
+	{}
+};
+
+/**
+ * Procedural lean into acceleration and turns plus idle and exerted breathing, applied as component space rotations of a pelvis and spine chain.
+ *
+ * Lean is computed natively from the locomotion snapshot published by the owner's ExtCharacterMovementComponent: lateral and longitudinal acceleration
+ * in relation to the character rotation, the centripetal acceleration of turning (ground speed times yaw rate) and the gait. Breathing is a sine wave on
+ * the pitch of the chain whose rate rises with exertion. The node replaces the Blueprint lean math and the additive blend nodes it fed.
+ *
+ * Bones must form a chain ordered from root to tip, e.g. pelvis, spine_01, spine_02, spine_03. Each bone keeps its offset to the previous one so the
+ * rotations accumulate along the chain. When the pelvis is included place the node before foot IK so feet stay planted.
+ * Besides the LOD threshold of every skeletal control the node is skipped above MaxBudgetLODLevel.
+ * @see UExtCharacterMovementComponent::ReadLocomotionSnapshot, UExtCharacterAnimInstance::GetBudgetLODLevel
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct TPCE_API FAnimNode_LeanAndBreathing : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Chain of bones to rotate, ordered from root to tip. */
+	UPROPERTY(EditAnywhere, Category = Settings)
+	TArray<FLeanAndBreathingBone> Bones;
+
+	/** Largest lean angle in degrees, reached at MaxLeanAcceleration. Use a negative angle to lean away from acceleration. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Lean, meta = (PinHiddenByDefault))
+	float MaxLeanAngle;
+
+	/** Acceleration in cm/s^2 at which the lean reaches MaxLeanAngle. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "1", UIMin = "1"))
+	float MaxLeanAcceleration;
+
+	/** Fraction of the lean used for longitudinal acceleration (forward and backward). Lateral acceleration always uses the full lean. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "1.0", UIMax = "1.0"))
+	float LongitudinalLeanScale;
+
+	/** Scale of the lean when walking. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float WalkLeanScale;
+
+	/** Scale of the lean when running. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float RunLeanScale;
+
+	/** Scale of the lean when sprinting. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "0.0", UIMin = "0.0"))
+	float SprintLeanScale;
+
+	/** How fast the lean reaches its target. Use 0 for immediate. */
+	UPROPERTY(EditAnywhere, Category = Lean, meta = (ClampMin = "0", UIMin = "0"))
+	float LeanInterpSpeed;
+
+	/** Breaths per minute when resting. */
+	UPROPERTY(EditAnywhere, Category = Breathing, meta = (ClampMin = "0", UIMin = "0"))
+	float RestingBreathingRate;
+
+	/** Breaths per minute when fully exerted, i.e. after sprinting for a while. */
+	UPROPERTY(EditAnywhere, Category = Breathing, meta = (ClampMin = "0", UIMin = "0"))
+	float ExertedBreathingRate;
+
+	/** Pitch in degrees of a full breath when resting. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Breathing, meta = (PinHiddenByDefault))
+	float RestingBreathingAngle;
+
+	/** Pitch in degrees of a full breath when fully exerted. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Breathing, meta = (PinHiddenByDefault))
+	float ExertedBreathingAngle;
+
+	/** How fast exertion follows the gait. Breathing should recover slowly after a sprint. Use 0 for immediate. */
+	UPROPERTY(EditAnywhere, Category = Breathing, meta = (ClampMin = "0", UIMin = "0"))
+	float ExertionInterpSpeed;
+
+	/** Highest budget LOD level of the owning ExtCharacter anim instance at which the node is still evaluated. */
+	UPROPERTY(EditAnywhere, Category = Performance, meta = (ClampMin = "0", UIMin = "0"))
+	int32 MaxBudgetLODLevel;
+
+protected:
+
+	/** Locomotion state gathered in PreUpdate. */
+	FExtLocomotionSnapshot Locomotion;
+
+	/** Whether Locomotion holds a published snapshot. */
+	bool bHasLocomotion;
+
+	/** Budget LOD level of the owning anim instance gathered in PreUpdate. */
+	int32 BudgetLODLevel;
+
+	/** Rotation from character space to component space, gathered in PreUpdate. */
+	FQuat CharacterToComponent;
+
+	/** Character yaw in the last update, used to find the yaw rate. */
+	float LastYaw;
+
+	/** Whether LastYaw holds the yaw of a previous update. */
+	bool bHasLastYaw;
+
+	/** Synchronized with the update counter of the anim instance on each update, to detect frames in which the node was not updated. */
+	FGraphTraversalCounter UpdateCounter;
+
+	/** Current lean in degrees. X is roll, Y is pitch. */
+	FVector2D CurrentLean;
+
+	/** Current exertion in the range [0, 1]. */
+	float Exertion;
+
+	/** Phase of the breathing cycle in radians. */
+	float BreathingPhase;
+
+public:
+
+	FAnimNode_LeanAndBreathing();
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	// End of FAnimNode_Base interface
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+private:
+
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Engine/DataAsset.h"
+
+#include "AnimationSharingSetup.generated.h"
+
+class UAnimSequenceBase;
+
+/** Locomotion state a character has to be in to share its pose with others. */
+UENUM(BlueprintType)
+enum class EAnimationSharingState : uint8
+{
+	Idle,
+	Walk,
+	Run,
+	Sprint,
+	CrouchIdle,
+	CrouchWalk
+};
+
+/**
+ * Pose shared by all characters in a locomotion state.
+ */
+USTRUCT(BlueprintType)
+struct TPCE_API FAnimationSharingStateSetup
+{
+	GENERATED_BODY()
+
+	/** Locomotion state. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing)
+	EAnimationSharingState State;
+
+	/** Sequence looped by the master poses of the state. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing)
+	UAnimSequenceBase* Sequence;
+
+	/** Number of master poses of the state, each at a different offset into Sequence. Followers are spread over them so crowds are not in sync. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing, meta = (ClampMin = "1", UIMin = "1", ClampMax = "8", UIMax = "8"))
+	int32 NumVariants;
+
+	FAnimationSharingStateSetup() :
+		State(EAnimationSharingState::Idle),
+		Sequence(nullptr),
+		NumVariants(2)
+	{}
+};
+
+/**
+ * Animation sharing settings of a kind of ambient character. Characters using the same setup and skeletal mesh that are in the same
+ * locomotion state copy their pose from a few master poses instead of updating their own anim instance.
+ * @see AAnimationSharingManager
+ * @see AExtCharacter::AnimationSharingSetup
+ */
+UCLASS(BlueprintType)
+class TPCE_API UAnimationSharingSetup : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/** States that can be shared. Characters in any other state use their own anim instance. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing)
+	TArray<FAnimationSharingStateSetup> States;
+
+	/** Ground speed under which a character is idle. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing, meta = (ClampMin = "0", UIMin = "0"))
+	float IdleSpeed;
+
+	/** Characters closer than this to a local view use their own anim instance. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing, meta = (ClampMin = "0", UIMin = "0"))
+	float PromotionDistance;
+
+	/**
+	 * Characters with an animation significance at or above this use their own anim instance.
+	 * @see AExtCharacter::AnimationSignificance
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = AnimationSharing, meta = (ClampMin = "0", UIMin = "0"))
+	float PromotionSignificance;
+
+	UAnimationSharingSetup();
+
+	/** @return setup of State or nullptr if it cannot be shared. */
+	const FAnimationSharingStateSetup* FindState(EAnimationSharingState State) const;
+};
@@ -5,8 +5,10 @@
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
 #include "UObject/ObjectMacros.h"
+#include "UObject/SoftObjectPtr.h"
 #include "Animation/AnimInstance.h"
 #include "Math/Bounds.h"
+#include "Animation/ExtCharacterAnimSettings.h"
 #include "ExtraTypes.h"
 
 #include "ExtCharacterAnimInstance.generated.h"
@@ -16,6 +18,7 @@ class UAnimSequence;
 class UCurveFloat;
 class AExtCharacter;
 class UExtCharacterMovementComponent;
+struct FExtCharacterAnimInstanceInput;
 
 USTRUCT(BlueprintType)
 struct FootIKOffset
@@ -79,39 +82,22 @@ class TPCE_API UExtCharacterAnimInstance : public UAnimInstance
 {
 	GENERATED_BODY()
 
+	friend struct FExtCharacterAnimInstanceProxy;
+
 public:
 
 	static const float AngleTolerance;
 
 	UExtCharacterAnimInstance();
 
-private:
-
-	uint32 bHasMovementModeChanged : 1;
-	uint32 bHasCrouchedChanged : 1;
-	uint32 bHasGaitChanged : 1;
-	uint32 bHasPerformingGenericActionChanged : 1;
-
-	/** Used to adjust the root bone rotation when in ragdoll */
-	FQuat RootBoneRotation;
-
-	/** */
-	float TurnInPlaceTargetYaw;
+	virtual void PostLoad() override;
 
-	/** */
-	FVector LastCharacterMeshLocation;
-
-	/** */
-	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess="true"))
-	AExtCharacter* CharacterOwner;
+private:
 
-	/** */
-	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess = "true"))
-	UExtCharacterMovementComponent* CharacterOwnerMovement;
+	// Hot state, read and written by every locomotion update. Declared first and together so an update touches as few cache lines as possible.
 
-	/** */
-	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess = "true"))
-	USkeletalMeshComponent* CharacterOwnerMesh;
+	/** Animation work to do, less than Full on dedicated servers. */
+	EDedicatedServerAnimationMode ServerAnimationMode;
 
 	/** Current movement mode of the character as indicated by its character movement component. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
@@ -129,6 +115,34 @@ private:
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
 	ECharacterRotationMode RotationMode;
 
+	/** 
+	 * If direction the character is pivot turning if bIsPivotTurning is true.
+	 * @see bIsPivotTurning
+	 */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|PivotTurn", meta = (AllowPrivateAccess = "true"))
+	ECardinalDirection PivotTurnDirection;
+
+	/** Cardinal direction of the movement vector (acceleration or velocity) in relation to the look rotation. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
+	ECardinalDirection LookCardinalDirection;
+
+	/**
+	 * Current state of the native locomotion state machine. Transitions are evaluated natively on every locomotion update so the anim graph
+	 * only needs a Blend Poses by ELocomotionState node bound to this property, which stays on the fast path.
+	 * @see NativeUpdateLocomotionState
+	 */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Locomotion", meta = (AllowPrivateAccess = "true"))
+	ELocomotionState LocomotionState;
+
+	/** State of the locomotion state machine before the last transition. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Locomotion", meta = (AllowPrivateAccess = "true"))
+	ELocomotionState LastLocomotionState;
+
+	uint32 bHasMovementModeChanged : 1;
+	uint32 bHasCrouchedChanged : 1;
+	uint32 bHasGaitChanged : 1;
+	uint32 bHasPerformingGenericActionChanged : 1;
+
 	/**
 	 * Indicates the character was moving (speed > 0) in any direction in the last frame. No reason can be implied for the movement. If you want to know if the
 	 * character is moving in the current frame use bIsMoving or bIsMoving2D.
@@ -189,6 +203,10 @@ private:
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
 	uint32 bIsJumping : 1;
 
+	/** Indicates the character is falling and the movement component has predicted where it's going to land. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Falling", meta = (AllowPrivateAccess = "true"))
+	uint32 bIsLandingPredicted : 1;
+
 	/** Indicates the character is performing action. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
 	uint32 bIsPerformingGenericAction : 1;
@@ -249,44 +267,57 @@ private:
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Foot IK", meta = (AllowPrivateAccess = "true"))
 	uint32 bEnableFootIK : 1;
 
-	/** 
-	 * If direction the character is pivot turning if bIsPivotTurning is true.
-	 * @see bIsPivotTurning
+	/** If true the locomotion state changed in the last locomotion update. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Locomotion", meta = (AllowPrivateAccess = "true"))
+	uint32 bHasLocomotionStateChanged : 1;
+
+	/**
+	 * Animation LOD chosen by the animation budget manager: 0 when updated every frame, 1 when frames are skipped and 2 at the lowest update rate.
+	 * Expensive nodes can be disabled through their LOD threshold or alpha based on it. Foot IK is disabled above 0.
+	 * @see AAnimationBudgetManager
 	 */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|PivotTurn", meta = (AllowPrivateAccess = "true"))
-	ECardinalDirection PivotTurnDirection;
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Optimization", meta = (AllowPrivateAccess = "true"))
+	int32 BudgetLODLevel;
 
-	/**  */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FVector LastCharacterLocation;
+	/** Sum of the DeltaSeconds of updates since the last locomotion update or a negative value if there was none. */
+	float LocomotionUpdateElapsedTime;
 
-	/**  */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator LastCharacterRotation;
+	/** */
+	float TurnInPlaceTargetYaw;
 
-	/**  */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FVector CharacterLocation;
+	/** Time in seconds spent in the current locomotion state. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Locomotion", meta = (AllowPrivateAccess = "true"))
+	float LocomotionStateTime;
 
-	/**  */
+	/** Current speed of the character. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator CharacterRotation;
+	float Speed;
 
-	/**  */
+	/** Current ground speed of the character. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator LookRotation;
+	float GroundSpeed;
 
-	/** The yaw delta between look rotation and character rotation. */
+	/** Current speed of the character. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator LookDelta;
+	float LastSpeed;
 
-	/** Actor the character should be trying to look at instead of using the normal rules for aim offset. */
+	/** Current ground speed of the character. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	AActor* LookAtActor;
+	float LastGroundSpeed;
 
-	/** Cardinal direction of the movement vector (acceleration or velocity) in relation to the look rotation. */
+	/** Any difference between course (velocity direction) and heading (characcter forward) in the XY plane. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	ECardinalDirection LookCardinalDirection;
+	float MovementDrift;
+
+	/** Predicted time in seconds until the character lands. Only valid if bIsLandingPredicted is true. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Falling", meta = (AllowPrivateAccess = "true"))
+	float TimeToLand;
+
+	/** Used to adjust the root bone rotation when in ragdoll */
+	FQuat RootBoneRotation;
+
+	/** */
+	FVector LastCharacterMeshLocation;
 
 	/** Current Velocity of the character. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
@@ -296,161 +327,49 @@ private:
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
 	FVector Acceleration;
 
-	/** Current speed of the character. */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float Speed;
-
-	/** Current ground speed of the character. */
+	/**  */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float GroundSpeed;
+	FVector CharacterLocation;
 
-	/** Current speed of the character. */
+	/**  */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float LastSpeed;
+	FRotator CharacterRotation;
 
-	/** Current ground speed of the character. */
+	/**  */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float LastGroundSpeed;
+	FVector LastCharacterLocation;
 
-	/** Last Non-Zero Acceleration imposed to the character. */
+	/**  */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator LastMovementAccelerationRotation;
+	FRotator LastCharacterRotation;
 
-	/** Last Acceleration Vector with a Non-Zero projection in the XY plane. */
+	/**  */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FVector LastMovementAcceleration;
+	FRotator LookRotation;
 
-	/** Last Velocity Rotation with a Non-Zero projection in the XY plane. */
+	/** The yaw delta between look rotation and character rotation. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	FRotator LastMovementVelocityRotation;
+	FRotator LookDelta;
 
 	/** Last Velocity Vector with a Non-Zero projection in the XY plane. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
 	FVector LastMovementVelocity;
 
-	/** Any difference between course (velocity direction) and heading (characcter forward) in the XY plane. */
+	/** Last Velocity Rotation with a Non-Zero projection in the XY plane. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float MovementDrift;
+	FRotator LastMovementVelocityRotation;
 
-	/** How long should it take for the character to get up. This value is obtained from the character and determines the playrate of the get up animation. */
+	/** Last Acceleration Vector with a Non-Zero projection in the XY plane. */
 	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
-	float GetUpDelay;
-
-	/** How fast Aim Offset should reach the desired look rotation. Use 0 for immediate. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Skeleton", meta = (AllowPrivateAccess = "true", ClampMin = "0", UIMin = "0"))
-	float AimOffsetInterpSpeed;
-
-	/** How fast the aim offset should reset. Use 0 for immediate. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Skeleton", meta = (AllowPrivateAccess = "true", ClampMin = "0", UIMin = "0"))
-	float AimOffsetResetInterpSpeed;
-
-	/** How fast the root bone offset should reset. Use 0 for immediate. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Skeleton", meta = (AllowPrivateAccess = "true", ClampMin = "0", UIMin = "0"))
-	float RootBoneOffsetResetInterpSpeed;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceLeftLongCurveNormal;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceRightLongCurveNormal;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceLeftShortCurveNormal;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceRightShortCurveNormal;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceLeftCurveLeftFootFwd;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceRightCurveLeftFootFwd;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceLeftCurveCrouched;
-
-	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
-	UCurveFloat* TurnInPlaceRightCurveCrouched;
-
-	/**
-	 * Walking speed used to calculate the GaitScale. Only the walking animation is played below this speed.
-	 * Above this speed, the running animation will start to blend in.
-	 * @see GaitScale
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float WalkSpeed;
-
-	/**
-	 * Running speed used to calculate the GaitScale. The sprinting animation will start to blend in above this speed.
-	 * @see GaitScale
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float RunSpeed;
-
-	/**
-	 * Sprinting speed used to calculate the GaitScale. Only the sprinting animation is played above this speed.
-	 * @see GaitScale
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float SprintSpeed;
-
-	/**
-	 * Walking speed used to calculate the GaitScaleCrouched. Only the walking animation is played below this speed.
-	 * Above this speed, the running animation will start to blend in.
-	 * @see GaitScaleCrouched
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float WalkSpeedCrouched;
-
-	/**
-	 * Running speed used to calculate the GaitScaleCrouched. Only the running animation is played above this speed.
-	 * @see GaitScaleCrouched
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float RunSpeedCrouched;
-
-	/**
-	 * Intended movement speed of the walking animation. Used to calculate WalkPlayRate and SpeedWarpScale
-	 * @see WalkPlayRate, SpeedWarpScale 
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float AnimWalkSpeed;
-
-	/**
-	 * Intended movement speed of the running animation. Used to calculate WalkPlayRate and SpeedWarpScale
-	 * @see WalkPlayRate, SpeedWarpScale
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float AnimRunSpeed;
-
-	/**
-	 * Intended movement speed of the sprinting animation. Used to calculate WalkPlayRate and SpeedWarpScale
-	 * @see WalkPlayRate, SpeedWarpScale
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float AnimSprintSpeed;
+	FVector LastMovementAcceleration;
 
-	/**
-	 * Intended movement speed of the walking crouched animation. Used to calculate WalkPlayRateCrouched. SpeedWarpScale is not affected since it's not used for crouching.
-	 * @see WalkPlayRateCrouched
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float AnimWalkSpeedCrouched;
+	/** Last Non-Zero Acceleration imposed to the character. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
+	FRotator LastMovementAccelerationRotation;
 
-	/**
-	 * Intended movement speed of the running crouched animation. Used to calculate WalkPlayRateCrouched. SpeedWarpScale is not affected since it's not used for crouching.
-	 * @see WalkPlayRateCrouched
-	 */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings|Walking", meta = (AllowPrivateAccess = "true"))
-	float AnimRunSpeedCrouched;
+	/** Impact normal of the surface at the predicted landing. Only valid if bIsLandingPredicted is true. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character|Falling", meta = (AllowPrivateAccess = "true"))
+	FVector LandingNormal;
 
 protected:
 
@@ -474,6 +393,14 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Walking|Speed Warping", meta = (AllowPrivateAccess = "true"))
 	float SpeedWarpScale;
 
+	/** Angular offset from character rotation to look rotation. X is Yaw, Y is Pitch. */
+	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Skeleton")
+	FVector2D AimOffset;
+
+	/** Angular offset of the root bone in relation to the mesh component rotation. X is Yaw, Y is Pitch. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Animation|Skeleton")
+	FVector2D RootBoneOffset;
+
 	/** Anim position for the turn in place animation calculated after the corresponding turn in place curve. */
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
 	float TurnInPlaceLeftLongAnimPositionNormal;
@@ -506,6 +433,36 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Walking|Idle|TurnInPlace", meta = (AllowPrivateAccess = "true"))
 	float TurnInPlaceRightAnimPositionCrouched;
 
+private:
+
+	// Cold state, only used on initialization, events and ragdoll.
+
+	/** */
+	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess="true"))
+	AExtCharacter* CharacterOwner;
+
+	/** */
+	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess = "true"))
+	UExtCharacterMovementComponent* CharacterOwnerMovement;
+
+	/** */
+	UPROPERTY(BlueprintReadOnly, Transient, DuplicateTransient, Category = "References", meta = (AllowPrivateAccess = "true"))
+	USkeletalMeshComponent* CharacterOwnerMesh;
+
+	/** Actor the character should be trying to look at instead of using the normal rules for aim offset. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
+	AActor* LookAtActor;
+
+	/** How long should it take for the character to get up. This value is obtained from the character and determines the playrate of the get up animation. */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Character", meta = (AllowPrivateAccess = "true"))
+	float GetUpDelay;
+
+	/** Settings in use, either Settings or the default settings. Set when the animation is initialized. */
+	UPROPERTY(Transient, DuplicateTransient)
+	UExtCharacterAnimSettings* ActiveSettings;
+
+protected:
+
 	/** Cached location of the foot bone used to adjust the corresponding IK foot bone for better blending when the character comes out of ragdoll. */
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Foot IK", meta = (AllowPrivateAccess = "true"))
 	FVector RagdollLeftFootLocation;
@@ -522,21 +479,109 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Foot IK", meta = (AllowPrivateAccess = "true"))
 	FRotator RagdollRightFootRotation;
 
-	/** Angular offset from character rotation to look rotation. X is Yaw, Y is Pitch. */
-	UPROPERTY(BlueprintReadWrite, Transient, Category = "Animation|Skeleton")
-	FVector2D AimOffset;
+private:
 
-	/** Angular offset of the root bone in relation to the mesh component rotation. X is Yaw, Y is Pitch. */
-	UPROPERTY(BlueprintReadOnly, Transient, Category = "Animation|Skeleton")
-	FVector2D RootBoneOffset;
+	/** Settings shared by every instance using them. When not set the default settings are used. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Settings", meta = (AllowPrivateAccess = "true"))
+	UExtCharacterAnimSettings* Settings;
+
+#if WITH_EDITORONLY_DATA
+
+	// Settings saved by anim blueprints before they moved to UExtCharacterAnimSettings. They are only loaded to be moved into Settings
+	// by PostLoad so cooked instances never carry them.
+
+	UPROPERTY()
+	float MaxLocomotionUpdateGap;
+
+	UPROPERTY()
+	float AimOffsetInterpSpeed;
+
+	UPROPERTY()
+	float AimOffsetResetInterpSpeed;
+
+	UPROPERTY()
+	float RootBoneOffsetResetInterpSpeed;
+
+	UPROPERTY()
+	float WalkSpeed;
+
+	UPROPERTY()
+	float RunSpeed;
+
+	UPROPERTY()
+	float SprintSpeed;
+
+	UPROPERTY()
+	float WalkSpeedCrouched;
+
+	UPROPERTY()
+	float RunSpeedCrouched;
+
+	UPROPERTY()
+	float AnimWalkSpeed;
+
+	UPROPERTY()
+	float AnimRunSpeed;
+
+	UPROPERTY()
+	float AnimSprintSpeed;
+
+	UPROPERTY()
+	float AnimWalkSpeedCrouched;
+
+	UPROPERTY()
+	float AnimRunSpeedCrouched;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftLongCurveNormal;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightLongCurveNormal;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftShortCurveNormal;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightShortCurveNormal;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftCurveLeftFootFwd;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightCurveLeftFootFwd;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftCurveCrouched;
+
+	UPROPERTY()
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightCurveCrouched;
+
+#endif // WITH_EDITORONLY_DATA
+
+protected:
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
 
 	virtual void NativeInitializeAnimation() override;
 	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
 
+	/** [game thread] Copy the state of the character, movement component and mesh needed by the locomotion update. */
+	virtual void GatherLocomotionInput(FExtCharacterAnimInstanceInput& Input) const;
+
+	/** 
+	 * Update locomotion from the game thread snapshot. Called by the proxy with the anim graph update, so in a worker thread 
+	 * when multi-threaded animation update is enabled. Must not access the character or its components.
+	 */
+	virtual void NativeThreadSafeUpdateLocomotion(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds);
+
 	virtual void NativeUpdateGaitScale(float DeltaSeconds); 
-	virtual void NativeUpdatePivotTurn(const FVector& InLastVelocity, float DeltaSeconds);
-	virtual void NativeUpdateTurnInPlace(float DeltaSeconds);
-	virtual void NativeUpdateAimOffset(float DeltaSeconds);
+	virtual void NativeUpdatePivotTurn(const FExtCharacterAnimInstanceInput& Input, const FVector& InLastVelocity, float DeltaSeconds);
+	virtual void NativeUpdateTurnInPlace(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds);
+	virtual void NativeUpdateAimOffset(const FExtCharacterAnimInstanceInput& Input, float DeltaSeconds);
+
+	/** Take the first transition of the locomotion state table that leaves the current state and whose conditions are met, if any. */
+	virtual void NativeUpdateLocomotionState(float DeltaSeconds);
 
 	virtual void RaiseEvents();
 
@@ -544,6 +589,7 @@ protected:
 	void SetCrouched(const bool Value);
 	void SetGait(const ECharacterGait Value);
 	void SetPerformingGenericAction(const bool Value);
+	void SetLocomotionState(const ELocomotionState Value);
 
 	UFUNCTION()
 	void HandleRagdollChanged(AExtCharacter* Sender);
@@ -572,6 +618,8 @@ public:
 	* The curve must comply with a few restrictions:
 	*   - Keys must have unique values, so for a given value, it maps to a unique position in the timeline of the animation.
 	*   - Key values must be sorted in increasing order.
+	* The curve is searched on every call. To match distances every frame use a Distance Matching node, which bakes the curve once.
+	* @see FAnimNode_DistanceMatching
 	*/
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = Animation)
 	float FindCurveTimeFromValue(UAnimSequence* InAnimSequence, const FName CurveName, const float Value) const;
@@ -582,6 +630,9 @@ public:
 
 	FORCEINLINE USkeletalMeshComponent* GetCharacterOwnerMesh() const { return CharacterOwnerMesh; }
 
+	/** Settings in use. Before the animation is initialized they are resolved the same way, so this never returns null. */
+	FORCEINLINE const UExtCharacterAnimSettings* GetSettings() const { return ActiveSettings ? ActiveSettings : (Settings ? Settings : GetDefault<UExtCharacterAnimSettings>()); }
+
 	FORCEINLINE TEnumAsByte<EMovementMode> GetMovementMode() const { return MovementMode; }
 
 	FORCEINLINE uint8 GetCustomMovementMode() const { return CustomMovementMode; }
@@ -606,6 +657,12 @@ public:
 
 	FORCEINLINE bool IsPerformingGenericAction() const { return bIsPerformingGenericAction; }
 
+	FORCEINLINE bool IsLandingPredicted() const { return bIsLandingPredicted; }
+
+	FORCEINLINE float GetTimeToLand() const { return TimeToLand; }
+
+	FORCEINLINE FVector GetLandingNormal() const { return LandingNormal; }
+
 	FORCEINLINE bool IsRagdoll() const { return bIsRagdoll; }
 
 	FORCEINLINE bool WasRagdoll() const { return bWasRagdoll; }
@@ -636,6 +693,14 @@ public:
 
 	FORCEINLINE ECardinalDirection GetPivotTurnDirection() const { return PivotTurnDirection; }
 
+	FORCEINLINE ELocomotionState GetLocomotionState() const { return LocomotionState; }
+
+	FORCEINLINE ELocomotionState GetLastLocomotionState() const { return LastLocomotionState; }
+
+	FORCEINLINE bool HasLocomotionStateChanged() const { return bHasLocomotionStateChanged; }
+
+	FORCEINLINE float GetLocomotionStateTime() const { return LocomotionStateTime; }
+
 	FORCEINLINE FVector GetLastCharacterLocation() const { return LastCharacterLocation; }
 
 	FORCEINLINE FRotator GetLastCharacterRotation() const { return LastCharacterRotation; }
@@ -676,45 +741,54 @@ public:
 
 	FORCEINLINE float GetGetUpDelay() const { return GetUpDelay; }
 
-	FORCEINLINE float GetAimOffsetInterpSpeed() const { return AimOffsetInterpSpeed; }
+	FORCEINLINE float GetMaxLocomotionUpdateGap() const { return GetSettings()->MaxLocomotionUpdateGap; }
+
+	FORCEINLINE int32 GetBudgetLODLevel() const { return BudgetLODLevel; }
+
+	FORCEINLINE void SetBudgetLODLevel(int32 NewBudgetLODLevel) { BudgetLODLevel = NewBudgetLODLevel; }
+
+	/** [game thread] Time spent updating and evaluating the anim graph since the last call and the number of updates it covers. */
+	void ConsumeAnimationCost(double& OutSeconds, int32& OutNumUpdates);
+
+	FORCEINLINE float GetAimOffsetInterpSpeed() const { return GetSettings()->AimOffsetInterpSpeed; }
 
-	FORCEINLINE float GetAimOffsetResetInterpSpeed() const { return AimOffsetResetInterpSpeed; }
+	FORCEINLINE float GetAimOffsetResetInterpSpeed() const { return GetSettings()->AimOffsetResetInterpSpeed; }
 
-	FORCEINLINE float GetRootBoneOffsetResetInterpSpeed() const { return RootBoneOffsetResetInterpSpeed; }
+	FORCEINLINE float GetRootBoneOffsetResetInterpSpeed() const { return GetSettings()->RootBoneOffsetResetInterpSpeed; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceLeftLongCurveNormal() const { return TurnInPlaceLeftLongCurveNormal; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceLeftLongCurveNormal() const { return GetSettings()->TurnInPlaceLeftLongCurveNormal; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceRightLongCurveNormal() const { return TurnInPlaceRightLongCurveNormal; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceRightLongCurveNormal() const { return GetSettings()->TurnInPlaceRightLongCurveNormal; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceLeftShortCurveNormal() const { return TurnInPlaceLeftShortCurveNormal; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceLeftShortCurveNormal() const { return GetSettings()->TurnInPlaceLeftShortCurveNormal; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceRightShortCurveNormal() const { return TurnInPlaceRightShortCurveNormal; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceRightShortCurveNormal() const { return GetSettings()->TurnInPlaceRightShortCurveNormal; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceLeftCurveLeftFootFwd() const { return TurnInPlaceLeftCurveLeftFootFwd; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceLeftCurveLeftFootFwd() const { return GetSettings()->TurnInPlaceLeftCurveLeftFootFwd; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceRightCurveLeftFootFwd() const { return TurnInPlaceRightCurveLeftFootFwd; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceRightCurveLeftFootFwd() const { return GetSettings()->TurnInPlaceRightCurveLeftFootFwd; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceLeftCurveCrouched() const { return TurnInPlaceLeftCurveCrouched; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceLeftCurveCrouched() const { return GetSettings()->TurnInPlaceLeftCurveCrouched; }
 
-	FORCEINLINE UCurveFloat* GetTurnInPlaceRightCurveCrouched() const { return TurnInPlaceRightCurveCrouched; }
+	FORCEINLINE const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceRightCurveCrouched() const { return GetSettings()->TurnInPlaceRightCurveCrouched; }
 
-	FORCEINLINE float GetWalkSpeed() const { return WalkSpeed; }
+	FORCEINLINE float GetWalkSpeed() const { return GetSettings()->WalkSpeed; }
 
-	FORCEINLINE float GetRunSpeed() const { return RunSpeed; }
+	FORCEINLINE float GetRunSpeed() const { return GetSettings()->RunSpeed; }
 
-	FORCEINLINE float GetSprintSpeed() const { return SprintSpeed; }
+	FORCEINLINE float GetSprintSpeed() const { return GetSettings()->SprintSpeed; }
 
-	FORCEINLINE float GetAnimWalkSpeed() const { return AnimWalkSpeed; }
+	FORCEINLINE float GetAnimWalkSpeed() const { return GetSettings()->AnimWalkSpeed; }
 
-	FORCEINLINE float GetAnimRunSpeed() const { return AnimRunSpeed; }
+	FORCEINLINE float GetAnimRunSpeed() const { return GetSettings()->AnimRunSpeed; }
 
-	FORCEINLINE float GetAnimSprintSpeed() const { return AnimSprintSpeed; }
+	FORCEINLINE float GetAnimSprintSpeed() const { return GetSettings()->AnimSprintSpeed; }
 
-	FORCEINLINE float GetWalkSpeedCrouched() const { return WalkSpeedCrouched; }
+	FORCEINLINE float GetWalkSpeedCrouched() const { return GetSettings()->WalkSpeedCrouched; }
 
-	FORCEINLINE float GetRunSpeedCrouched() const { return RunSpeedCrouched; }
+	FORCEINLINE float GetRunSpeedCrouched() const { return GetSettings()->RunSpeedCrouched; }
 
-	FORCEINLINE float GetAnimWalkSpeedCrouched() const { return AnimWalkSpeedCrouched; }
+	FORCEINLINE float GetAnimWalkSpeedCrouched() const { return GetSettings()->AnimWalkSpeedCrouched; }
 
-	FORCEINLINE float GetAnimRunSpeedCrouched() const { return AnimRunSpeedCrouched; }
+	FORCEINLINE float GetAnimRunSpeedCrouched() const { return GetSettings()->AnimRunSpeedCrouched; }
 };
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+#include "Animation/ExtCharacterAnimSettings.h"
+#include "ExtraTypes.h"
+
+#include "ExtCharacterAnimInstanceProxy.generated.h"
+
+class UExtCharacterAnimInstance;
+
+/**
+ * Game thread snapshot of the character, its movement component and mesh used to update locomotion in the parallel animation update.
+ * Only values that cannot be read safely from a worker thread are copied here. Character and movement state come from the locomotion
+ * snapshot published by the movement component, the rest is gathered from the mesh and the character.
+ */
+struct TPCE_API FExtCharacterAnimInstanceInput
+{
+	/** If false locomotion is not updated this frame. */
+	uint32 bIsValid : 1;
+
+	/** If false too much time has passed since the last locomotion update to infer motion from it. */
+	uint32 bIsContinuous : 1;
+
+	/** If true foot IK is enabled by the character, the budget and the server animation mode. */
+	uint32 bEnableFootIK : 1;
+	uint32 bHasLookAtActor : 1;
+
+	/** If true locomotion that only affects the look of the character (pivot turn, turn in place) is not updated. */
+	uint32 bSkipVisualLocomotion : 1;
+
+	/** Time dilated seconds since the last locomotion update, including frames skipped by update rate optimizations and sleep. */
+	float ElapsedTime;
+
+	/** 
+	 * Latest locomotion state published by the movement component. Locomotion speed comes from mesh displacement 
+	 * unless the update is not continuous, in which case the velocity of the movement component is used.
+	 */
+	FExtLocomotionSnapshot Locomotion;
+
+	FTransform MeshTransform;
+	FQuat BaseRotationOffset;
+
+	FVector LookAtLocation;
+
+	/** [ragdoll] Rotation of the pelvis bone. */
+	FQuat PelvisRotation;
+
+	/** [ragdoll] Foot bone transforms used to blend out of ragdoll. */
+	FVector LeftFootLocation;
+	FRotator LeftFootRotation;
+	FVector RightFootLocation;
+	FRotator RightFootRotation;
+
+	/** Turn in place curves baked by the settings, held for the update so a rebake on the game thread does not affect it. Null until baked. */
+	TSharedPtr<const FTurnInPlaceCurveTables, ESPMode::ThreadSafe> TurnInPlaceTables;
+
+	FExtCharacterAnimInstanceInput() :
+		bIsValid(false),
+		bIsContinuous(false),
+		bEnableFootIK(false),
+		bHasLookAtActor(false),
+		bSkipVisualLocomotion(false),
+		ElapsedTime(0.f),
+		MeshTransform(FTransform::Identity),
+		BaseRotationOffset(FQuat::Identity),
+		LookAtLocation(FVector::ZeroVector),
+		PelvisRotation(FQuat::Identity),
+		LeftFootLocation(FVector::ZeroVector),
+		LeftFootRotation(FRotator::ZeroRotator),
+		RightFootLocation(FVector::ZeroVector),
+		RightFootRotation(FRotator::ZeroRotator)
+	{}
+
+	/** @return value of a turn in place curve at Time, or 0 if the curves are not baked yet. */
+	FORCEINLINE float GetTurnInPlaceValue(ETurnInPlaceCurve Curve, float Time) const
+	{
+		return TurnInPlaceTables.IsValid() ? TurnInPlaceTables->GetValue(Curve, Time) : 0.f;
+	}
+};
+
+/**
+ * Anim instance proxy of UExtCharacterAnimInstance. The game thread only fills Input, locomotion (velocity, gait scale, pivot turn,
+ * turn in place and aim offset) is then updated with the anim graph, in a worker thread when multi-threaded animation update is enabled.
+ */
+USTRUCT()
+struct TPCE_API FExtCharacterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Snapshot gathered by the game thread for the next update. */
+	FExtCharacterAnimInstanceInput Input;
+
+	FExtCharacterAnimInstanceProxy() :
+		ExtAnimInstance(nullptr),
+		CostCycles(0),
+		CostNumUpdates(0)
+	{}
+
+	FExtCharacterAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+	/** [game thread] Time spent updating and evaluating the anim graph since the last call and the number of updates it covers. */
+	void ConsumeCost(double& OutSeconds, int32& OutNumUpdates);
+
+protected:
+
+	/** Anim instance owning this proxy. Only accessed by the update, never concurrently with the game thread. */
+	UExtCharacterAnimInstance* ExtAnimInstance;
+
+	/** Cycles spent updating and evaluating the anim graph since the last ConsumeCost. */
+	uint64 CostCycles;
+
+	/** Number of updates since the last ConsumeCost. */
+	int32 CostNumUpdates;
+
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+	virtual void Update(float DeltaSeconds) override;
+	virtual void UpdateAnimationNode(float DeltaSeconds) override;
+	virtual void EvaluateAnimationNode(FPoseContext& Output) override;
+};
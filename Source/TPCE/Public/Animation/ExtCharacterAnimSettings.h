@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "UObject/SoftObjectPtr.h"
+#include "Engine/DataAsset.h"
+
+#include "ExtCharacterAnimSettings.generated.h"
+
+class UCurveFloat;
+struct FRichCurve;
+struct FStreamableHandle;
+
+/** Turn in place curves of the anim settings. */
+enum class ETurnInPlaceCurve : uint8
+{
+	LeftLongNormal,
+	RightLongNormal,
+	LeftShortNormal,
+	RightShortNormal,
+	LeftLeftFootFwd,
+	RightLeftFootFwd,
+	LeftCrouched,
+	RightCrouched,
+	Count
+};
+
+/**
+ * Curve sampled at uniform time intervals so time to value queries are a single lerp instead of a key search.
+ * Times out of the curve range are clamped, as with constant extrapolation.
+ */
+struct TPCE_API FCurveSampleTable
+{
+	/** Values at uniformly spaced times from MinTime to the end of the curve. */
+	TArray<float> Values;
+
+	float MinTime;
+
+	/** Number of samples per unit of time. */
+	float SamplesPerUnit;
+
+	FCurveSampleTable() :
+		MinTime(0.f),
+		SamplesPerUnit(0.f)
+	{}
+
+	/**
+	 * Bake NumSamples samples of Curve.
+	 * @return false if the curve has no keys, in which case the table is left empty.
+	 */
+	bool Bake(const FRichCurve& Curve, int32 NumSamples);
+
+	void Reset();
+
+	FORCEINLINE bool IsValid() const { return Values.Num() > 1; }
+
+	/** @return value of the curve at Time or 0 if the table is empty. */
+	FORCEINLINE float GetValue(float Time) const
+	{
+		if (!IsValid())
+			return 0.f;
+
+		const float Position = FMath::Clamp((Time - MinTime) * SamplesPerUnit, 0.f, float(Values.Num() - 1));
+		const int32 Index = FMath::Min(FMath::FloorToInt(Position), Values.Num() - 2);
+		return FMath::Lerp(Values[Index], Values[Index + 1], Position - Index);
+	}
+};
+
+/**
+ * Baked turn in place curves of an anim settings asset. Never modified once published: baking again publishes new tables,
+ * so anim worker threads holding these can keep sampling them.
+ */
+struct TPCE_API FTurnInPlaceCurveTables
+{
+	FCurveSampleTable Tables[(int32)ETurnInPlaceCurve::Count];
+
+	/** @return value of a turn in place curve at Time, or 0 if the curve is not set. */
+	FORCEINLINE float GetValue(ETurnInPlaceCurve Curve, float Time) const { return Tables[(int32)Curve].GetValue(Time); }
+};
+
+/**
+ * Locomotion settings of an ExtCharacter anim instance. Settings never change at runtime so a single asset can be shared by every
+ * instance using it, keeping them out of the per character state.
+ *
+ * Curves are soft references so they are not loaded with every character class. They are streamed asynchronously by LoadCurves,
+ * baked into sample tables and released, so sampling them every frame costs a lerp. Anim instances that need to turn in place
+ * before the curves are baked finish loading them with LoadCurvesSynchronous.
+ * @see UExtCharacterAnimInstance::Settings
+ */
+UCLASS(BlueprintType)
+class TPCE_API UExtCharacterAnimSettings : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Longest time in seconds between two locomotion updates that is still treated as continuous motion. Updates can be skipped by update rate
+	 * optimizations, visibility based ticking or sleep. After a longer gap velocity is taken from the movement component instead of the mesh
+	 * displacement and no pivot or turn direction is inferred from the previous update. Use 0 to always treat updates as continuous.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Optimization", meta = (ClampMin = "0", UIMin = "0"))
+	float MaxLocomotionUpdateGap;
+
+	/** How fast Aim Offset should reach the desired look rotation. Use 0 for immediate. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Skeleton", meta = (ClampMin = "0", UIMin = "0"))
+	float AimOffsetInterpSpeed;
+
+	/** How fast the aim offset should reset. Use 0 for immediate. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Skeleton", meta = (ClampMin = "0", UIMin = "0"))
+	float AimOffsetResetInterpSpeed;
+
+	/** How fast the root bone offset should reset. Use 0 for immediate. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Skeleton", meta = (ClampMin = "0", UIMin = "0"))
+	float RootBoneOffsetResetInterpSpeed;
+
+	/** Walking speed used to calculate the GaitScale. Only the walking animation is played below this speed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float WalkSpeed;
+
+	/** Running speed used to calculate the GaitScale. The sprinting animation will start to blend in above this speed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float RunSpeed;
+
+	/** Sprinting speed used to calculate the GaitScale. Only the sprinting animation is played above this speed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float SprintSpeed;
+
+	/** Walking speed used to calculate the GaitScaleCrouched. Only the walking animation is played below this speed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float WalkSpeedCrouched;
+
+	/** Running speed used to calculate the GaitScaleCrouched. Only the running animation is played above this speed. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float RunSpeedCrouched;
+
+	/** Intended movement speed of the walking animation. Used to calculate WalkPlayRate and SpeedWarpScale. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float AnimWalkSpeed;
+
+	/** Intended movement speed of the running animation. Used to calculate WalkPlayRate and SpeedWarpScale. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float AnimRunSpeed;
+
+	/** Intended movement speed of the sprinting animation. Used to calculate WalkPlayRate and SpeedWarpScale. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float AnimSprintSpeed;
+
+	/** Intended movement speed of the walking crouched animation. Used to calculate WalkPlayRateCrouched. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float AnimWalkSpeedCrouched;
+
+	/** Intended movement speed of the running crouched animation. Used to calculate WalkPlayRateCrouched. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking")
+	float AnimRunSpeedCrouched;
+
+	/** Shortest time in seconds in the Start locomotion state before moving on to Cycle. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Locomotion State", meta = (ClampMin = "0", UIMin = "0"))
+	float StartStateDuration;
+
+	/** Shortest time in seconds in the Land locomotion state before moving on to a ground state. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Locomotion State", meta = (ClampMin = "0", UIMin = "0"))
+	float LandStateDuration;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftLongCurveNormal;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightLongCurveNormal;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftShortCurveNormal;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightShortCurveNormal;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftCurveLeftFootFwd;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightCurveLeftFootFwd;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceLeftCurveCrouched;
+
+	/** Curve used to determine the correct animation position for turn in place given an angular distance to the target rotation. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace")
+	TSoftObjectPtr<UCurveFloat> TurnInPlaceRightCurveCrouched;
+
+	/** Number of samples of each baked curve. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Walking|Idle|TurnInPlace", meta = (ClampMin = "2", UIMin = "2", ClampMax = "1024", UIMax = "1024"))
+	int32 CurveTableSize;
+
+	UExtCharacterAnimSettings();
+
+	virtual void BeginDestroy() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** [game thread] Start streaming the curves and bake them once loaded. Does nothing if already requested. */
+	void LoadCurves();
+
+	/** [game thread] Load and bake the curves now, cancelling a pending async request. Does nothing if already baked. */
+	void LoadCurvesSynchronous();
+
+	/** [game thread] @return true once all curves have been baked. Curves that are not set are considered baked. */
+	FORCEINLINE bool AreCurvesBaked() const { return TurnInPlaceTables.IsValid(); }
+
+	/** [game thread] @return baked turn in place curves, or null if not baked yet. Copies of the pointer can be sampled from any thread. */
+	FORCEINLINE const TSharedPtr<const FTurnInPlaceCurveTables, ESPMode::ThreadSafe>& GetTurnInPlaceTables() const { return TurnInPlaceTables; }
+
+	/** @return soft reference to a turn in place curve. */
+	const TSoftObjectPtr<UCurveFloat>& GetTurnInPlaceCurve(ETurnInPlaceCurve Curve) const;
+
+protected:
+
+	/** [game thread] Bake the loaded curves and release them. */
+	void BakeCurves();
+
+private:
+
+	/** [game thread] Latest baked turn in place curves, replaced as a whole by each bake. */
+	TSharedPtr<const FTurnInPlaceCurveTables, ESPMode::ThreadSafe> TurnInPlaceTables;
+
+	/** Handle of the curves being streamed. */
+	TSharedPtr<FStreamableHandle> CurvesHandle;
+
+	uint32 bAreCurvesRequested : 1;
+};
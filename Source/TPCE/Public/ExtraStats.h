@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformAtomics.h"
+
+struct FAnimInstanceProxy;
+
+/** Systems timed by the character benchmark. */
+enum class ECharacterBenchmarkSystem : uint8
+{
+	Movement,
+	AnimUpdate,
+	AnimNodes,
+	Replication,
+
+	Count
+};
+
+/** Cycles accumulated by the timer scopes that run for a single character, so costs can be reported per character. */
+struct TPCE_API FCharacterBenchmarkCycles
+{
+	/** Accumulated cycles for each system. */
+	volatile int64 Cycles[(int32)ECharacterBenchmarkSystem::Count];
+
+	FCharacterBenchmarkCycles() { Reset(); }
+
+	/** Clear all accumulated cycles. */
+	void Reset();
+
+	/** @return accumulated time in milliseconds for System. */
+	double GetMilliseconds(ECharacterBenchmarkSystem System) const;
+};
+
+/**
+ * Cycle accumulators for the character benchmark. Unlike stats these can be read back by game code and are available in any build
+ * configuration. Timers only accumulate while enabled so the cost otherwise is a single branch per scope. Safe to use from worker threads.
+ * @see AExtCharacterBenchmark
+ */
+struct TPCE_API FCharacterBenchmarkTimers
+{
+	/** If true timer scopes accumulate cycles. */
+	static bool bEnabled;
+
+	/** Accumulated cycles for each system. */
+	static volatile int64 Cycles[(int32)ECharacterBenchmarkSystem::Count];
+
+	/** Clear all accumulated cycles. */
+	static void Reset();
+
+	/** @return accumulated time in milliseconds for System. */
+	static double GetMilliseconds(ECharacterBenchmarkSystem System);
+
+	/** @return cycles of the ExtCharacter owning the mesh updated by AnimInstanceProxy, or null if the mesh is not owned by an ExtCharacter. */
+	static FCharacterBenchmarkCycles* FindCharacterCycles(const FAnimInstanceProxy* AnimInstanceProxy);
+};
+
+/** Accumulates the cycles spent in its scope to a system timer of the character benchmark and optionally to the cycles of the character it runs for. */
+struct FScopeCharacterBenchmarkTimer
+{
+	FORCEINLINE FScopeCharacterBenchmarkTimer(ECharacterBenchmarkSystem InSystem, FCharacterBenchmarkCycles* InCharacterCycles = nullptr) :
+		System(InSystem),
+		CharacterCycles(InCharacterCycles),
+		StartCycles(FCharacterBenchmarkTimers::bEnabled ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	FORCEINLINE ~FScopeCharacterBenchmarkTimer()
+	{
+		if (StartCycles)
+		{
+			const int64 ElapsedCycles = (int64)(FPlatformTime::Cycles64() - StartCycles);
+			FPlatformAtomics::InterlockedAdd(&FCharacterBenchmarkTimers::Cycles[(int32)System], ElapsedCycles);
+			if (CharacterCycles)
+				FPlatformAtomics::InterlockedAdd(&CharacterCycles->Cycles[(int32)System], ElapsedCycles);
+		}
+	}
+
+private:
+
+	ECharacterBenchmarkSystem System;
+	FCharacterBenchmarkCycles* CharacterCycles;
+	uint64 StartCycles;
+};
+
+#define SCOPE_CHARACTER_BENCHMARK_TIMER(System) FScopeCharacterBenchmarkTimer PREPROCESSOR_JOIN(CharacterBenchmarkTimer_, __LINE__)(ECharacterBenchmarkSystem::System)
+
+/** Same as SCOPE_CHARACTER_BENCHMARK_TIMER but also accumulates to CharacterCycles, which is only evaluated while timers are enabled. */
+#define SCOPE_CHARACTER_BENCHMARK_TIMER_FOR(System, CharacterCycles) FScopeCharacterBenchmarkTimer PREPROCESSOR_JOIN(CharacterBenchmarkTimer_, __LINE__)(ECharacterBenchmarkSystem::System, FCharacterBenchmarkTimers::bEnabled ? (CharacterCycles) : nullptr)
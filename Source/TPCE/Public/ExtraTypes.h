@@ -154,6 +154,42 @@ enum class ECharacterRotationMode: uint8
 	OrientToController			UMETA(DisplayName = "Orient to Controller"),
 };
 
+/** States of the native locomotion state machine of an ExtCharacter anim instance. */
+UENUM(BlueprintType)
+enum class ELocomotionState : uint8
+{
+	/** On ground and not accelerating. */
+	Idle						UMETA(DisplayName = "Idle"),
+	/** Started accelerating from idle, turn in place or stop. */
+	Start						UMETA(DisplayName = "Start"),
+	/** Moving in a locomotion cycle. */
+	Cycle						UMETA(DisplayName = "Cycle"),
+	/** Stopped accelerating but still moving. */
+	Stop						UMETA(DisplayName = "Stop"),
+	/** Pivot turning while moving. */
+	Pivot						UMETA(DisplayName = "Pivot"),
+	/** Turning in place while idle. */
+	TurnInPlace					UMETA(DisplayName = "Turn In Place"),
+	/** In air from a jump and still going up. */
+	Jump						UMETA(DisplayName = "Jump"),
+	/** In air going down or after walking off a ledge. */
+	Fall						UMETA(DisplayName = "Fall"),
+	/** Just landed from a jump or fall. */
+	Land						UMETA(DisplayName = "Land"),
+};
+
+/** Animation work done for a character by a dedicated server. */
+UENUM(BlueprintType)
+enum class EDedicatedServerAnimationMode : uint8
+{
+	/** Same as clients, including ragdoll simulation. */
+	Full						UMETA(DisplayName = "Full"),
+	/** Pose is updated and bones refreshed every frame for hit detection and root motion. Visual only locomotion and foot IK are skipped, ragdoll is still simulated. */
+	HitDetection				UMETA(DisplayName = "Hit Detection"),
+	/** Pose is only ticked by the movement component for root motion montages and bones are never refreshed. Ragdoll is a capsule only fallen state. */
+	RootMotionOnly				UMETA(DisplayName = "Root Motion Only"),
+};
+
 /** Helper function for net serialization of FVector */
 bool TPCE_API SerializeQuantizedVector(FArchive& Ar, FVector& Vector, EVectorQuantization QuantizationLevel);
 
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Info.h"
+
+#include "AnimationBudgetManager.generated.h"
+
+class UWorld;
+class AExtCharacter;
+class USkeletalMeshComponent;
+
+/**
+ * Budget state of a character registered with the animation budget manager.
+ */
+struct TPCE_API FAnimationBudgetEntry
+{
+	TWeakObjectPtr<AExtCharacter> Character;
+
+	/** Significance computed this frame. Higher is more important. */
+	float Significance;
+
+	/** Number of frames between anim updates, 1 being every frame. Zero if the mesh does not tick at all. */
+	int32 UpdateRate;
+
+	/** Update rate currently applied to the mesh. Negative until first applied. */
+	int32 AppliedUpdateRate;
+
+	/** Whether skipped frames are interpolated. */
+	uint32 bInterpolate : 1;
+
+	/** Whether interpolation is currently applied to the mesh. */
+	uint32 bAppliedInterpolate : 1;
+
+	/** Whether the mesh has been rendered recently. */
+	uint32 bIsVisible : 1;
+
+	/** Whether the character must be updated every frame, e.g. locally controlled or in ragdoll. */
+	uint32 bAlwaysFullRate : 1;
+
+	/** Whether the mesh can stop ticking. Only characters out of view and not playing montages can. */
+	uint32 bCanDisableTick : 1;
+
+	/** Whether the mesh follows a shared master pose, in which case it is not animated and left alone. */
+	uint32 bIsSharingPose : 1;
+
+	/** Whether the original update rate settings of the mesh have been saved. They are saved before the budget is first applied. */
+	uint32 bHasOriginalUpdateRate : 1;
+
+	/** Original bEnableUpdateRateOptimizations of the mesh, restored at full rate and when unregistered. */
+	uint32 bOriginalEnableUpdateRateOptimizations : 1;
+
+	/** Original bShouldUseLodMap of the mesh update rate parameters, restored at full rate and when unregistered. */
+	uint32 bOriginalShouldUseLodMap : 1;
+
+	/** Original MaxEvalRateForInterpolation of the mesh update rate parameters, restored at full rate and when unregistered. */
+	int32 OriginalMaxEvalRateForInterpolation;
+
+	/** Original LODToFrameSkipMap of the mesh update rate parameters, restored at full rate and when unregistered. */
+	TMap<int32, int32> OriginalLODToFrameSkipMap;
+
+	FAnimationBudgetEntry() :
+		Significance(0.f),
+		UpdateRate(1),
+		AppliedUpdateRate(-1),
+		bInterpolate(false),
+		bAppliedInterpolate(false),
+		bIsVisible(false),
+		bAlwaysFullRate(false),
+		bCanDisableTick(false),
+		bIsSharingPose(false),
+		bHasOriginalUpdateRate(false),
+		bOriginalEnableUpdateRateOptimizations(false),
+		bOriginalShouldUseLodMap(false),
+		OriginalMaxEvalRateForInterpolation(0)
+	{}
+};
+
+/**
+ * Per world manager that keeps the cost of animating registered characters within a fixed per frame budget.
+ * Each frame characters are scored by distance to the local views, visibility and their own animation significance. The measured cost
+ * of an anim update is then used to lower the update rate of the least significant characters, interpolating skipped frames of visible ones
+ * and stopping the mesh tick of those out of view, until the estimated cost fits the budget. Reduced characters are also given an
+ * animation LOD that anim graphs can use to skip expensive nodes.
+ * @see AExtCharacter::bUseAnimationBudget
+ * @see UExtCharacterAnimInstance::GetBudgetLODLevel()
+ */
+UCLASS(NotBlueprintable, Transient)
+class TPCE_API AAnimationBudgetManager : public AInfo
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Characters registered for budgeting. */
+	TArray<FAnimationBudgetEntry> Entries;
+
+	/** Entry indices sorted by decreasing significance. */
+	TArray<int32> SortedIndices;
+
+	/** Smoothed cost in milliseconds of a single anim update and evaluation. Zero until measured. */
+	float AverageUpdateCostMs;
+
+	/** Milliseconds spent animating registered characters in the last frame. */
+	float UsedMs;
+
+	/** Milliseconds estimated for the current frame with the chosen update rates. */
+	float EstimatedMs;
+
+public:
+
+	AAnimationBudgetManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find the animation budget manager of World, spawning one if needed. */
+	static AAnimationBudgetManager* Get(UWorld* World);
+
+	/** Register a character to be budgeted. Its mesh tick is made dependent on the manager's. */
+	void Register(AExtCharacter* Character);
+
+	/** Unregister a previously registered character restoring the update settings of its mesh. */
+	void Unregister(AExtCharacter* Character);
+
+	/** Number of registered characters. */
+	FORCEINLINE int32 GetNumRegistered() const { return Entries.Num(); }
+
+	FORCEINLINE float GetAverageUpdateCostMs() const { return AverageUpdateCostMs; }
+
+	FORCEINLINE float GetUsedMs() const { return UsedMs; }
+
+	FORCEINLINE float GetEstimatedMs() const { return EstimatedMs; }
+
+protected:
+
+	/** Significance of Character given its visibility and the locations of the local views. */
+	float CalculateSignificance(const AExtCharacter* Character, bool bIsVisible, const TArray<FVector, TInlineAllocator<4>>& ViewLocations) const;
+
+	/** Choose the update rate of every entry so that the estimated cost fits BudgetMs. */
+	void AllocateBudget(float BudgetMs, int32 MaxUpdateRate, bool bAllowInterpolation, bool bAllowTickDisable);
+
+	/** Apply the update rate and interpolation of Entry to the mesh and anim instance of its character. */
+	void ApplyBudget(FAnimationBudgetEntry& Entry, int32 MaxUpdateRate) const;
+
+	/** Restore the mesh and anim instance of Entry as they were before it was registered. */
+	void ResetBudget(FAnimationBudgetEntry& Entry) const;
+
+	/** Restore the update rate optimization settings the mesh of Entry had before the budget was first applied. */
+	void RestoreUpdateRate(const FAnimationBudgetEntry& Entry, USkeletalMeshComponent* Mesh) const;
+
+	/** Estimated cost in milliseconds per frame of a character updated at UpdateRate. */
+	FORCEINLINE float GetEstimatedCost(int32 UpdateRate) const { return UpdateRate > 0 ? AverageUpdateCostMs / UpdateRate : 0.f; }
+};
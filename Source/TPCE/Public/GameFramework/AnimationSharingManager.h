@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Info.h"
+#include "Animation/AnimationSharingSetup.h"
+
+#include "AnimationSharingManager.generated.h"
+
+class UWorld;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+class AExtCharacter;
+
+/**
+ * Master poses of a locomotion state for characters with the same skeletal mesh and animation sharing setup.
+ */
+struct TPCE_API FAnimationSharingBucket
+{
+	USkeletalMesh* SkeletalMesh;
+	const UAnimationSharingSetup* Setup;
+	EAnimationSharingState State;
+
+	/** Master pose of each variant. */
+	TArray<USkeletalMeshComponent*> Masters;
+
+	/** Number of characters following each master pose. */
+	TArray<int32> NumFollowers;
+
+	FAnimationSharingBucket() :
+		SkeletalMesh(nullptr),
+		Setup(nullptr),
+		State(EAnimationSharingState::Idle)
+	{}
+};
+
+/**
+ * Sharing state of a character registered with the animation sharing manager.
+ */
+struct TPCE_API FAnimationSharingEntry
+{
+	TWeakObjectPtr<AExtCharacter> Character;
+
+	/** Bucket the character follows a master pose of, or INDEX_NONE if it uses its own anim instance. */
+	int32 BucketIndex;
+
+	/** Variant of the master pose followed. */
+	int32 Variant;
+
+	FAnimationSharingEntry() :
+		BucketIndex(INDEX_NONE),
+		Variant(0)
+	{}
+};
+
+/**
+ * Per world manager that lets ambient characters share a few poses instead of updating their own anim instance.
+ * Registered characters in a locomotion state listed by their animation sharing setup follow one of the master poses of that state
+ * and stop ticking their mesh. A character is promoted back to its own anim instance when it gets close to a local view,
+ * becomes significant, leaves the shared states or starts a ragdoll.
+ * @see AExtCharacter::AnimationSharingSetup
+ */
+UCLASS(NotBlueprintable, Transient)
+class TPCE_API AAnimationSharingManager : public AInfo
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** All master pose components, referenced here so they are not garbage collected. */
+	UPROPERTY(Transient)
+	TArray<USkeletalMeshComponent*> MasterComponents;
+
+	/** Buckets created so far. Never removed, masters without followers just stop ticking. */
+	TArray<FAnimationSharingBucket> Buckets;
+
+	/** Characters registered for sharing. */
+	TArray<FAnimationSharingEntry> Entries;
+
+public:
+
+	AAnimationSharingManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find the animation sharing manager of World, spawning one if needed. */
+	static AAnimationSharingManager* Get(UWorld* World);
+
+	/** Register a character whose pose can be shared. Character must have an animation sharing setup. */
+	void Register(AExtCharacter* Character);
+
+	/** Unregister a previously registered character giving it back its own anim instance. */
+	void Unregister(AExtCharacter* Character);
+
+	/** Give Character back its own anim instance immediately, e.g. before simulating physics. Sharing is reconsidered on the next tick. */
+	void Promote(AExtCharacter* Character);
+
+	/** Number of registered characters. */
+	FORCEINLINE int32 GetNumRegistered() const { return Entries.Num(); }
+
+protected:
+
+	/** @return false if Character cannot share its pose, otherwise the state it would share in OutState. */
+	bool GetSharingState(const AExtCharacter* Character, EAnimationSharingState& OutState) const;
+
+	/** @return index of the bucket for the given mesh, setup and state, creating its master poses if needed. */
+	int32 FindOrAddBucket(USkeletalMesh* SkeletalMesh, const UAnimationSharingSetup* Setup, EAnimationSharingState State);
+
+	/** Make the character of Entry follow the least followed master pose of the bucket at BucketIndex. */
+	void Follow(FAnimationSharingEntry& Entry, int32 BucketIndex);
+
+	/** Give the character of Entry back its own anim instance. */
+	void StopFollowing(FAnimationSharingEntry& Entry);
+};
@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/ExtCharacterMovementComponent.h"
+
+#include "CrowdMovementManager.generated.h"
+
+class UWorld;
+
+/**
+ * Uniform grid over the XY plane indexing points by cell. Built once per frame, entries of each cell are stored contiguously.
+ */
+struct TPCE_API FCrowdSpatialHash
+{
+	/** Range of entries in a cell. */
+	struct FCell
+	{
+		int32 Start;
+		int32 Num;
+
+		FCell() : Start(0), Num(0) {}
+	};
+
+	/** Size of each cell. Queries visit fewer cells when close to the typical query radius. */
+	float CellSize;
+
+	/** Cells containing at least one point. */
+	TMap<FIntPoint, FCell> Cells;
+
+	/** Point indices sorted by cell. */
+	TArray<int32> Entries;
+
+	FCrowdSpatialHash() : CellSize(1.f) {}
+
+	FORCEINLINE FIntPoint GetCell(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	}
+
+	/** Empty the hash keeping allocations. */
+	void Reset();
+
+	/** Index all Locations with the given cell size. */
+	void Build(const TArray<FVector>& Locations, float InCellSize);
+
+	/** Call Func with the index of every point in the cells overlapping the square of half size Radius around Location. */
+	template<typename FuncType>
+	void Query(const FVector& Location, float Radius, FuncType&& Func) const
+	{
+		const FIntPoint Min = GetCell(Location - FVector(Radius, Radius, 0.f));
+		const FIntPoint Max = GetCell(Location + FVector(Radius, Radius, 0.f));
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				if (const FCell* Cell = Cells.Find(FIntPoint(X, Y)))
+				{
+					for (int32 Entry = Cell->Start; Entry < Cell->Start + Cell->Num; ++Entry)
+					{
+						Func(Entries[Entry]);
+					}
+				}
+			}
+		}
+	}
+};
+
+/**
+ * Structure of arrays with the movement state of every character processed by the crowd movement manager in a frame.
+ * Inputs are gathered on the game thread, results are computed in parallel and then consumed by each movement component
+ * during its own tick, so only the collision resolving move remains serialized.
+ */
+struct TPCE_API FCrowdMovementBatch
+{
+	enum EFlags : uint8
+	{
+		FLAG_OrientToMovement = 0x01,
+		FLAG_InterpolateRotation = 0x02,
+		FLAG_AdaptiveRotationRate = 0x04,
+		FLAG_Avoidance = 0x08,
+		FLAG_RequestedVelocity = 0x10,
+		FLAG_RequestedMoveWithMaxSpeed = 0x20,
+		FLAG_RequestedMoveUseAcceleration = 0x40,
+	};
+
+	/** Movement components in the batch. Only to be dereferenced from the game thread or the floor prefetch. */
+	TArray<UExtCharacterMovementComponent*> Components;
+
+	/// Velocity Inputs
+
+	TArray<FVector> Velocities;
+	TArray<FVector> Accelerations;
+	TArray<float> AnalogInputModifiers;
+	TArray<float> DeltaTimes;
+	TArray<float> MaxInputSpeeds;
+	TArray<float> MaxAccelerations;
+	TArray<float> Frictions;
+	TArray<float> BrakingFrictions;
+	TArray<float> BrakingFrictionFactors;
+	TArray<float> BrakingDecelerations;
+	TArray<float> BrakingSpeedTolerances;
+
+	/** Path following requested velocity, only valid with FLAG_RequestedVelocity. */
+	TArray<FVector> RequestedVelocities;
+
+	/** Max speed a requested velocity is clamped to. */
+	TArray<float> MaxSpeeds;
+
+	/// Rotation Inputs
+
+	TArray<float> Yaws;
+	TArray<float> YawRates;
+	TArray<float> RotationDeltaTimes;
+	TArray<FAdaptiveRotationSettings> AdaptiveRotationSettings;
+	TArray<uint8> Flags;
+
+	/// Avoidance Inputs
+
+	TArray<FVector> Locations;
+	TArray<float> AvoidanceRadii;
+	TArray<float> AvoidancePriorities;
+	TArray<float> AvoidanceTimeHorizons;
+
+	/** Largest avoidance radius in the batch. */
+	float MaxAvoidanceRadius;
+
+	/** Largest speed in the batch. */
+	float MaxSpeed;
+
+	/** Whether any entry has FLAG_Avoidance. */
+	bool bHasAvoidance;
+
+	/** Locations of all entries, only built if bHasAvoidance. */
+	FCrowdSpatialHash SpatialHash;
+
+	/// Outputs
+
+	TArray<FVector> OutAccelerations;
+	TArray<FVector> OutRequestedVelocities;
+	TArray<FVector> OutVelocities;
+	TArray<float> OutDeltaYaws;
+
+	FCrowdMovementBatch() : MaxAvoidanceRadius(0.f), MaxSpeed(0.f), bHasAvoidance(false) {}
+
+	FORCEINLINE int32 Num() const { return Components.Num(); }
+
+	/** Empty all arrays keeping their allocations. */
+	void Reset();
+
+	/** Add an uninitialized entry for Component. @return index of the new entry. */
+	int32 Add(UExtCharacterMovementComponent* Component);
+};
+
+/**
+ * Per world manager that computes the velocity and rotation of registered AI characters in a single parallel batch before
+ * their movement components tick, then sweeps in parallel the floor each character will reach after its first step so the floor check
+ * after the serialized move is served from the floor cache. Path following requested velocities are batched the same as input acceleration.
+ * Characters with crowd avoidance enabled have their input acceleration or requested velocity steered away from each other in the same pass. Results are only used by a movement component if the inputs it ends up using match the
+ * inputs that were gathered, otherwise it falls back to its own computation so behaviour is never affected.
+ * @see UExtCharacterMovementComponent::bUseCrowdMovementManager
+ */
+UCLASS(NotBlueprintable, Transient)
+class TPCE_API ACrowdMovementManager : public AInfo
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Movement components registered for batching. */
+	TArray<TWeakObjectPtr<UExtCharacterMovementComponent>> MovementComponents;
+
+	/** Batch for the current frame. */
+	FCrowdMovementBatch Batch;
+
+public:
+
+	ACrowdMovementManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find the crowd movement manager of World, spawning one if needed. */
+	static ACrowdMovementManager* Get(UWorld* World);
+
+	/** Register a movement component to be batched. Its tick is made dependent on the manager's. */
+	void Register(UExtCharacterMovementComponent* MovementComponent);
+
+	/** Unregister a previously registered movement component. */
+	void Unregister(UExtCharacterMovementComponent* MovementComponent);
+
+	/** Batch computed for the current frame. */
+	FORCEINLINE const FCrowdMovementBatch& GetBatch() const { return Batch; }
+
+	/** Number of registered movement components. */
+	FORCEINLINE int32 GetNumRegistered() const { return MovementComponents.Num(); }
+};
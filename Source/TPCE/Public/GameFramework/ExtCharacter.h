@@ -10,6 +10,7 @@
 #include "Math/Bounds.h"
 #include "TimerManager.h"
 #include "ExtraTypes.h"
+#include "ExtraStats.h"
 
 #include "ExtCharacter.generated.h"
 
@@ -20,6 +21,9 @@ class UReboundSpringArmComponent;
 class UCameraComponent;
 class UInputComponent;
 class UExtCharacterMovementComponent;
+class AAnimationBudgetManager;
+class AAnimationSharingManager;
+class UAnimationSharingSetup;
 class FLifetimeProperty;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGenericActionChangedSignature, AExtCharacter*, Sender);
@@ -202,6 +206,14 @@ public:		// Bitfields
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animation)
 	uint32 bEnableFootIK : 1;
 
+	/**
+	 * If true the update rate of the mesh is chosen by the animation budget manager according to AnimationSignificance, distance to the
+	 * local views and visibility. Has no effect on dedicated servers. Only effective if set before BeginPlay.
+	 * @see AAnimationBudgetManager
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, AdvancedDisplay)
+	uint32 bUseAnimationBudget : 1;
+
 	/** If true character is female. Can be used to play animations based on gender. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
 	uint32 bIsFemale : 1;
@@ -269,6 +281,17 @@ private:	// Variables
 	/* Handle for the timer triggered when getting up from ragdoll. */
 	FTimerHandle GettingUpTimerHandle;
 
+	/** Animation budget manager this character is registered with. */
+	UPROPERTY(Transient, DuplicateTransient)
+	AAnimationBudgetManager* AnimationBudgetManager;
+
+	/** Animation sharing manager this character is registered with. */
+	UPROPERTY(Transient, DuplicateTransient)
+	AAnimationSharingManager* AnimationSharingManager;
+
+	/** Cycles spent on this character while the character benchmark is running. Updated from worker threads by the anim graph. */
+	mutable FCharacterBenchmarkCycles BenchmarkCycles;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"), AdvancedDisplay)
 	FName MoveForwardInputName;
 
@@ -404,6 +427,31 @@ public:		// Variables
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character, meta = (ClampMin = "0", UIMin = "0"))
 	float LandingDelay;
 
+	/**
+	 * Gameplay importance of animating this character, scaling the significance given by the animation budget manager.
+	 * Characters the player interacts with should use higher values. Use 0 to animate only when the budget allows it.
+	 * @see bUseAnimationBudget
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animation, meta = (ClampMin = "0", UIMin = "0"), AdvancedDisplay)
+	float AnimationSignificance;
+
+	/**
+	 * If set, while far from the local views and in one of the locomotion states of the setup, the mesh copies a pose shared with other
+	 * characters instead of updating its own anim instance. Meant for ambient characters. Has no effect on dedicated servers or locally
+	 * controlled characters. Only effective if set before BeginPlay.
+	 * @see AAnimationSharingManager
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animation, AdvancedDisplay)
+	UAnimationSharingSetup* AnimationSharingSetup;
+
+	/**
+	 * Animation work done by a dedicated server. Full by default, reduced modes are opt-in. Ragdoll is never replicated so RootMotionOnly replaces it
+	 * with a capsule only fallen state where the capsule keeps its ragdoll collision and braking but the mesh is not simulated.
+	 * @see GetActiveServerAnimationMode()
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, AdvancedDisplay)
+	EDedicatedServerAnimationMode DedicatedServerAnimationMode;
+
 	/** */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
 	FCharacterMovementSettings MovementSettings;
@@ -857,6 +905,12 @@ public:		// Methods
 	/** */
 	FORCEINLINE bool IsRagdoll() const { return bIsRagdoll; }
 
+	/** @return DedicatedServerAnimationMode on a dedicated server, Full otherwise. */
+	EDedicatedServerAnimationMode GetActiveServerAnimationMode() const;
+
+	/** @return true if ragdoll bodies are simulated, false if ragdoll is a capsule only fallen state. */
+	bool ShouldSimulateRagdoll() const;
+
 	/** */
 	UFUNCTION(BlueprintCallable, Category = "Pawn|Character")
 	void SetRagdoll(bool Value);
@@ -886,6 +940,9 @@ public:		// Methods
 	/** */
 	FORCEINLINE FName GetRightFootBoneName() const { return RightFootBoneName; }
 
+	/** @return cycles spent on this character while the character benchmark is running. */
+	FORCEINLINE FCharacterBenchmarkCycles& GetBenchmarkCycles() const { return BenchmarkCycles; }
+
 #if WITH_EDITOR
 
 	UArrowComponent* GetLookRotationArrow() const { return LookRotationArrow; }
@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Controller.h"
+
+#include "ExtCharacterBenchmark.generated.h"
+
+class AExtCharacter;
+
+UENUM()
+enum class EExtCharacterBenchmarkPhase : uint8
+{
+	Idle,
+	Warmup,
+	Sampling,
+	Finished,
+	Failed
+};
+
+/** Scripted input segments performed by benchmark characters. */
+enum class EExtCharacterBenchmarkSegment : uint8
+{
+	Walk,
+	Sprint,
+	Crouch,
+	Jump,
+	Pivot,
+	TurnInPlace,
+
+	Count
+};
+
+/** Approximate memory in bytes owned by a character. */
+struct FExtCharacterMemorySize
+{
+	/** Actor object and what it allocates. */
+	SIZE_T Actor;
+
+	/** Component objects and what they allocate, including resources exclusive to them. */
+	SIZE_T Components;
+
+	/** Anim instance objects of all meshes and what they allocate. */
+	SIZE_T AnimInstances;
+
+	/** Size of the anim instance object of the character mesh, without anything it allocates. */
+	SIZE_T AnimInstanceObject;
+
+	FExtCharacterMemorySize() :
+		Actor(0),
+		Components(0),
+		AnimInstances(0),
+		AnimInstanceObject(0)
+	{}
+
+	FORCEINLINE SIZE_T GetTotal() const { return Actor + Components + AnimInstances; }
+};
+
+/** Character present when a sample started. */
+struct FExtCharacterBenchmarkSample
+{
+	TWeakObjectPtr<AExtCharacter> Character;
+
+	/** Name kept to report characters destroyed before the sample ended. */
+	FString Name;
+
+	FExtCharacterMemorySize Memory;
+};
+
+/** Minimal controller possessing benchmark characters. Unlike AI controllers it never overrides the scripted control rotation. */
+UCLASS(NotBlueprintable, NotPlaceable, Transient)
+class TPCE_API AExtCharacterBenchmarkController : public AController
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Spawns an increasing number of ExtCharacters driven by scripted inputs (walk, sprint, crouch, jump, pivot and turn in place) and
+ * records the average cost per frame of movement, animation update, animation nodes and replication for each character count,
+ * together with the approximate memory per character. Run on a dedicated server to measure the server animation mode of the character.
+ *
+ * Stages are controlled by the server and replicated, so connected clients sample the same windows using the simulated proxies
+ * and write their own results. Results are saved as CSV to the profiling directory: one row per stage plus a second file with
+ * one row per character and stage, breaking down the cost of each system and the memory of the actor, components and anim instances.
+ *
+ * Can be run headless with: -nullrhi -ExecCmds="TPCE.Benchmark 1 10 100 500"
+ * or through the TPCE.Benchmark automation test, which runs it in every map whose name contains "Benchmark" or else in the game default map.
+ * The character class is read from the game config, falling back to the default pawn of the game mode when it is an ExtCharacter:
+ *
+ *     [/Script/TPCE.ExtCharacterBenchmark]
+ *     CharacterClass=/Game/Characters/BP_MyCharacter.BP_MyCharacter_C
+ *
+ * The benchmark fails if neither is a concrete ExtCharacter or if no character could be spawned.
+ * @see FCharacterBenchmarkTimers
+ */
+UCLASS(Blueprintable, NotPlaceable, Config = Game)
+class TPCE_API AExtCharacterBenchmark : public AInfo
+{
+	GENERATED_BODY()
+
+public: // Bitfields
+
+	/** If true the application exits after results are written. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	uint32 bQuitWhenFinished : 1;
+
+public: // Variables
+
+	/** Character to spawn. Must be a concrete class, if not set the default pawn of the game mode is used when it is an ExtCharacter. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	TSubclassOf<AExtCharacter> CharacterClass;
+
+	/** Number of characters spawned in each stage. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	TArray<int32> CharacterCounts;
+
+	/** Time in seconds to let characters settle before sampling a stage. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0", UIMin = "0"))
+	float WarmupTime;
+
+	/** Time in seconds each stage is sampled. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0.1", UIMin = "0.1"))
+	float SampleTime;
+
+	/** Duration in seconds of each scripted input segment. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0.1", UIMin = "0.1"))
+	float SegmentDuration;
+
+	/** Distance between spawned characters. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark", meta = (ClampMin = "0", UIMin = "0"))
+	float Spacing;
+
+	/** Name of the results file, written to the profiling directory. Net mode is appended to the name. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	FString OutputFileName;
+
+protected: // Variables
+
+	/** Index of the current stage in CharacterCounts. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_Stage)
+	int32 StageIndex;
+
+	/** Phase of the current stage. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_Stage)
+	EExtCharacterBenchmarkPhase Phase;
+
+	/** [server] Characters spawned for the current stage. */
+	UPROPERTY(Transient)
+	TArray<AExtCharacter*> Characters;
+
+	/** [server] Input segment currently performed by each character. */
+	TArray<EExtCharacterBenchmarkSegment> Segments;
+
+	/** [server] Time since the current phase started. */
+	float PhaseTime;
+
+	/** Whether this instance is currently sampling. Tracked apart from Phase because clients may miss intermediate phases. */
+	bool bIsSampling;
+
+	/** Stage being sampled. */
+	int32 SampledStageIndex;
+
+	/** Characters present when the current sample started. */
+	int32 SampledCharacters;
+
+	/** Characters present when the current sample started and their memory at that time. */
+	TArray<FExtCharacterBenchmarkSample> CharacterSamples;
+
+	/** Frames counted in the current sample. */
+	int32 SampledFrames;
+
+	/** Platform time the current sample started. */
+	double SampleStartTime;
+
+	/** CSV rows recorded so far, one per stage. */
+	TArray<FString> Results;
+
+	/** CSV rows recorded so far, one per character and stage. */
+	TArray<FString> CharacterResults;
+
+public: // Methods
+
+	AExtCharacterBenchmark();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** [server] Start the benchmark from the first stage. */
+	UFUNCTION(BlueprintCallable, Category = "Benchmark")
+	void StartBenchmark();
+
+	/** Phase of the current stage. */
+	FORCEINLINE EExtCharacterBenchmarkPhase GetPhase() const { return Phase; }
+
+	/** Whether the benchmark is warming up or sampling a stage. */
+	FORCEINLINE bool IsRunning() const { return Phase == EExtCharacterBenchmarkPhase::Warmup || Phase == EExtCharacterBenchmarkPhase::Sampling; }
+
+protected: // Methods
+
+	UFUNCTION()
+	virtual void OnRep_Stage();
+
+	/** [server] Set the current stage and phase. */
+	void SetStage(int32 NewStageIndex, EExtCharacterBenchmarkPhase NewPhase);
+
+	/** [all] Start or stop sampling according to the current phase. */
+	void UpdateSampling();
+
+	void BeginSample();
+	void EndSample();
+
+	/** [all] Save recorded results and quit if requested. */
+	void Finish();
+
+	/** [server] Stop the benchmark and destroy its characters because it cannot produce meaningful results. */
+	void Fail(const TCHAR* Reason);
+
+	/** Save Rows as CSV to the profiling directory. Suffix is appended to OutputFileName. */
+	void SaveResults(const TArray<FString>& Rows, const TCHAR* Suffix) const;
+
+	/** [server] Spawn Count characters in a grid around the benchmark location. */
+	virtual void SpawnCharacters(int32 Count);
+
+	/** [server] Destroy all characters spawned for the current stage. */
+	virtual void DestroyCharacters();
+
+	/** [server] Feed scripted inputs to all characters. */
+	virtual void UpdateCharacterInputs();
+
+	/** [server] Apply the inputs for Segment to Character. bSegmentChanged is true the first frame of the segment. */
+	virtual void ApplySegmentInputs(AExtCharacter* Character, EExtCharacterBenchmarkSegment Segment, bool bSegmentChanged, float SegmentTime, int32 Cycle);
+};
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Components/ActorComponent.h"
+#include "ExtraTypes.h"
+
+#include "ExtCharacterInputRecorderComponent.generated.h"
+
+class AExtCharacter;
+class UExtCharacterInputRecorderComponent;
+
+/** Input and resulting movement of a recorded frame. */
+struct TPCE_API FExtCharacterInputFrame
+{
+	/** Time since the recording started. */
+	float Time;
+
+	/** Control rotation at the time inputs were processed. */
+	FRotator ControlRotation;
+
+	/** Values of the bound axes, in the same order as FExtCharacterInputRecording::AxisNames. */
+	TArray<float> AxisValues;
+
+	/** Bitmask of held actions, bit indices follow FExtCharacterInputRecording::ActionNames. */
+	uint32 HeldActions;
+
+	/** Movement state at the time inputs were processed, i.e. the result of all previous frames. */
+	FRepExtMovement Movement;
+
+	FExtCharacterInputFrame() :
+		Time(0.f),
+		ControlRotation(ForceInitToZero),
+		HeldActions(0)
+	{}
+
+	friend FArchive& operator<<(FArchive& Ar, FExtCharacterInputFrame& Frame);
+};
+
+/** Input stream of a character and the state it started from. */
+struct TPCE_API FExtCharacterInputRecording
+{
+	/** Names of the axes bound by the character, recorded in bind order. */
+	TArray<FName> AxisNames;
+
+	/** Names of the actions bound by the character, recorded in bind order. At most 32 actions are recorded. */
+	TArray<FName> ActionNames;
+
+	/** Initial movement mode. */
+	uint8 MovementMode;
+
+	/** Initial rotation mode. */
+	ECharacterRotationMode RotationMode;
+
+	/** Initial crouched, walking and sprinting flags. */
+	uint8 bIsCrouched : 1;
+	uint8 bIsWalkingInsteadOfRunning : 1;
+	uint8 bIsSprinting : 1;
+
+	TArray<FExtCharacterInputFrame> Frames;
+
+	FExtCharacterInputRecording() :
+		MovementMode(0),
+		RotationMode(ECharacterRotationMode::None),
+		bIsCrouched(false),
+		bIsWalkingInsteadOfRunning(false),
+		bIsSprinting(false)
+	{}
+
+	/** @return duration of the recording in seconds. */
+	FORCEINLINE float GetDuration() const { return Frames.Num() > 0 ? Frames.Last().Time : 0.f; }
+
+	/** Find the recorded movement at Time interpolating between frames. */
+	FRepExtMovement SampleMovement(float Time) const;
+
+	bool SaveToFile(const FString& FilePath) const;
+	bool LoadFromFile(const FString& FilePath);
+
+	/** @return full path of a recording named Name. */
+	static FString GetFilePath(const FString& Name);
+
+	friend FArchive& operator<<(FArchive& Ar, FExtCharacterInputRecording& Recording);
+};
+
+/** Difference between a replayed trajectory and the recorded one. */
+USTRUCT(BlueprintType)
+struct TPCE_API FExtCharacterReplayResult
+{
+	GENERATED_BODY()
+
+	/** Number of frames replayed. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	int32 Frames;
+
+	/** Largest distance to the recorded location. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	float MaxLocationError;
+
+	/** Average distance to the recorded location. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	float AverageLocationError;
+
+	/** Largest angular distance in degrees to the recorded rotation. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	float MaxRotationError;
+
+	/** Largest difference to the recorded velocity. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	float MaxVelocityError;
+
+	/** Time at which the location error first went beyond the tolerance or a negative value if it never did. */
+	UPROPERTY(BlueprintReadOnly, Category = "Replay")
+	float DivergenceTime;
+
+	FExtCharacterReplayResult() :
+		Frames(0),
+		MaxLocationError(0.f),
+		AverageLocationError(0.f),
+		MaxRotationError(0.f),
+		MaxVelocityError(0.f),
+		DivergenceTime(-1.f)
+	{}
+
+	/** @return true if the replayed trajectory never diverged from the recording. */
+	FORCEINLINE bool IsMatch() const { return DivergenceTime < 0.f; }
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FExtCharacterReplayFinishedSignature, UExtCharacterInputRecorderComponent*, Sender, const FExtCharacterReplayResult&, Result);
+
+UENUM(BlueprintType)
+enum class EExtCharacterInputRecorderState : uint8
+{
+	Idle,
+	Recording,
+	Replaying
+};
+
+/**
+ * Records the input stream of a locally controlled ExtCharacter, i.e. the values of the axes and actions bound to its input component,
+ * along with its initial state and resulting trajectory. A recording can be replayed at any frame rate by feeding the same inputs back
+ * to the bound handlers. The replayed trajectory is compared against the recorded one so movement changes and corrections can be reproduced
+ * and measured without hand-playing the game.
+ *
+ * Replaying requires the character to be controlled by a local player controller as input handlers ignore other controllers. A standalone
+ * game running headless (-nullrhi) still creates one so recordings can be replayed with:
+ * -nullrhi -ExecCmds="TPCE.ReplayInput Name" [-BENCHMARK -FPS=30]
+ */
+UCLASS(ClassGroup=Movement, meta=(BlueprintSpawnableComponent))
+class TPCE_API UExtCharacterInputRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public: // Bitfields
+
+	/** If true the application exits after a replay finishes. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Recorder")
+	uint32 bQuitWhenReplayFinished : 1;
+
+public: // Variables
+
+	/** Replayed locations farther than this from the recorded ones are considered a divergence. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Recorder", meta = (ClampMin = "0", UIMin = "0"))
+	float LocationTolerance;
+
+	/** Called when a replay finishes. */
+	UPROPERTY(BlueprintAssignable, Category = "Input Recorder")
+	FExtCharacterReplayFinishedSignature ReplayFinishedDelegate;
+
+protected: // Variables
+
+	/** Character owning this component. */
+	UPROPERTY(Transient, DuplicateTransient)
+	AExtCharacter* ExtCharacterOwner;
+
+	EExtCharacterInputRecorderState State;
+
+	/** Recording being written or replayed. */
+	FExtCharacterInputRecording Recording;
+
+	/** Name of the recording being written or replayed. */
+	FString RecordingName;
+
+	/** Time since recording or replay started. */
+	float Time;
+
+	/** Index of the last recorded frame applied while replaying. */
+	int32 ReplayFrameIndex;
+
+	/** Actions held by the replay. */
+	uint32 ReplayHeldActions;
+
+	/** Sum of the location errors of all replayed frames. */
+	float ReplayLocationErrorSum;
+
+	FExtCharacterReplayResult ReplayResult;
+
+public: // Methods
+
+	UExtCharacterInputRecorderComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	/** Start recording the owner's input. Any recording in progress is discarded. */
+	UFUNCTION(BlueprintCallable, Category = "Input Recorder")
+	bool StartRecording(const FString& Name);
+
+	/** Stop recording and save the recording to the saved directory. */
+	UFUNCTION(BlueprintCallable, Category = "Input Recorder")
+	bool StopRecording();
+
+	/** Load a recording, restore the owner to its initial state and start feeding its inputs. */
+	UFUNCTION(BlueprintCallable, Category = "Input Recorder")
+	bool StartReplay(const FString& Name);
+
+	/** Stop replaying and report the result. */
+	UFUNCTION(BlueprintCallable, Category = "Input Recorder")
+	void StopReplay();
+
+	FORCEINLINE EExtCharacterInputRecorderState GetState() const { return State; }
+
+	/** Result of the last replay. */
+	UFUNCTION(BlueprintCallable, Category = "Input Recorder")
+	FExtCharacterReplayResult GetReplayResult() const { return ReplayResult; }
+
+	/** Find or add a recorder component to Character. */
+	static UExtCharacterInputRecorderComponent* FindOrAdd(AExtCharacter* Character);
+
+protected: // Methods
+
+	/** Update tick prerequisites so inputs are processed after the controller and before the movement component. */
+	void UpdateTickDependencies();
+
+	/** Fill Movement with the current movement state of the owner. */
+	void GatherMovement(FRepExtMovement& Movement) const;
+
+	void RecordFrame();
+	void ReplayFrame(float DeltaTime);
+
+	/** Restore the owner to the initial state of the recording. */
+	virtual void ApplyInitialState();
+
+	/** Execute the handlers bound to an action. */
+	void ExecuteAction(FName ActionName, bool bPressed);
+
+	/** Compare the current state to the recording at the current time. */
+	void CompareFrame();
+};
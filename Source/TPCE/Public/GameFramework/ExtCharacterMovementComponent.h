@@ -6,6 +6,7 @@
 #include "UObject/Interface.h"
 #include "UObject/ObjectMacros.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "Math/Bounds.h"
 #include "ExtraTypes.h"
 #include "ExtraMacros.h"
@@ -15,6 +16,8 @@
 class ACharacter;
 class AExtCharacter;
 class FNetworkPredictionData_Client_Character;
+class ACrowdMovementManager;
+struct FCrowdMovementBatch;
 
 /**
  *
@@ -49,6 +52,159 @@ struct FPivotTurnSettings
 	FBounds FrictionFactor;
 };
 
+/** Character condition that selects an alternative set of movement parameters. */
+UENUM(BlueprintType)
+enum class EMovementParameterCondition : uint8
+{
+	Default,
+	Landing,
+	Ragdoll
+};
+
+/**
+ * Replaces movement parameters for a given movement mode and condition. Overrides for Walking also apply to NavWalking
+ * unless NavWalking overrides the same parameter.
+ * @see UExtCharacterMovementComponent::MovementParameterOverrides
+ */
+USTRUCT(BlueprintType)
+struct FMovementParametersOverride
+{
+	GENERATED_BODY()
+
+	FMovementParametersOverride();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TEnumAsByte<EMovementMode> MovementMode;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EMovementParameterCondition Condition;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (PinHiddenByDefault, InlineEditConditionToggle))
+	uint32 bOverride_MaxSpeed : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (PinHiddenByDefault, InlineEditConditionToggle))
+	uint32 bOverride_MaxAcceleration : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (PinHiddenByDefault, InlineEditConditionToggle))
+	uint32 bOverride_BrakingDeceleration : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (PinHiddenByDefault, InlineEditConditionToggle))
+	uint32 bOverride_BrakingFrictionFactor : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (editcondition = "bOverride_MaxSpeed", ClampMin = "0", UIMin = "0"))
+	float MaxSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (editcondition = "bOverride_MaxAcceleration", ClampMin = "0", UIMin = "0"))
+	float MaxAcceleration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (editcondition = "bOverride_BrakingDeceleration", ClampMin = "0", UIMin = "0"))
+	float BrakingDeceleration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (editcondition = "bOverride_BrakingFrictionFactor", ClampMin = "0", UIMin = "0"))
+	float BrakingFrictionFactor;
+};
+
+/**
+ * Locomotion state of a character and its movement component published once per movement update, so animation can read it
+ * without reaching into the character while movement may be running.
+ * @see UExtCharacterMovementComponent::ReadLocomotionSnapshot
+ */
+struct TPCE_API FExtLocomotionSnapshot
+{
+	uint32 bIsJumping : 1;
+	uint32 bIsCrouched : 1;
+	uint32 bIsPerformingGenericAction : 1;
+	uint32 bIsRagdoll : 1;
+	uint32 bIsGettingUp : 1;
+	uint32 bEnableFootIK : 1;
+	uint32 bIsPivotTurning : 1;
+	uint32 bIsLandingPredicted : 1;
+	uint32 bIsSleeping : 1;
+
+	/** Whether StopLocation and StopDistance hold a prediction. Stops are only predicted while braking or reversing on the ground. */
+	uint32 bIsStopPredicted : 1;
+
+	TEnumAsByte<EMovementMode> MovementMode;
+	uint8 CustomMovementMode;
+	ECharacterGait Gait;
+	ECharacterRotationMode RotationMode;
+	ETurnInPlaceState TurnInPlaceState;
+
+	float MovementDrift;
+	float TurnInPlaceTargetYaw;
+	float GetUpDelay;
+
+	/** Predicted time in seconds until the character lands or a negative value if no landing is predicted. */
+	float TimeToLand;
+
+	/** Predicted distance to StopLocation. */
+	float StopDistance;
+
+	FVector Location;
+	FRotator Rotation;
+	FRotator LookRotation;
+
+	FVector Velocity;
+	FVector Acceleration;
+	FVector LastMovementAcceleration;
+	FVector LandingLocation;
+	FVector LandingNormal;
+
+	/** Location the character is predicted to stop at. */
+	FVector StopLocation;
+
+	FExtLocomotionSnapshot() :
+		bIsJumping(false),
+		bIsCrouched(false),
+		bIsPerformingGenericAction(false),
+		bIsRagdoll(false),
+		bIsGettingUp(false),
+		bEnableFootIK(false),
+		bIsPivotTurning(false),
+		bIsLandingPredicted(false),
+		bIsSleeping(false),
+		bIsStopPredicted(false),
+		MovementMode(MOVE_None),
+		CustomMovementMode(0),
+		Gait(ECharacterGait::Run),
+		RotationMode(ECharacterRotationMode::None),
+		TurnInPlaceState(ETurnInPlaceState::Done),
+		MovementDrift(0.f),
+		TurnInPlaceTargetYaw(0.f),
+		GetUpDelay(0.f),
+		TimeToLand(-1.f),
+		StopDistance(0.f),
+		Location(FVector::ZeroVector),
+		Rotation(FRotator::ZeroRotator),
+		LookRotation(FRotator::ZeroRotator),
+		Velocity(FVector::ZeroVector),
+		Acceleration(FVector::ZeroVector),
+		LastMovementAcceleration(FVector::ZeroVector),
+		LandingLocation(FVector::ZeroVector),
+		LandingNormal(FVector::UpVector),
+		StopLocation(FVector::ZeroVector)
+	{}
+};
+
+/** Effective movement parameters for a movement mode and condition, resolved from the component settings and overrides. */
+struct FMovementParameters
+{
+	float MaxSpeed;
+	float MaxAcceleration;
+	float BrakingDeceleration;
+	float BrakingFrictionFactor;
+
+	FMovementParameters() :
+		MaxSpeed(0.f),
+		MaxAcceleration(0.f),
+		BrakingDeceleration(0.f),
+		BrakingFrictionFactor(0.f)
+	{}
+
+	/** Replace the parameters overridden by Override. */
+	void Apply(const FMovementParametersOverride& Override);
+};
+
 
 /** Extra Movement capabilities, determining available movement options for VSICharacters. */
 USTRUCT(BlueprintType)
@@ -130,6 +286,24 @@ protected:  // Bitfields
 	 */
 	uint32 bCanEnforceControlRotationMaxDistance : 1;
 
+	/** If true a landing prediction has been computed for the current fall. */
+	uint32 bHasLandingPrediction : 1;
+
+	/** If true velocity for the current frame was taken from the crowd movement batch. */
+	uint32 bHasCrowdBatchedVelocity : 1;
+
+	/** If true the character has been switched from walking to nav walking by the movement LOD. */
+	uint32 bIsMovementLODActive : 1;
+
+	/** If true CachedFloor holds a floor result that can be reused. */
+	mutable uint32 bHasCachedFloor : 1;
+
+	/** If true the mesh has been offset to interpolate between fixed timesteps. */
+	uint32 bHasFixedTimestepVisualOffset : 1;
+
+	/** If true the character has been idle for longer than SleepDelay and movement updates are throttled. */
+	uint32 bIsSleeping : 1;
+
 public: // Bitfields
 
 	/** If true, Character can walk off a ledge when walking. */
@@ -183,6 +357,14 @@ public: // Bitfields
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling")
 	uint32 bPreserveMovementOnLanding : 1;
 
+	/**
+	 * If true the landing point of a fall is predicted natively with a few capsule sweeps along the ballistic path. The prediction runs once 
+	 * when the character starts to fall and again only if velocity deviates from the predicted path by more than LandingPredictionVelocityTolerance.
+	 * @see GetTimeToLand, GetPredictedLandingNormal
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling")
+	uint32 bEnableLandingPrediction : 1;
+
 	/*
 	 * If true character will rotate with different rates depending on its ground speed in meters/second. This should normally produce faster rotations as
 	 * the character moves faster. Helps simulating angular momentum similarly to how pivot turning works for linear movement.
@@ -191,6 +373,14 @@ public: // Bitfields
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Rotation Settings)", AdvancedDisplay)
 	uint32 bEnableAdaptiveRotationRate : 1;
 
+	/**
+	 * If true rotation is computed as a single yaw angle around CharacterUpVector and applied as a quaternion, avoiding rotator conversions.
+	 * Required for any up vector other than world Z. Gravity and floor checks are not affected.
+	 * @see CharacterUpVector
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Rotation Settings)", AdvancedDisplay)
+	uint32 bUseQuaternionRotation : 1;
+
 	/**
 	 * If true MaxAcceleration and GroundFriction will be dynamically adjusted when velocity and acceleration have opposing directions giving the character more "weight".
 	 * This provides time for the pivot turn animation to play before movement starts in the opposite direction. 
@@ -214,6 +404,68 @@ public: // Bitfields
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: TurnInPlace", meta = (editcondition = "bEnableTurnInPlace"))
 	uint32 bUseTurnInPlaceDelay : 1;
 
+	/**
+	 * If true and the character is AI controlled on the server, velocity and rotation are computed in parallel together with other characters 
+	 * by the crowd movement manager, which also sweeps the floor each character is headed to. Movement settings are sampled when the manager
+	 * ticks, earlier in the same frame, so changes made in between only take effect the next frame. Only effective if set before BeginPlay.
+	 * @see ACrowdMovementManager
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", AdvancedDisplay)
+	uint32 bUseCrowdMovementManager : 1;
+
+	/**
+	 * If true and the character is batched by the crowd movement manager, its input acceleration or path following requested velocity is steered
+	 * away from other batched characters before velocity is computed, using reciprocal velocity obstacles. Responsibility for avoiding is shared
+	 * according to CrowdAvoidancePriority.
+	 * @see bUseCrowdMovementManager
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Avoidance", meta = (editcondition = "bUseCrowdMovementManager"))
+	uint32 bEnableCrowdAvoidance : 1;
+
+	/**
+	 * If true AI controlled characters on the server switch from walking to nav walking when farther than MovementLODDistance from every player.
+	 * Nav walking moves along the navmesh surface without floor finding, step up or ledge checks. Characters are promoted back to walking 
+	 * when they get closer to a player or overlap a dynamic obstacle. Pawns and other ExtCharacters are not considered obstacles.
+	 * @see MovementLODDistance
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: LOD")
+	uint32 bEnableMovementLOD : 1;
+
+	/**
+	 * If true locally controlled and AI characters are simulated in steps of FixedTimestep regardless of frame rate, so the same
+	 * input stream always produces the same movement. Time left over between steps is accumulated for the next frame and the mesh
+	 * is interpolated between the last two simulated states.
+	 * @see FixedTimestep, MaxFixedTimestepIterations
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", AdvancedDisplay)
+	uint32 bUseFixedTimestep : 1;
+
+	/**
+	 * If true AI and simulated characters that stay idle on static ground for SleepDelay seconds go to sleep. While asleep movement is 
+	 * only updated every SleepTickInterval and the anim instance stops updating locomotion. The character wakes up as soon as it 
+	 * receives input, a force, an impulse, a replicated correction or any change of state.
+	 * @see SleepDelay, SleepTickInterval
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Sleep")
+	uint32 bEnableSleep : 1;
+
+	/**
+	 * If true the last floor found on static geometry is reused instead of sweeping again while the character moves less than FloorCacheTolerance.
+	 * The cache is invalidated by movement mode changes, capsule size changes and level streaming.
+	 * @see FloorCacheTolerance
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking", AdvancedDisplay)
+	uint32 bEnableFloorCache : 1;
+
+	/**
+	 * If true and the character cannot walk off ledges, floors baked by a ledge map volume are used to reject side steps that lead off a ledge 
+	 * without sweeping. Side steps with a baked floor, dynamic floors or no ledge map are still checked by the ledge sweeps, which also detect
+	 * walls blocking the step.
+	 * @see ALedgeMapVolume
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking", AdvancedDisplay)
+	uint32 bUseLedgeMap : 1;
+
 private: // Variables
 
 #if WITH_EDITOR
@@ -274,6 +526,86 @@ protected:  // Variables
 	UPROPERTY()
 	FVector SimulatedAcceleration;
 
+	/** World time when the current landing prediction was computed. */
+	float LandingPredictionWorldTime;
+
+	/** Velocity used to compute the current landing prediction. */
+	FVector LandingPredictionVelocity;
+
+	/** Time to land from the moment the prediction was computed. Negative if no landing was found within LandingPredictionMaxTime. */
+	float LandingPredictionTimeToLand;
+
+	/** Location of the capsule at the predicted landing. */
+	FVector PredictedLandingLocation;
+
+	/** Impact normal of the surface at the predicted landing. */
+	FVector PredictedLandingNormal;
+
+	/** Crowd movement manager this component is registered with. */
+	UPROPERTY(Transient, DuplicateTransient)
+	ACrowdMovementManager* CrowdMovementManager;
+
+	/** Index of this component in the crowd movement batch of the current frame or INDEX_NONE. */
+	int32 CrowdBatchIndex;
+
+	/** Controller whose path following component the crowd movement manager was last made to tick after. */
+	TWeakObjectPtr<AController> CrowdTickPrerequisiteController;
+
+	/** Path following component the crowd movement manager ticks after, so its requests are gathered in the same frame. */
+	TWeakObjectPtr<UActorComponent> CrowdTickPrerequisiteComponent;
+
+	/** Time since movement LOD was last evaluated. */
+	float MovementLODTimeCounter;
+
+	/** Time the character has been idle while awake or time since the last movement update while asleep. */
+	float SleepTimeCounter;
+
+	/** Look rotation when the character went to sleep. */
+	FRotator SleepLookRotation;
+
+	/** Simulation time not yet consumed by fixed timesteps. */
+	float FixedTimestepAccumulator;
+
+	/** Location of the updated component before the last fixed timestep. */
+	FVector FixedTimestepPrevLocation;
+
+	/** Rotation of the updated component before the last fixed timestep. */
+	FQuat FixedTimestepPrevRotation;
+
+	/** Last floor found on static geometry. */
+	mutable FFindFloorResult CachedFloor;
+
+	/** Capsule location used to find CachedFloor. */
+	mutable FVector CachedFloorLocation;
+
+	/** Scaled capsule radius and half height used to find CachedFloor. */
+	mutable FVector2D CachedFloorCapsuleSize;
+
+	/** Value of FloorCacheGeneration when CachedFloor was found. */
+	mutable uint32 CachedFloorGeneration;
+
+	/** Incremented to invalidate the floor cache of every component, for instance when levels are streamed in or out. */
+	static uint32 FloorCacheGeneration;
+
+	/** 
+	 * Effective movement parameters for every movement mode and condition indexed by GetMovementParameterKey(). 
+	 * The lower 3 bits of the key are the movement mode, bit 3 is set when landing and bit 4 when in ragdoll.
+	 * @see RebuildMovementParameterTable
+	 */
+	FMovementParameters MovementParameterTable[32];
+
+	/** Index in MovementParameterTable of the current movement mode and condition. */
+	uint32 MovementParameterKey;
+
+	/** Locomotion snapshots, written alternately by PublishLocomotionSnapshot. */
+	FExtLocomotionSnapshot LocomotionSnapshots[2];
+
+	/** Number of locomotion snapshots published. The latest is in LocomotionSnapshots[(Count - 1) & 1]. */
+	FThreadSafeCounter NumLocomotionSnapshots;
+
+	/** Number of locomotion snapshots whose publishing has started, one more than NumLocomotionSnapshots while writing. */
+	FThreadSafeCounter NumLocomotionSnapshotsStarted;
+
 public: // Variables
 
 	/**
@@ -308,6 +640,10 @@ public: // Variables
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: PivotTurn", meta = (editcondition = "bEnablePivotTurn"))
 	float PivotTurnMinSpeed;
 
+	/** Direction the character is kept aligned to when bUseQuaternionRotation is true. All rotation modes rotate around this axis. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Rotation Settings)", meta = (editcondition = "bUseQuaternionRotation"), AdvancedDisplay)
+	FVector CharacterUpVector;
+
 	/** Maximum absolute angle the character can look before being force to rotate. Only used if UseControllerDesiredRotation is true and OrientRotationToMovement is false. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Rotation Settings)", meta = (ClampMin = "45", UIMin = "45", ClampMax = "90", UIMax = "90"))
 	float LookAngleThreshold;
@@ -370,6 +706,66 @@ public: // Variables
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (ClampMin = "0", UIMin = "0"))
 	float MaxFallingAcceleration;
 
+	/** Maximum distance the character can move from where the cached floor was found for it to be reused. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking", meta = (editcondition = "bEnableFloorCache", ClampMin = "0", UIMin = "0", ClampMax = "10", UIMax = "10"), AdvancedDisplay)
+	float FloorCacheTolerance;
+
+	/** Duration in seconds of each simulation step when bUseFixedTimestep is true. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", meta = (editcondition = "bUseFixedTimestep", ClampMin = "0.001", UIMin = "0.001", ClampMax = "0.1", UIMax = "0.1"), AdvancedDisplay)
+	float FixedTimestep;
+
+	/** Maximum number of fixed timesteps simulated in a single frame. Any time beyond that is discarded so slow frames cannot snowball. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", meta = (editcondition = "bUseFixedTimestep", ClampMin = "1", UIMin = "1", ClampMax = "16", UIMax = "16"), AdvancedDisplay)
+	int32 MaxFixedTimestepIterations;
+
+	/** Time in seconds the character has to remain idle before going to sleep. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Sleep", meta = (editcondition = "bEnableSleep", ClampMin = "0", UIMin = "0"))
+	float SleepDelay;
+
+	/** Time in seconds between movement updates while asleep. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Sleep", meta = (editcondition = "bEnableSleep", ClampMin = "0", UIMin = "0"))
+	float SleepTickInterval;
+
+	/** Radius used for crowd avoidance. If zero the capsule radius is used. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Avoidance", meta = (editcondition = "bEnableCrowdAvoidance", ClampMin = "0", UIMin = "0"))
+	float CrowdAvoidanceRadius;
+
+	/**
+	 * Relative priority in crowd avoidance. Between two characters each one takes a share of the avoidance equal to the other's priority over
+	 * their sum, so the one with the lower priority takes the larger share. A character with zero priority gets entirely out of the way of
+	 * characters with a higher priority, which never avoid it. Two characters with zero priority share the avoidance equally.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Avoidance", meta = (editcondition = "bEnableCrowdAvoidance", ClampMin = "0", UIMin = "0"))
+	float CrowdAvoidancePriority;
+
+	/** Time in seconds to look ahead for collisions with other characters. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Avoidance", meta = (editcondition = "bEnableCrowdAvoidance", ClampMin = "0.01", UIMin = "0.01"))
+	float CrowdAvoidanceTimeHorizon;
+
+	/** Distance to the closest player view point beyond which movement LOD is activated. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: LOD", meta = (editcondition = "bEnableMovementLOD", ClampMin = "0", UIMin = "0"))
+	float MovementLODDistance;
+
+	/** Distance subtracted from MovementLODDistance to deactivate movement LOD. Prevents switching back and forth at the boundary. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: LOD", meta = (editcondition = "bEnableMovementLOD", ClampMin = "0", UIMin = "0"))
+	float MovementLODHysteresis;
+
+	/** Time in seconds between movement LOD evaluations. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: LOD", meta = (editcondition = "bEnableMovementLOD", ClampMin = "0", UIMin = "0"))
+	float MovementLODCheckInterval;
+
+	/** Maximum time in seconds to look ahead for a landing. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (editcondition = "bEnableLandingPrediction", ClampMin = "0", UIMin = "0"))
+	float LandingPredictionMaxTime;
+
+	/** Number of capsule sweeps used to approximate the ballistic path over LandingPredictionMaxTime. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (editcondition = "bEnableLandingPrediction", ClampMin = "1", UIMin = "1", ClampMax = "16", UIMax = "16"))
+	int32 LandingPredictionSweepCount;
+
+	/** A new landing prediction is computed when velocity deviates from the predicted ballistic velocity by more than this value. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (editcondition = "bEnableLandingPrediction", ClampMin = "0", UIMin = "0"), AdvancedDisplay)
+	float LandingPredictionVelocityTolerance;
+
 	/**
 	 * Factor used in place of BrakingFrictionFactor to multiply actual value of friction used when braking in Walking/NavWalking after landing.
 	 * Only used if bPreserveMovementOnLand is true.
@@ -399,16 +795,96 @@ public: // Variables
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Ragdoll", meta = (ClampMin = "0", UIMin = "0"))
 	float BrakingDecelerationRagdoll;
 
+	/** 
+	 * Replace the movement parameters of specific movement modes and conditions. Later entries take precedence.
+	 * Call RebuildMovementParameterTable() after changing at runtime.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", AdvancedDisplay)
+	TArray<FMovementParametersOverride> MovementParameterOverrides;
+
 protected: // Methods
 
 	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
 	virtual FVector ScaleInputAcceleration(const FVector& InputAcceleration) const override;
 
 	virtual void ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration) override;
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
 	virtual void SimulateMovement(float DeltaSeconds) override;
 
+	/** Replays pending saved moves after a server correction. Overridden to account for replay cost per correction. */
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
 	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity);
 
+	/** Fill Snapshot with the current locomotion state of the character. */
+	virtual void FillLocomotionSnapshot(FExtLocomotionSnapshot& Snapshot) const;
+
+	/** @return index in MovementParameterTable for the current movement mode and condition. */
+	uint32 GetMovementParameterKey() const;
+
+	/** @return movement parameters from the component settings for Mode and Condition, without overrides. */
+	FMovementParameters GetSettingsMovementParameters(EMovementMode Mode, EMovementParameterCondition Condition) const;
+
+	/** @return true if CachedFloor can be reused for a capsule at CapsuleLocation. */
+	bool CanReuseCachedFloor(const FVector& CapsuleLocation) const;
+
+	/** Keep FloorResult found for a capsule at CapsuleLocation as the cached floor if it is a walkable floor on static geometry. */
+	void CacheFloor(const FVector& CapsuleLocation, const FFindFloorResult& FloorResult) const;
+
+	/** Switch between walking and nav walking according to the distance to the closest player and overlaps with dynamic obstacles. */
+	virtual void UpdateMovementLOD(float DeltaSeconds);
+
+	/** Quaternion-native version of PhysicsRotation that rotates around CharacterUpVector. */
+	virtual void PhysicsRotationQuat(float DeltaSeconds);
+
+	/** 
+	 * Update the turn in place target from the character and control yaws. CurrentYaw may be adjusted to respect TurnInPlaceMaxDistance.
+	 * @return false if the character cannot turn in place in the current state.
+	 */
+	bool UpdateTurnInPlaceTarget(float& CurrentYaw, const float ControlYaw, float DeltaSeconds);
+
+	/** Adjust CurrentYaw to respect ControlRotationMaxDistance. */
+	void EnforceControlRotationMaxDistance(float& CurrentYaw, const float ControlYaw);
+
+	/** Update RotationOffset from the yaw delta between look and movement direction. @return the new RotationOffset. */
+	float UpdateLookRotationOffset(float LookYawDelta, const float NorthSegmentHalfWidth, float Buffer, float DeltaSeconds);
+
+	/** @return yaw change towards DesiredYaw for this update using the rotation rate. */
+	float GetDeltaYaw(const float CurrentYaw, const float DesiredYaw, float DeltaSeconds) const;
+
+	/** @return true if movement LOD can be applied in the current state. */
+	virtual bool CanUseMovementLODInCurrentState() const;
+
+	/** 
+	 * @return true if the character is idle and nothing can move it without waking it up. Locally controlled players and autonomous 
+	 * proxies never sleep so input is not delayed.
+	 */
+	virtual bool CanSleepInCurrentState() const;
+
+	/** Put the character to sleep after SleepDelay seconds idle or wake it up if no longer idle. */
+	virtual void UpdateSleepState(float DeltaSeconds);
+
+	/** @return true if the character can be simulated in fixed timesteps. Only characters whose moves are performed locally qualify. */
+	virtual bool CanUseFixedTimestepInCurrentState() const;
+
+	/** Consume DeltaTime in fixed timesteps and interpolate the mesh between the last two simulated states. */
+	virtual void TickFixedTimestep(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction);
+
+	/** Offset the mesh to the state interpolated by Alpha between the previous and current fixed timesteps. */
+	virtual void UpdateFixedTimestepVisuals(float Alpha);
+
+	/** Clear the accumulator and restore the mesh to its base offsets. */
+	void ResetFixedTimestep();
+
+	/** Computes a new landing prediction if there is none for the current fall or velocity has deviated from the predicted path. */
+	virtual void UpdateLandingPrediction();
+
+	/** 
+	 * Sweep the capsule along the ballistic path starting at Start with InVelocity.
+	 * @return true if a blocking hit was found within LandingPredictionMaxTime.
+	 */
+	virtual bool PredictLanding(const FVector& Start, const FVector& InVelocity, float& OutTimeToLand, FVector& OutLocation, FVector& OutNormal) const;
+
 	/** Called after MovementMode has changed. It does special handling for starting certain modes then calls OnAfterMovementModeChanged and notifies the CharacterOwner. */
 	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
 
@@ -416,18 +892,35 @@ public: // Methods
 
 #if WITH_EDITOR
 	virtual bool CanEditChange(const UProperty* InProperty) const override;
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& e) override;
 #endif
 
 	virtual void PostLoad() override;
 	virtual void SetUpdatedComponent(USceneComponent* NewUpdatedComponent) override;
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 
 	virtual float GetMaxSpeed() const override;
 	virtual float GetMaxBrakingDeceleration() const override;
 	virtual float GetBrakingFrictionFactor() const;
 
+	/** @return max acceleration for the current movement mode and condition. */
+	virtual float GetMaxModeAcceleration() const;
+
+	/** 
+	 * Resolve the effective speed, acceleration and braking parameters of every movement mode and condition from the settings and
+	 * MovementParameterOverrides. Called when gait or stance change. Must be called after changing any of those settings or
+	 * MovementParameterOverrides at runtime so they take effect.
+	 * @see MovementParameterOverrides
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	virtual void RebuildMovementParameterTable();
+
+	/** Select the movement parameters for the current movement mode and condition. Called when the mode, landing or ragdoll state change. */
+	void UpdateMovementParameterKey();
+
 	virtual FVector GetSimulatedAcceleration() const; 
 
 	virtual void SetReplicatedAcceleration(const FVector& Value);
@@ -442,8 +935,27 @@ public: // Methods
 	virtual FRotator ComputeOrientToMovementRotation(const FRotator& CurrentRotation, float DeltaSeconds);
 	virtual FRotator ComputeOrientToLookRotation(const FRotator& LookRotation, const float NorthSegmentHalfWidth, float Buffer, float DeltaSeconds);
 
+	/** @return the direction the character should orient to when OrientRotationToMovement is true or zero if there is none. */
+	virtual FVector ComputeOrientToMovementDirection() const;
+
 	virtual bool ShouldRemainVertical() const override;
 
+	virtual void AddInputVector(FVector WorldVector, bool bForce = false) override;
+	virtual void AddImpulse(FVector Impulse, bool bVelocityChange = false) override;
+	virtual void AddForce(FVector Force) override;
+	virtual void Launch(FVector const& LaunchVel) override;
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+	virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
+
+	/** Find floor reusing the last result when the character has not moved from static geometry. */
+	virtual void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult = NULL) const override;
+
+	/** Invalidate the floor cache of this component. */
+	FORCEINLINE void InvalidateFloorCache() { bHasCachedFloor = false; }
+
+	/** Invalidate the floor cache of every component. */
+	static void InvalidateAllFloorCaches() { ++FloorCacheGeneration; }
+
 	/** Perform rotation over deltaTime. This is an override to support interpolation, turn in place and adaptive rotation. */
 	virtual void PhysicsRotation(float DeltaSeconds) override;
 
@@ -462,12 +974,32 @@ public: // Methods
 
 	virtual bool CanCrouchInCurrentState() const override;
 	virtual bool CanWalkOffLedges() const override;
+	virtual bool CheckLedgeDirection(const FVector& OldLocation, const FVector& SideStep, const FVector& GravDir) const override;
 
 	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
 	virtual void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
 
 	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
 
+	/** 
+	 * Append the inputs for this frame's velocity and rotation to a crowd movement batch if the character is eligible. 
+	 * @return true if added to the batch.
+	 */
+	virtual bool GatherBatchedMovement(float DeltaSeconds, FCrowdMovementBatch& Batch);
+
+	/** Compute velocity and rotation for a single entry of a crowd movement batch. Safe to call from worker threads. */
+	static void ProcessBatchedMovement(FCrowdMovementBatch& Batch, int32 Index);
+
+	/**
+	 * Find the floor at the end of the first walking step predicted by the crowd movement batch and keep it in the floor cache, so FindFloor
+	 * after the move is a cache hit. Only reads the world and writes the floor cache of this component, so it can run in parallel for different
+	 * components while none of them is ticking.
+	 */
+	void PrefetchBatchedFloor(const FCrowdMovementBatch& Batch, int32 Index) const;
+
+	/** Make the crowd movement manager tick after the path following component of the current controller, if it changed. */
+	void UpdateCrowdTickPrerequisites();
+
 	/** Resets rotation rate factor to zero. */
 	void ResetRotationRateFactor();
 
@@ -551,10 +1083,54 @@ public: // Methods
 	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
 	virtual bool IsLanding() const;
 
-	/** */
+	/** 
+	 * Predict where the character would stop if it started braking now. Available on all roles. 
+	 * @return true if the character is expected to stop within TimeLimit.
+	 * @see PredictStop
+	 */
 	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
 	virtual bool PredictStopLocation(FVector& OutStopLocation, const float TimeLimit = 2.0f, const float TimeStep = 0.01666667f);
 
+	/** 
+	 * Predict the location, time and distance for the character to stop. Braking without acceleration is solved in closed form for the 
+	 * friction plus deceleration model while other cases fall back to stepping in TimeStep increments up to TimeLimit. Available on all roles.
+	 * @return true if the character is expected to stop within TimeLimit.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	virtual bool PredictStop(FVector& OutStopLocation, float& OutStopTime, float& OutStopDistance, const float TimeLimit = 2.0f, const float TimeStep = 0.01666667f);
+
+	/** @return true if the character has been switched to nav walking by the movement LOD. */
+	FORCEINLINE bool IsMovementLODActive() const { return bIsMovementLODActive; }
+
+	/** @return true if the character is asleep. */
+	FORCEINLINE bool IsSleeping() const { return bIsSleeping; }
+
+	/** Wake the character up if asleep and restart the idle time count. */
+	void WakeUp();
+
+	/** 
+	 * [game thread] Wake the character up and publish the locomotion snapshot. Called by the character when state read by animation
+	 * (gait, crouch, ragdoll, generic action, rotation mode or look rotation) changes outside a movement update, so it is not seen late.
+	 */
+	void NotifyLocomotionStateChanged();
+
+	/** @return fraction of a fixed timestep that has been accumulated but not yet simulated. */
+	FORCEINLINE float GetFixedTimestepAlpha() const { return FixedTimestep > 0.f ? FixedTimestepAccumulator / FixedTimestep : 0.f; }
+
+	/** @return true if falling and a landing has been predicted within LandingPredictionMaxTime. */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	bool IsLandingPredicted() const;
+
+	/** @return predicted time in seconds until the character lands or a negative value if no landing is predicted. */
+	UFUNCTION(BlueprintCallable, Category = "Pawn|Components|CharacterMovement")
+	float GetTimeToLand() const;
+
+	/** @return location of the capsule at the predicted landing. Only valid if IsLandingPredicted() is true. */
+	FORCEINLINE FVector GetPredictedLandingLocation() const { return PredictedLandingLocation; }
+
+	/** @return impact normal of the surface at the predicted landing. Only valid if IsLandingPredicted() is true. */
+	FORCEINLINE FVector GetPredictedLandingNormal() const { return PredictedLandingNormal; }
+
 	/** */
 	FORCEINLINE AExtCharacter* GetExtCharacterOwner() const { return ExtCharacterOwner; }
 
@@ -574,6 +1150,22 @@ public: // Methods
 
 	/** @return Target yaw for turn in place. */
 	FORCEINLINE float GetTurnInPlaceTargetYaw() const { return TurnInPlaceTargetYaw; }
+
+	/** 
+	 * [game thread] Publish the current locomotion state. Called after every movement update, call it to publish state changes 
+	 * when movement is not updated. The snapshot is written into the buffer readers are not using.
+	 */
+	void PublishLocomotionSnapshot();
+
+	/**
+	 * [any thread] Copy the latest published locomotion snapshot into OutSnapshot without locking. A publish in progress writes the other
+	 * buffer so it is never waited for. Only if a second publish starts rewriting the buffer being copied is the copy retried.
+	 * @return false if no snapshot has been published yet.
+	 */
+	bool ReadLocomotionSnapshot(FExtLocomotionSnapshot& OutSnapshot) const;
+
+	/** @return true if a locomotion snapshot has been published. */
+	FORCEINLINE bool HasLocomotionSnapshot() const { return NumLocomotionSnapshots.GetValue() > 0; }
 };
 
 class TPCE_API FSavedMove_ExtCharacter: public FSavedMove_Character
@@ -610,6 +1202,25 @@ public:
 	typedef FNetworkPredictionData_Client_Character Super;
 
 	FNetworkPredictionData_Client_ExtCharacter(const UCharacterMovementComponent& ClientMovement);
+	virtual ~FNetworkPredictionData_Client_ExtCharacter();
 
 	virtual FSavedMovePtr AllocateNewMove() override;
+
+protected:
+
+	/** 
+	 * Fixed capacity contiguous storage for saved moves. Sized once on construction and never reallocated so moves 
+	 * handed out as shared pointers remain valid. Moves are recycled in place through FreeMoves and only fall back 
+	 * to the heap when every slot is in use.
+	 */
+	TArray<FSavedMove_ExtCharacter> MovePool;
+
+	/**
+	 * Shared pointer to each move in MovePool, created once with the pool so handing out a move never allocates a reference controller.
+	 * A slot is free when the pointer held here is the only reference to it.
+	 */
+	TArray<FSavedMovePtr> MovePoolPtrs;
+
+	/** Ring cursor to the next slot to be tried by AllocateNewMove. Moves are acked in order so the next free slot is usually right here. */
+	int32 MovePoolCursor;
 };
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Volume.h"
+
+#include "LedgeMapVolume.generated.h"
+
+class UWorld;
+
+/** Result of a ledge map floor query. */
+enum class ELedgeMapQueryResult : uint8
+{
+	/** Location is not covered by a baked ledge map. Traces are needed. */
+	Unknown,
+	/** A walkable floor was baked within the requested height range. */
+	Floor,
+	/** No walkable floor was baked within the requested height range, i.e. a ledge or an obstruction. */
+	NoFloor
+};
+
+/** Flags of a baked ledge map layer. */
+enum ELedgeMapLayerFlags : uint8
+{
+	/** Something blocks the movement channel less than LayerClearance above the floor, e.g. a low ceiling or an overhanging wall. */
+	LEDGEMAPLAYER_Obstructed = 0x01,
+	/** The floor is not static so it may have moved since it was baked. Queries that depend on it fall back to traces. */
+	LEDGEMAPLAYER_Dynamic = 0x02,
+};
+
+/**
+ * Bakes the walkable floor heights found inside its bounds into a uniform grid, up to MaxLayers floors stacked per cell, so stairs,
+ * rooftops and the streets below are all represented. Height differences between neighbour cells give the step heights and walk-off edges,
+ * compared at query time against the step height of the querying character.
+ *
+ * Floors are traced against CollisionChannel, the channel characters move in. Floors without enough clearance above them to stand are
+ * marked obstructed and never count as floor. Floors that are not static are marked dynamic and leave the decision to the ledge sweeps.
+ *
+ * Characters that cannot walk off ledges query the map before running the ledge sweeps of UCharacterMovementComponent::CheckLedgeDirection
+ * and skip the sweeps where the map has no floor. The map does not store lateral obstructions so a baked floor still needs the sweeps.
+ * The map must be rebuilt after level geometry changes.
+ * @see UExtCharacterMovementComponent::bUseLedgeMap
+ */
+UCLASS(hidecategories = (Navigation, Collision, Cooking))
+class TPCE_API ALedgeMapVolume : public AVolume
+{
+	GENERATED_BODY()
+
+public: // Bitfields
+
+	/** If true the map is rebuilt when play begins instead of using baked data. Useful for procedurally placed levels. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map")
+	uint32 bBuildOnBeginPlay : 1;
+
+public: // Variables
+
+	/** Size of each grid cell. Should be smaller than the capsule radius of the characters using the map. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map", meta = (ClampMin = "1", UIMin = "1"))
+	float CellSize;
+
+	/** Maximum number of floors stacked in a cell. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map", meta = (ClampMin = "1", UIMin = "1", ClampMax = "8", UIMax = "8"))
+	int32 MaxLayers;
+
+	/** Minimum vertical distance between two floors of a cell. Should be at least the height of the characters using the map. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map", meta = (ClampMin = "0", UIMin = "0"))
+	float LayerClearance;
+
+	/** Maximum angle in degrees of a walkable floor. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map", meta = (ClampMin = "0", UIMin = "0", ClampMax = "90", UIMax = "90"))
+	float WalkableFloorAngle;
+
+	/** Channel traced for floors and obstructions. Should be the collision object type of the capsule of the characters using the map. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ledge Map")
+	TEnumAsByte<ECollisionChannel> CollisionChannel;
+
+protected: // Variables
+
+	/** Location of the corner of the first cell. */
+	UPROPERTY()
+	FVector BakedOrigin;
+
+	/** Number of cells in X and Y. */
+	UPROPERTY()
+	FIntPoint BakedSize;
+
+	/** Cell size used when the map was baked. */
+	UPROPERTY()
+	float BakedCellSize;
+
+	/** Number of layers per cell used when the map was baked. */
+	UPROPERTY()
+	int32 BakedMaxLayers;
+
+	/** Floor heights of each cell in descending order, BakedMaxLayers per cell. Unused layers are set to -MAX_flt. */
+	UPROPERTY()
+	TArray<float> LayerHeights;
+
+	/** ELedgeMapLayerFlags of each layer in LayerHeights. */
+	UPROPERTY()
+	TArray<uint8> LayerFlags;
+
+public: // Methods
+
+	ALedgeMapVolume();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Trace the floors inside the volume and store them. */
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Ledge Map")
+	void Build();
+
+	/** Discard baked data. */
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Ledge Map")
+	void Clear();
+
+	/** @return true if the map has baked data. Maps baked before layer flags were stored must be rebuilt. */
+	FORCEINLINE bool IsBuilt() const { return LayerHeights.Num() > 0 && LayerFlags.Num() == LayerHeights.Num(); }
+
+	/**
+	 * Query the floor under a disc of Radius centered at Location.
+	 * @return Floor if any cell under the disc has an unobstructed static floor with height in [MinZ, MaxZ], Unknown if the disc is not fully 
+	 * covered or none does but a dynamic floor is in range, NoFloor otherwise.
+	 */
+	ELedgeMapQueryResult QueryFloor(const FVector& Location, float Radius, float MinZ, float MaxZ) const;
+
+	/** Find the built ledge map of World containing Location. */
+	static const ALedgeMapVolume* Find(const UWorld* World, const FVector& Location);
+
+protected: // Methods
+
+	FORCEINLINE int32 GetCellIndex(int32 X, int32 Y) const { return (Y * BakedSize.X + X) * BakedMaxLayers; }
+
+	/** Ledge maps currently in play. */
+	static TArray<ALedgeMapVolume*> ActiveLedgeMaps;
+};
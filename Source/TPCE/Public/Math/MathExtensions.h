@@ -87,6 +87,15 @@ struct FMathEx : public FMath
 	/** Interpolate from Current to Target using a spring-damper like function that does not overshoot. */
 	static TPCE_API FRotator RSmoothInterpTo(const FRotator& Current, const FRotator& Target, FRotator& CurrentVelocity, float SmoothTime, const FRotator& MaxSpeed, float DeltaTime);
 
+	/**
+	 * Solve the braking model dv/dt = -(Friction * v + Deceleration) in closed form for the time and distance it takes for Speed to drop to StopSpeed.
+	 * @return false if speed never reaches StopSpeed, ie. there is neither friction nor deceleration or only friction and StopSpeed is zero.
+	 */
+	static TPCE_API bool ComputeBrakingStop(const float Speed, const float Friction, const float Deceleration, const float StopSpeed, float& OutStopTime, float& OutStopDistance);
+
+	/** Evaluate the braking model dv/dt = -(Friction * v + Deceleration) at Time and return the distance travelled. Speed is clamped to zero. */
+	static TPCE_API float ComputeBrakingDistance(const float Speed, const float Friction, const float Deceleration, const float Time);
+
 	/** Find the cardinal direction for an angle given the current cardinal direction, the half angle width of the north segment and a buffer for tolerance */
 	static TPCE_API ECardinalDirection FindCardinalDirection(float Angle, const ECardinalDirection CurrentCardinalDirection, const float NorthSegmentHalfWidth = 60.f, const float Buffer = 5.0f);
 
@@ -34,7 +34,10 @@ public TPCE(ReadOnlyTargetRules Target) : base(Target)
 				// UI
 				"Slate",
 				"SlateCore",
-				"UMG"
+				"UMG",
+				"AIModule",
+				"AssetRegistry",
+				"EngineSettings"
             }
 		);
 	}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimGraphNodes/AnimGraphNode_DistanceMatching.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Animation/Skeleton.h"
+#include "Kismet2/CompilerResultsLog.h"
+
+#define LOCTEXT_NAMESPACE "TPCEAnimGraphNodes"
+
+UAnimGraphNode_DistanceMatching::UAnimGraphNode_DistanceMatching()
+{
+
+}
+
+FLinearColor UAnimGraphNode_DistanceMatching::GetNodeTitleColor() const
+{
+	return FLinearColor(0.1f, 0.5f, 0.75f);
+}
+
+FText UAnimGraphNode_DistanceMatching::GetTooltipText() const
+{
+	return LOCTEXT("DistanceMatchingTooltip", "Plays a sequence by matching its distance curve to the start, stop, pivot or landing distance of the character.");
+}
+
+FText UAnimGraphNode_DistanceMatching::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (Node.Sequence && TitleType != ENodeTitleType::ListView && TitleType != ENodeTitleType::MenuTitle)
+		return FText::Format(LOCTEXT("DistanceMatchingTitle", "Distance Matching\n{0}"), FText::FromString(Node.Sequence->GetName()));
+
+	return LOCTEXT("DistanceMatching", "Distance Matching");
+}
+
+FString UAnimGraphNode_DistanceMatching::GetNodeCategory() const
+{
+	return TEXT("CustomTools");
+}
+
+UAnimationAsset* UAnimGraphNode_DistanceMatching::GetAnimationAsset() const
+{
+	return Node.Sequence;
+}
+
+void UAnimGraphNode_DistanceMatching::PreloadRequiredAssets()
+{
+	PreloadObject(Node.Sequence);
+
+	Super::PreloadRequiredAssets();
+}
+
+void UAnimGraphNode_DistanceMatching::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	// The sequence may be provided through its pin
+	UEdGraphPin* SequencePin = FindPin(GET_MEMBER_NAME_STRING_CHECKED(FAnimNode_DistanceMatching, Sequence));
+	if (SequencePin && SequencePin->LinkedTo.Num() > 0)
+		return;
+
+	if (!Node.Sequence)
+	{
+		MessageLog.Error(TEXT("@@ references an unknown sequence"), this);
+	}
+	else if (Node.Sequence->GetSkeleton() && !Node.Sequence->GetSkeleton()->IsCompatible(ForSkeleton))
+	{
+		MessageLog.Error(TEXT("@@ references sequence that uses different skeleton @@"), this, Node.Sequence->GetSkeleton());
+	}
+	else if (!Node.Sequence->GetCurveData().FloatCurves.ContainsByPredicate([this](const FFloatCurve& Curve) { return Curve.Name.DisplayName == Node.DistanceCurveName; }))
+	{
+		MessageLog.Warning(*FString::Printf(TEXT("@@ sequence has no '%s' curve"), *Node.DistanceCurveName.ToString()), this);
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
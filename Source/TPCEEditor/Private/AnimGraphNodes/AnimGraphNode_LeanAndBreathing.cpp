@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimGraphNodes/AnimGraphNode_LeanAndBreathing.h"
+#include "Animation/Skeleton.h"
+#include "Kismet2/CompilerResultsLog.h"
+
+#define LOCTEXT_NAMESPACE "TPCEAnimGraphNodes"
+
+UAnimGraphNode_LeanAndBreathing::UAnimGraphNode_LeanAndBreathing()
+{
+
+}
+
+FText UAnimGraphNode_LeanAndBreathing::GetTooltipText() const
+{
+	return LOCTEXT("LeanAndBreathingTooltip", "Leans a pelvis and spine chain into the acceleration and turns of the character and adds breathing that follows its exertion.");
+}
+
+FLinearColor UAnimGraphNode_LeanAndBreathing::GetNodeTitleColor() const
+{
+	return FLinearColor(0.75f, 0.75f, 0.1f);
+}
+
+FText UAnimGraphNode_LeanAndBreathing::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return LOCTEXT("LeanAndBreathing", "Lean and Breathing");
+}
+
+void UAnimGraphNode_LeanAndBreathing::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	if (Node.Bones.Num() == 0)
+	{
+		MessageLog.Warning(TEXT("@@ has no bones to rotate"), this);
+		return;
+	}
+
+	// Bones must form a chain from root to tip
+	int32 LastBoneIndex = INDEX_NONE;
+	for (const FLeanAndBreathingBone& Each : Node.Bones)
+	{
+		const int32 BoneIndex = ForSkeleton ? ForSkeleton->GetReferenceSkeleton().FindBoneIndex(Each.Bone.BoneName) : INDEX_NONE;
+		if (BoneIndex == INDEX_NONE)
+		{
+			MessageLog.Warning(*FString::Printf(TEXT("@@ references unknown bone '%s'"), *Each.Bone.BoneName.ToString()), this);
+			return;
+		}
+
+		if (LastBoneIndex != INDEX_NONE && !ForSkeleton->GetReferenceSkeleton().BoneIsChildOf(BoneIndex, LastBoneIndex))
+		{
+			MessageLog.Warning(*FString::Printf(TEXT("@@ bone '%s' is not a child of the previous bone"), *Each.Bone.BoneName.ToString()), this);
+			return;
+		}
+
+		LastBoneIndex = BoneIndex;
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_AssetPlayerBase.h"
+#include "AnimNodes/AnimNode_DistanceMatching.h"
+
+#include "AnimGraphNode_DistanceMatching.generated.h"
+
+/**
+*
+*/
+UCLASS()
+class TPCEEDITOR_API UAnimGraphNode_DistanceMatching : public UAnimGraphNode_AssetPlayerBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FAnimNode_DistanceMatching Node;
+
+public:
+
+	UAnimGraphNode_DistanceMatching();
+
+	virtual FLinearColor GetNodeTitleColor() const override;
+	virtual FText GetTooltipText() const override;
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FString GetNodeCategory() const override;
+
+	virtual UAnimationAsset* GetAnimationAsset() const override;
+	virtual void PreloadRequiredAssets() override;
+	virtual void ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog) override;
+};
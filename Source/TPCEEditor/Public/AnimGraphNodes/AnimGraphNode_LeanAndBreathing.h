@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimNodes/AnimNode_LeanAndBreathing.h"
+#include "AnimGraphNode_SkeletalControlBase.h"
+
+#include "AnimGraphNode_LeanAndBreathing.generated.h"
+
+/**
+*
+*/
+UCLASS()
+class TPCEEDITOR_API UAnimGraphNode_LeanAndBreathing : public UAnimGraphNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FAnimNode_LeanAndBreathing Node;
+
+public:
+
+	UAnimGraphNode_LeanAndBreathing();
+
+	virtual FText GetTooltipText() const override;
+	virtual FLinearColor GetNodeTitleColor() const override;
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual void ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog) override;
+
+protected:
+
+	virtual const FAnimNode_SkeletalControlBase* GetNode() const override { return &Node; }
+};